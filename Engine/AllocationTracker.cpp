@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+#ifdef _MSC_VER
+	#include <malloc.h>
+#endif
+
+#include "AllocationTracker.h"
+
+namespace
+{
+	std::atomic<uint64_t> s_ProcessAllocations(0u);
+	std::atomic<uint64_t> s_ProcessBytes(0u);
+	thread_local uint64_t s_ThreadAllocations = 0u;
+	thread_local uint64_t s_ThreadBytes = 0u;
+
+	struct TagCounters
+	{
+		std::atomic<uint64_t> m_CurrentBytes{ 0u };
+		std::atomic<uint64_t> m_PeakBytes{ 0u };
+		std::atomic<uint64_t> m_Allocations{ 0u };
+		std::atomic<uint64_t> m_Frees{ 0u };
+		std::atomic<uint64_t> m_AllocatedBytes{ 0u };
+		std::atomic<uint64_t> m_Budget{ 0u };
+	};
+
+	TagCounters s_Tags[AllocationTracker::TagCount];
+	thread_local AllocationTracker::Tag s_ThreadTag = AllocationTracker::Tag::Untagged;
+
+	const char* const TagNames[AllocationTracker::TagCount] = { "untagged", "meshes", "textures", "pipeline", "sounds" };
+
+	void Count(size_t bytes)
+	{
+		s_ProcessAllocations.fetch_add(1u, std::memory_order_relaxed);
+		s_ProcessBytes.fetch_add(bytes, std::memory_order_relaxed);
+		s_ThreadAllocations++;
+		s_ThreadBytes += bytes;
+	}
+
+	void CountTag(AllocationTracker::Tag tag, size_t bytes)
+	{
+		TagCounters& counters = s_Tags[static_cast<size_t>(tag)];
+		counters.m_Allocations.fetch_add(1u, std::memory_order_relaxed);
+		counters.m_AllocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+		const uint64_t current = counters.m_CurrentBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		uint64_t peak = counters.m_PeakBytes.load(std::memory_order_relaxed);
+		while (current > peak && !counters.m_PeakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed)) { }
+	}
+
+	void UncountTag(AllocationTracker::Tag tag, size_t bytes)
+	{
+		TagCounters& counters = s_Tags[static_cast<size_t>(tag)];
+		counters.m_Frees.fetch_add(1u, std::memory_order_relaxed);
+		counters.m_CurrentBytes.fetch_sub(bytes, std::memory_order_relaxed);
+	}
+
+	std::string FormatBytes(uint64_t bytes)
+	{
+		std::ostringstream text;
+		text << std::fixed << std::setprecision(1);
+		if (bytes >= (1u << 20)) text << bytes / double(1u << 20) << " MiB";
+		else if (bytes >= (1u << 10)) text << bytes / double(1u << 10) << " KiB";
+		else text << bytes << " bytes";
+		return text.str();
+	}
+
+#ifndef ENGINE_NO_ALLOCATION_TRACKING
+	// Right in front of every allocation, so that a free knows what to take off which tag. It is 16 bytes,
+	// which keeps what follows it aligned for anything malloc aligns for; aligned allocations put it
+	// at the end of a whole alignment in front of the memory.
+	struct Header
+	{
+		uint64_t m_Bytes;
+		uint32_t m_Tag;
+		// From the start of the block to the memory handed out
+		uint32_t m_Offset;
+	};
+	static_assert(sizeof(Header) == 16u, "Header must keep allocations aligned");
+
+	Header* GetHeader(void* pMemory)
+	{
+		return static_cast<Header*>(pMemory) - 1;
+	}
+
+	void* Track(void* pBlock, size_t offset, size_t bytes, AllocationTracker::Tag tag)
+	{
+		void* pMemory = static_cast<char*>(pBlock) + offset;
+		Header* pHeader = GetHeader(pMemory);
+		pHeader->m_Bytes = bytes;
+		pHeader->m_Tag = static_cast<uint32_t>(tag);
+		pHeader->m_Offset = static_cast<uint32_t>(offset);
+
+		Count(bytes);
+		CountTag(tag, bytes);
+		return pMemory;
+	}
+
+	// Returns the block to give back to the allocator
+	void* Untrack(void* pMemory)
+	{
+		const Header* pHeader = GetHeader(pMemory);
+		UncountTag(static_cast<AllocationTracker::Tag>(pHeader->m_Tag), static_cast<size_t>(pHeader->m_Bytes));
+		return static_cast<char*>(pMemory) - pHeader->m_Offset;
+	}
+
+	void* AllocateTracked(size_t bytes, AllocationTracker::Tag tag)
+	{
+		void* pBlock = std::malloc(sizeof(Header) + bytes);
+		return pBlock != nullptr ? Track(pBlock, sizeof(Header), bytes, tag) : nullptr;
+	}
+#endif
+}
+
+AllocationTracker::Counts AllocationTracker::GetProcessCounts()
+{
+	return { s_ProcessAllocations.load(std::memory_order_relaxed), s_ProcessBytes.load(std::memory_order_relaxed) };
+}
+
+AllocationTracker::Counts AllocationTracker::GetThreadCounts()
+{
+	return { s_ThreadAllocations, s_ThreadBytes };
+}
+
+const char* AllocationTracker::GetTagName(Tag tag)
+{
+	return TagNames[static_cast<size_t>(tag)];
+}
+
+AllocationTracker::TagCounts AllocationTracker::GetTagCounts(Tag tag)
+{
+	const TagCounters& counters = s_Tags[static_cast<size_t>(tag)];
+
+	TagCounts counts;
+	counts.m_CurrentBytes = counters.m_CurrentBytes.load(std::memory_order_relaxed);
+	counts.m_PeakBytes = counters.m_PeakBytes.load(std::memory_order_relaxed);
+	counts.m_Allocations = counters.m_Allocations.load(std::memory_order_relaxed);
+	counts.m_Frees = counters.m_Frees.load(std::memory_order_relaxed);
+	counts.m_AllocatedBytes = counters.m_AllocatedBytes.load(std::memory_order_relaxed);
+	return counts;
+}
+
+AllocationTracker::TagSnapshot AllocationTracker::GetTagSnapshot()
+{
+	TagSnapshot snapshot;
+	for (size_t i = 0; i < TagCount; i++)
+	{
+		snapshot[i] = GetTagCounts(static_cast<Tag>(i));
+	}
+	return snapshot;
+}
+
+void AllocationTracker::ResetTagPeaks()
+{
+	for (TagCounters& counters : s_Tags)
+	{
+		counters.m_PeakBytes.store(counters.m_CurrentBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+}
+
+void AllocationTracker::SetTagBudget(Tag tag, uint64_t bytes)
+{
+	s_Tags[static_cast<size_t>(tag)].m_Budget.store(bytes, std::memory_order_relaxed);
+}
+
+uint64_t AllocationTracker::GetTagBudget(Tag tag)
+{
+	return s_Tags[static_cast<size_t>(tag)].m_Budget.load(std::memory_order_relaxed);
+}
+
+bool AllocationTracker::IsOverBudget(Tag tag)
+{
+	const uint64_t budget = GetTagBudget(tag);
+	return budget > 0u && GetTagCounts(tag).m_CurrentBytes > budget;
+}
+
+std::string AllocationTracker::GetTagReport(const TagSnapshot& since)
+{
+	const TagSnapshot now = GetTagSnapshot();
+
+	std::ostringstream report;
+	report << "Memory:";
+	for (size_t i = 0; i < TagCount; i++)
+	{
+		const Tag tag = static_cast<Tag>(i);
+		const TagCounts& counts = now[i];
+		const uint64_t budget = GetTagBudget(tag);
+
+		report << (i == 0 ? " " : "; ") << GetTagName(tag) << " " << FormatBytes(counts.m_CurrentBytes)
+			<< " (peak " << FormatBytes(counts.m_PeakBytes);
+		if (budget > 0u) report << ", budget " << FormatBytes(budget) << (counts.m_CurrentBytes > budget ? ", OVER BUDGET" : "");
+		report << "), " << counts.m_Allocations - since[i].m_Allocations << " allocations ("
+			<< FormatBytes(counts.m_AllocatedBytes - since[i].m_AllocatedBytes) << ") and "
+			<< counts.m_Frees - since[i].m_Frees << " frees";
+	}
+	report << "\n";
+
+	return report.str();
+}
+
+AllocationTracker::Tag AllocationTracker::SetThreadTag(Tag tag)
+{
+	const Tag previous = s_ThreadTag;
+	s_ThreadTag = tag;
+	return previous;
+}
+
+AllocationTracker::Tag AllocationTracker::GetThreadTag()
+{
+	return s_ThreadTag;
+}
+
+#ifndef ENGINE_NO_ALLOCATION_TRACKING
+
+void* AllocationTracker::Allocate(size_t bytes)
+{
+	return AllocateTracked(bytes, s_ThreadTag);
+}
+
+// Reallocations stay with the tag of the memory they grow
+void* AllocationTracker::Reallocate(void* pMemory, size_t bytes)
+{
+	if (pMemory == nullptr) return Allocate(bytes);
+
+	const Header* pHeader = GetHeader(pMemory);
+	void* pGrown = AllocateTracked(bytes, static_cast<Tag>(pHeader->m_Tag));
+	if (pGrown == nullptr) return nullptr;
+
+	std::memcpy(pGrown, pMemory, std::min<size_t>(bytes, static_cast<size_t>(pHeader->m_Bytes)));
+	Free(pMemory);
+	return pGrown;
+}
+
+void AllocationTracker::Free(void* pMemory)
+{
+	if (pMemory != nullptr) std::free(Untrack(pMemory));
+}
+
+// The plain and the aligned forms are replaced, the array and nothrow forms are specified to forward to them. The sized
+// deletes are replaced as well, a runtime may free with them directly and would miss the header in front of the memory.
+void* operator new(size_t bytes)
+{
+	void* pMemory = AllocateTracked(bytes, s_ThreadTag);
+	if (pMemory == nullptr) throw std::bad_alloc();
+	return pMemory;
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	AllocationTracker::Free(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+	::operator delete(pMemory);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment)
+{
+	// The header takes a whole alignment, and sizes are rounded up to the alignment, which aligned_alloc requires
+	const size_t alignmentBytes = std::max(static_cast<size_t>(alignment), sizeof(Header));
+	const size_t paddedBytes = alignmentBytes + ((std::max<size_t>(bytes, 1u) + alignmentBytes - 1u) & ~(alignmentBytes - 1u));
+#ifdef _MSC_VER
+	void* pBlock = _aligned_malloc(paddedBytes, alignmentBytes);
+#else
+	void* pBlock = std::aligned_alloc(alignmentBytes, paddedBytes);
+#endif
+	if (pBlock == nullptr) throw std::bad_alloc();
+	return Track(pBlock, alignmentBytes, bytes, s_ThreadTag);
+}
+
+void operator delete(void* pMemory, std::align_val_t) noexcept
+{
+	if (pMemory == nullptr) return;
+
+	void* pBlock = Untrack(pMemory);
+#ifdef _MSC_VER
+	_aligned_free(pBlock);
+#else
+	std::free(pBlock);
+#endif
+}
+
+void operator delete(void* pMemory, size_t, std::align_val_t alignment) noexcept
+{
+	::operator delete(pMemory, alignment);
+}
+
+#else
+
+void* AllocationTracker::Allocate(size_t bytes)
+{
+	return std::malloc(bytes);
+}
+
+void* AllocationTracker::Reallocate(void* pMemory, size_t bytes)
+{
+	return std::realloc(pMemory, bytes);
+}
+
+void AllocationTracker::Free(void* pMemory)
+{
+	std::free(pMemory);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Counts heap allocations made through operator new, which the engine replaces for that purpose.
+// Every thread has counters of its own besides the process wide ones, so work on the loading threads
+// doesn't show up in a frame measured on the main thread. Define ENGINE_NO_ALLOCATION_TRACKING to keep
+// the default operator new, all counts are zero then.
+class AllocationTracker
+{
+public:
+	struct Counts
+	{
+		uint64_t m_Allocations = 0;
+		uint64_t m_Bytes = 0;
+	};
+
+	static Counts GetProcessCounts();
+	static Counts GetThreadCounts();
+
+	// Allocations the calling thread made since the scope was created
+	class Scope
+	{
+	public:
+		Scope() : m_Start(GetThreadCounts()) { }
+
+		Counts Get() const
+		{
+			const Counts now = GetThreadCounts();
+			return { now.m_Allocations - m_Start.m_Allocations, now.m_Bytes - m_Start.m_Bytes };
+		}
+
+	private:
+		Counts m_Start;
+	};
+
+	// Subsystem an allocation is charged to, whatever thread makes it and whatever thread frees it
+	enum class Tag : uint8_t
+	{
+		Untagged,
+		// Mesh data and the vertex inputs scenes build from it
+		Meshes,
+		// Texels, including what the image decoder allocates
+		Textures,
+		// Depth buffers, render targets, bound vertices and the frame arena
+		Pipeline,
+		// Decoded sample data
+		Sounds,
+		Count
+	};
+
+	static constexpr size_t TagCount = static_cast<size_t>(Tag::Count);
+
+	struct TagCounts
+	{
+		// Live now, and the most that was live at once since the last ResetTagPeaks
+		uint64_t m_CurrentBytes = 0;
+		uint64_t m_PeakBytes = 0;
+		// Totals since startup, take the difference of two snapshots for a frame
+		uint64_t m_Allocations = 0;
+		uint64_t m_Frees = 0;
+		uint64_t m_AllocatedBytes = 0;
+	};
+
+	typedef std::array<TagCounts, TagCount> TagSnapshot;
+
+	static const char* GetTagName(Tag tag);
+	static TagCounts GetTagCounts(Tag tag);
+	static TagSnapshot GetTagSnapshot();
+	static void ResetTagPeaks();
+
+	// Reports flag tags with more live bytes than the budget, zero for none
+	static void SetTagBudget(Tag tag, uint64_t bytes);
+	static uint64_t GetTagBudget(Tag tag);
+	static bool IsOverBudget(Tag tag);
+
+	// Live and peak bytes of every tag, and what was allocated and freed since the snapshot
+	static std::string GetTagReport(const TagSnapshot& since);
+
+	// Allocations of the calling thread are charged to the tag until the scope ends, scopes nest
+	class TagScope
+	{
+	public:
+		explicit TagScope(Tag tag) : m_Previous(SetThreadTag(tag)) { }
+		~TagScope() { SetThreadTag(m_Previous); }
+		TagScope(const TagScope&) = delete;
+		TagScope& operator=(const TagScope&) = delete;
+
+	private:
+		Tag m_Previous;
+	};
+
+	// Returns the previous tag
+	static Tag SetThreadTag(Tag tag);
+	static Tag GetThreadTag();
+
+	// malloc, realloc and free with the same accounting as operator new, for C libraries that let us
+	// replace their allocator. Memory from Allocate must only be given to Reallocate and Free.
+	static void* Allocate(size_t bytes);
+	static void* Reallocate(void* pMemory, size_t bytes);
+	static void Free(void* pMemory);
+};
\ No newline at end of file
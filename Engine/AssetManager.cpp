@@ -0,0 +1,298 @@
+#include <iomanip>
+#include <sstream>
+
+#include "AssetManager.h"
+
+namespace
+{
+	std::shared_ptr<const Mesh> LoadMeshFromFile(const std::string& path, bool& fromDiskCache)
+	{
+		fromDiskCache = false;
+
+		auto pMesh = std::make_shared<Mesh>();
+		return pMesh->Load(path) ? std::move(pMesh) : nullptr;
+	}
+
+	std::shared_ptr<const Texture> LoadTextureFromFile(const std::string& path, Texture::Format format, TextureCache* pTextureCache, JobSystem* pJobs, bool& fromDiskCache)
+	{
+		auto pTexture = std::make_shared<Texture>();
+		if (pTextureCache != nullptr)
+		{
+			fromDiskCache = pTextureCache->Load(path, format, *pTexture, pJobs);
+		}
+		else
+		{
+			fromDiskCache = false;
+			pTexture->Load(path, format, pJobs);
+		}
+
+		return pTexture->IsLoaded() ? std::move(pTexture) : nullptr;
+	}
+}
+
+AssetManager::AssetManager(size_t memoryBudgetBytes, int loadingThreadCount)
+	:
+	m_MemoryBudgetBytes(memoryBudgetBytes),
+	m_LoadingPool(loadingThreadCount)
+{
+	static constexpr int PlaceholderSize = 8;
+	unsigned char texels[PlaceholderSize * PlaceholderSize * 3];
+	for (int i = 0; i < PlaceholderSize * PlaceholderSize; i++)
+	{
+		const unsigned char value = ((i % PlaceholderSize) + (i / PlaceholderSize)) % 2 == 0 ? 255u : 160u;
+		texels[i * 3] = texels[i * 3 + 1] = texels[i * 3 + 2] = value;
+	}
+
+	auto pPlaceholder = std::make_shared<Texture>();
+	pPlaceholder->Create(texels, PlaceholderSize, PlaceholderSize);
+	m_pPlaceholderTexture = std::move(pPlaceholder);
+}
+
+std::shared_ptr<const Mesh> AssetManager::LoadMesh(const std::string& path)
+{
+	return Request(m_Meshes, path, [path](bool& fromDiskCache) { return LoadMeshFromFile(path, fromDiskCache); }, false).Wait();
+}
+
+std::shared_ptr<const Texture> AssetManager::LoadTexture(const std::string& path, Texture::Format format)
+{
+	return RequestTexture(path, format, false).Wait();
+}
+
+AssetFuture<Mesh> AssetManager::LoadMeshAsync(const std::string& path)
+{
+	return Request(m_Meshes, path, [path](bool& fromDiskCache) { return LoadMeshFromFile(path, fromDiskCache); }, true);
+}
+
+AssetFuture<Texture> AssetManager::LoadTextureAsync(const std::string& path, Texture::Format format)
+{
+	return RequestTexture(path, format, true);
+}
+
+AssetFuture<Texture> AssetManager::RequestTexture(const std::string& path, Texture::Format format, bool async)
+{
+	// The task keeps the disk cache alive even if it is replaced while the load is queued
+	std::shared_ptr<TextureCache> pTextureCache;
+	JobSystem* pJobs;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		pTextureCache = m_pTextureCache;
+		pJobs = m_pJobs;
+	}
+
+	return Request(m_Textures, GetTextureKey(path, format), [path, format, pTextureCache, pJobs](bool& fromDiskCache)
+	{
+		return LoadTextureFromFile(path, format, pTextureCache.get(), pJobs, fromDiskCache);
+	}, async);
+}
+
+void AssetManager::SetJobSystem(JobSystem* pJobs)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_pJobs = pJobs;
+}
+
+void AssetManager::SetTextureCacheDirectory(const std::string& directory)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_pTextureCache = directory.empty() ? nullptr : std::make_shared<TextureCache>(directory);
+}
+
+void AssetManager::SetMemoryBudget(size_t memoryBudgetBytes)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_MemoryBudgetBytes = memoryBudgetBytes;
+	EvictUntil(m_MemoryBudgetBytes);
+}
+
+size_t AssetManager::GetMemoryBudget() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_MemoryBudgetBytes;
+}
+
+size_t AssetManager::GetMemoryBytes() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_MemoryBytes;
+}
+
+void AssetManager::EvictUnreferenced()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	EvictUntil(0u);
+}
+
+AssetManager::Stats AssetManager::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Stats;
+}
+
+std::string AssetManager::GetReport() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	std::ostringstream report;
+	report << "Assets:\n";
+
+	auto reportCache = [&report](const auto& cache)
+	{
+		for (const auto& [key, entry] : cache.m_Entries)
+		{
+			// The cache itself holds one of the references
+			report << "  " << std::left << std::setw(40) << key << std::right << std::fixed << std::setprecision(1)
+				<< std::setw(8) << entry.m_MemoryBytes / 1024 << " KiB, " << (entry.m_FromDiskCache ? "read from the disk cache" : "loaded")
+				<< " in " << entry.m_LoadMilliseconds << " ms, "
+				<< entry.m_pAsset.use_count() - 1 << " handles\n";
+		}
+		for (const auto& pending : cache.m_Pending)
+		{
+			report << "  " << std::left << std::setw(40) << pending.first << std::right << "  loading\n";
+		}
+	};
+	reportCache(m_Meshes);
+	reportCache(m_Textures);
+
+	report << "  " << m_MemoryBytes / 1024 << " KiB of " << m_MemoryBudgetBytes / 1024 << " KiB budget, "
+		<< m_Stats.m_Hits << " hits, " << m_Stats.m_Misses << " misses, " << m_Stats.m_Evictions << " evictions\n"
+		<< "  (Assets with no handles can be evicted, even while futures of them are kept once they handed out one)\n";
+	if (m_pTextureCache != nullptr)
+	{
+		const TextureCache::Stats diskStats = m_pTextureCache->GetStats();
+		report << "  Disk cache " << m_pTextureCache->GetDirectory() << ": " << diskStats.m_Hits << " hits, " << diskStats.m_Misses << " misses\n";
+	}
+	return report.str();
+}
+
+template <class TAsset, class TLoad>
+AssetFuture<TAsset> AssetManager::Request(Cache<TAsset>& cache, const std::string& key, TLoad load, bool async)
+{
+	typedef std::shared_ptr<const TAsset> Handle;
+	// Futures only refer to the asset, so that keeping one around doesn't pin it in the cache. Until the first
+	// handle is taken, the pin of the request holds the asset instead.
+	typedef std::weak_ptr<const TAsset> Reference;
+
+	auto pPin = std::make_shared<AssetPin<TAsset>>();
+	auto pPromise = std::make_shared<std::promise<Reference>>();
+	std::shared_future<Reference> future;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		const auto entry = cache.m_Entries.find(key);
+		if (entry != cache.m_Entries.end())
+		{
+			m_Stats.m_Hits++;
+			entry->second.m_LastUse = ++m_UseCounter;
+			pPin->m_pAsset = entry->second.m_pAsset;
+			pPromise->set_value(entry->second.m_pAsset);
+			return AssetFuture<TAsset>(pPromise->get_future().share(), std::move(pPin));
+		}
+
+		const auto pending = cache.m_Pending.find(key);
+		if (pending != cache.m_Pending.end())
+		{
+			m_Stats.m_Hits++;
+			pending->second.m_Pins.push_back(pPin);
+			return AssetFuture<TAsset>(pending->second.m_Future, std::move(pPin));
+		}
+
+		m_Stats.m_Misses++;
+		future = pPromise->get_future().share();
+		cache.m_Pending[key] = { future, { pPin } };
+	}
+
+	auto task = [this, &cache, key, load, pPromise]()
+	{
+		const auto start = std::chrono::steady_clock::now();
+		bool fromDiskCache = false;
+		Handle pAsset = load(fromDiskCache);
+		const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			const auto pending = cache.m_Pending.find(key);
+
+			if (pAsset != nullptr)
+			{
+				// Room is made before the new asset counts, and the pins hold it from the moment it does,
+				// so it can't be evicted before the requests take their handles
+				const size_t memoryBytes = pAsset->GetMemoryBytes();
+				if (m_MemoryBytes + memoryBytes > m_MemoryBudgetBytes)
+				{
+					EvictUntil(m_MemoryBudgetBytes > memoryBytes ? m_MemoryBudgetBytes - memoryBytes : 0u);
+				}
+
+				cache.m_Entries[key] = { pAsset, memoryBytes, elapsed.count(), fromDiskCache, ++m_UseCounter };
+				m_MemoryBytes += memoryBytes;
+
+				for (const auto& pPendingPin : pending->second.m_Pins)
+				{
+					std::lock_guard<std::mutex> pinLock(pPendingPin->m_Mutex);
+					pPendingPin->m_pAsset = pAsset;
+				}
+			}
+
+			cache.m_Pending.erase(pending);
+		}
+
+		pPromise->set_value(pAsset);
+	};
+
+	if (async)
+		m_LoadingPool.Submit(std::move(task));
+	else
+		task();
+
+	return AssetFuture<TAsset>(future, std::move(pPin));
+}
+
+void AssetManager::EvictUntil(size_t memoryBytes)
+{
+	while (m_MemoryBytes > memoryBytes)
+	{
+		// Least recently used unreferenced asset of either kind, caches hold a handful of entries so a scan is fine
+		uint64_t oldestUse = UINT64_MAX;
+		auto oldestMesh = m_Meshes.m_Entries.end();
+		auto oldestTexture = m_Textures.m_Entries.end();
+		for (auto it = m_Meshes.m_Entries.begin(); it != m_Meshes.m_Entries.end(); ++it)
+		{
+			if (it->second.m_pAsset.use_count() > 1 || it->second.m_LastUse >= oldestUse) continue;
+			oldestUse = it->second.m_LastUse;
+			oldestMesh = it;
+		}
+		for (auto it = m_Textures.m_Entries.begin(); it != m_Textures.m_Entries.end(); ++it)
+		{
+			if (it->second.m_pAsset.use_count() > 1 || it->second.m_LastUse >= oldestUse) continue;
+			oldestUse = it->second.m_LastUse;
+			oldestTexture = it;
+			oldestMesh = m_Meshes.m_Entries.end();
+		}
+
+		if (oldestTexture != m_Textures.m_Entries.end())
+		{
+			m_MemoryBytes -= oldestTexture->second.m_MemoryBytes;
+			m_Textures.m_Entries.erase(oldestTexture);
+		}
+		else if (oldestMesh != m_Meshes.m_Entries.end())
+		{
+			m_MemoryBytes -= oldestMesh->second.m_MemoryBytes;
+			m_Meshes.m_Entries.erase(oldestMesh);
+		}
+		else
+		{
+			return;
+		}
+
+		m_Stats.m_Evictions++;
+	}
+}
+
+std::string AssetManager::GetTextureKey(const std::string& path, Texture::Format format)
+{
+	switch (format)
+	{
+	case Texture::Format::RGBX8Tiled: return path + " (RGBX8 tiled)";
+	case Texture::Format::BC1: return path + " (BC1)";
+	default: return path + " (RGB8)";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "Texture.h"
+#include "TextureCache.h"
+#include "ThreadPool.h"
+
+// Holds the asset for an AssetFuture from the end of its load until the first Get or Wait takes it
+template <class TAsset>
+struct AssetPin
+{
+	std::mutex m_Mutex;
+	std::shared_ptr<const TAsset> m_pAsset;
+};
+
+// Handle to an asset that is loaded in the background. Copies refer to the same load.
+// A future keeps the asset cached only until the first Get or Wait of it (or of a copy) has taken a handle, from then
+// on only the handles do. An asset whose handles were all released can be evicted when the cache goes over its budget,
+// even while futures of it are kept.
+template <class TAsset>
+class AssetFuture
+{
+public:
+	AssetFuture() = default;
+	AssetFuture(std::shared_future<std::weak_ptr<const TAsset>> future, std::shared_ptr<AssetPin<TAsset>> pPin)
+		:
+		m_Future(std::move(future)),
+		m_pPin(std::move(pPin))
+	{
+	}
+
+	// False for a default constructed handle, which never becomes ready
+	bool IsValid() const { return m_Future.valid(); }
+	bool IsReady() const { return m_Future.valid() && m_Future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+	// Never blocks, nullptr while the load is running, when it failed, and when the asset was evicted after the
+	// first handle was taken and released
+	std::shared_ptr<const TAsset> Get() const { return IsReady() ? Take() : nullptr; }
+	// Blocks until the load is done, nullptr when it failed or the asset was evicted after the first handle was released
+	std::shared_ptr<const TAsset> Wait() const
+	{
+		m_Future.wait();
+		return Take();
+	}
+
+private:
+	std::shared_ptr<const TAsset> Take() const
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_pPin->m_Mutex);
+			if (m_pPin->m_pAsset != nullptr) return std::move(m_pPin->m_pAsset);
+		}
+		return m_Future.get().lock();
+	}
+
+	std::shared_future<std::weak_ptr<const TAsset>> m_Future;
+	std::shared_ptr<AssetPin<TAsset>> m_pPin;
+};
+
+// Cache of the meshes and textures loaded from disk, keyed by path (and format for textures).
+// Loading a path that is already cached returns the same shared immutable instance, so entities and pipelines
+// drawing the same model or texture never hold more than one copy of it. Assets stay cached after their last
+// handle is released, until the memory of the cache goes over the budget: unreferenced ones are evicted then,
+// least recently loaded first. Referenced assets are never evicted, they can keep the cache over budget. The handles
+// taken from an AssetFuture reference an asset, and so does every future until its first handle was taken.
+//
+// The Async loads parse and decode on a pool of loading threads and return right away. Requests for an asset
+// that is still loading share that load instead of starting another one. All member functions are thread safe.
+class AssetManager
+{
+public:
+	struct Stats
+	{
+		size_t m_Hits = 0;
+		size_t m_Misses = 0;
+		size_t m_Evictions = 0;
+	};
+
+	explicit AssetManager(size_t memoryBudgetBytes = DefaultMemoryBudgetBytes, int loadingThreadCount = ThreadPool::DefaultThreadCount());
+
+	// Return nullptr when the file can't be read, failed loads are not cached
+	std::shared_ptr<const Mesh> LoadMesh(const std::string& path);
+	std::shared_ptr<const Texture> LoadTexture(const std::string& path, Texture::Format format = Texture::Format::RGB8);
+
+	// Already ready when the asset is cached
+	AssetFuture<Mesh> LoadMeshAsync(const std::string& path);
+	AssetFuture<Texture> LoadTextureAsync(const std::string& path, Texture::Format format = Texture::Format::RGB8);
+
+	// Decoded textures are kept in the directory and read back from there by later loads, even in later runs.
+	// Empty (the default) turns the disk cache off.
+	void SetTextureCacheDirectory(const std::string& directory);
+
+	// Loads started afterwards split texture compression into jobs, the job system has to outlive the manager.
+	// nullptr (the default) compresses on the loading thread alone.
+	void SetJobSystem(JobSystem* pJobs);
+
+	// Small checkerboard to draw with while the actual texture is loading
+	const std::shared_ptr<const Texture>& GetPlaceholderTexture() const { return m_pPlaceholderTexture; }
+
+	void SetMemoryBudget(size_t memoryBudgetBytes);
+	size_t GetMemoryBudget() const;
+	// Bytes of every cached asset, referenced or not
+	size_t GetMemoryBytes() const;
+
+	// Drops every asset nothing references any more, regardless of the budget
+	void EvictUnreferenced();
+
+	Stats GetStats() const;
+	// One line per cached asset with its memory, load time and number of handles taken from futures, then the totals
+	// and the disk cache hits
+	std::string GetReport() const;
+
+	static constexpr size_t DefaultMemoryBudgetBytes = 256u * 1024u * 1024u;
+
+private:
+	template <class TAsset>
+	struct Entry
+	{
+		std::shared_ptr<const TAsset> m_pAsset;
+		size_t m_MemoryBytes;
+		float m_LoadMilliseconds;
+		bool m_FromDiskCache;
+		uint64_t m_LastUse;
+	};
+
+	// A load that is running, with the pins of every request for it, which get the asset when it is cached
+	template <class TAsset>
+	struct Pending
+	{
+		std::shared_future<std::weak_ptr<const TAsset>> m_Future;
+		std::vector<std::shared_ptr<AssetPin<TAsset>>> m_Pins;
+	};
+
+	template <class TAsset>
+	struct Cache
+	{
+		std::unordered_map<std::string, Entry<TAsset>> m_Entries;
+		std::unordered_map<std::string, Pending<TAsset>> m_Pending;
+	};
+
+	// Looks the key up in the cache and in the loads that are running, otherwise runs load(fromDiskCache)
+	// on this thread or the loading threads and caches what it returns
+	template <class TAsset, class TLoad>
+	AssetFuture<TAsset> Request(Cache<TAsset>& cache, const std::string& key, TLoad load, bool async);
+
+	// Goes through the disk cache when there is one
+	AssetFuture<Texture> RequestTexture(const std::string& path, Texture::Format format, bool async);
+
+	// Evicts unreferenced assets, oldest first, until the cache fits in memoryBytes or only referenced ones are left.
+	// Expects the mutex to be locked.
+	void EvictUntil(size_t memoryBytes);
+
+	static std::string GetTextureKey(const std::string& path, Texture::Format format);
+
+	mutable std::mutex m_Mutex;
+
+	Cache<Mesh> m_Meshes;
+	Cache<Texture> m_Textures;
+
+	size_t m_MemoryBudgetBytes;
+	size_t m_MemoryBytes = 0;
+	uint64_t m_UseCounter = 0;
+	Stats m_Stats;
+
+	std::shared_ptr<const Texture> m_pPlaceholderTexture;
+	std::shared_ptr<TextureCache> m_pTextureCache;
+	JobSystem* m_pJobs = nullptr;
+
+	// Last, so that loads still queued finish while the caches they write to are alive
+	ThreadPool m_LoadingPool;
+};
\ No newline at end of file
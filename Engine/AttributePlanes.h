@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Vec3.h"
+
+// Screen space plane equations of every component of a triangle's vertices, set up once per triangle.
+// Vertices come in after the perspective divide (attributes over w, 1 / w in the position's w), so every
+// component is affine in screen space and any pixel can be evaluated directly from the reference vertex
+// and the two gradients, no matter where traversal starts. Values and gradients are stored as arrays of
+// floats, one entry per component, so evaluating a whole fragment is a flat loop over all of them.
+template <class TVertex>
+class AttributePlanes
+{
+public:
+	static constexpr size_t ComponentCount = TVertex::ComponentCount;
+
+	// Returns false for triangles without area, they have no planes and cover no pixels
+	bool Setup(const TVertex& v1, const TVertex& v2, const TVertex& v3)
+	{
+		float components1[ComponentCount];
+		float components2[ComponentCount];
+		float components3[ComponentCount];
+		v1.ToComponents(components1);
+		v2.ToComponents(components2);
+		v3.ToComponents(components3);
+
+		const float deltaX2 = v2.m_Position.x - v1.m_Position.x;
+		const float deltaY2 = v2.m_Position.y - v1.m_Position.y;
+		const float deltaX3 = v3.m_Position.x - v1.m_Position.x;
+		const float deltaY3 = v3.m_Position.y - v1.m_Position.y;
+
+		const float area = deltaX2 * deltaY3 - deltaX3 * deltaY2;
+		if (area == 0.0f) return false;
+		const float areaInverse = 1.0f / area;
+
+		m_ReferenceX = v1.m_Position.x;
+		m_ReferenceY = v1.m_Position.y;
+
+		for (size_t i = 0; i < ComponentCount; i++)
+		{
+			const float delta2 = components2[i] - components1[i];
+			const float delta3 = components3[i] - components1[i];
+
+			m_Reference[i] = components1[i];
+			m_GradientX[i] = (delta2 * deltaY3 - delta3 * deltaY2) * areaInverse;
+			m_GradientY[i] = (delta3 * deltaX2 - delta2 * deltaX3) * areaInverse;
+		}
+
+		return true;
+	}
+
+	// Same planes straight from clip space vertices, for the homogeneous rasterizer. The edge functions
+	// e(x, y) = edge.x * x + edge.y * y + edge.z give barycentric coordinate / w of their vertex at a screen
+	// position, so weighting the undivided components with them yields the same divided values as Setup.
+	void SetupHomogeneous(const TVertex& v1, const TVertex& v2, const TVertex& v3, const Vec3 (&edges)[3])
+	{
+		float components[3][ComponentCount];
+		v1.ToComponents(components[0]);
+		v2.ToComponents(components[1]);
+		v3.ToComponents(components[2]);
+
+		m_ReferenceX = 0.0f;
+		m_ReferenceY = 0.0f;
+
+		for (size_t i = 0; i < ComponentCount; i++)
+		{
+			m_Reference[i] = 0.0f;
+			m_GradientX[i] = 0.0f;
+			m_GradientY[i] = 0.0f;
+
+			for (int vertex = 0; vertex < 3; vertex++)
+			{
+				// Weighting w with 1 gives the planes 1 / w, the value the divide by w leaves in it
+				const float value = i == TVertex::PositionW ? 1.0f : components[vertex][i];
+
+				m_Reference[i] += edges[vertex].z * value;
+				m_GradientX[i] += edges[vertex].x * value;
+				m_GradientY[i] += edges[vertex].y * value;
+			}
+		}
+	}
+
+	float Evaluate(size_t component, float x, float y) const
+	{
+		return m_Reference[component] + m_GradientX[component] * (x - m_ReferenceX) + m_GradientY[component] * (y - m_ReferenceY);
+	}
+
+	// All components at the point with the divide by w undone, the values the pixel shader sees
+	void EvaluatePerspectiveCorrect(float x, float y, float* pOut) const
+	{
+		const float offsetX = x - m_ReferenceX;
+		const float offsetY = y - m_ReferenceY;
+		const float w = 1.0f / (m_Reference[TVertex::PositionW] + m_GradientX[TVertex::PositionW] * offsetX + m_GradientY[TVertex::PositionW] * offsetY);
+
+		for (size_t i = 0; i < ComponentCount; i++)
+		{
+			pOut[i] = (m_Reference[i] + m_GradientX[i] * offsetX + m_GradientY[i] * offsetY) * w;
+		}
+	}
+
+	float GetGradientX(size_t component) const { return m_GradientX[component]; }
+	float GetGradientY(size_t component) const { return m_GradientY[component]; }
+
+private:
+	float m_ReferenceX = 0.0f;
+	float m_ReferenceY = 0.0f;
+
+	float m_Reference[ComponentCount] = {};
+	float m_GradientX[ComponentCount] = {};
+	float m_GradientY[ComponentCount] = {};
+};
\ No newline at end of file
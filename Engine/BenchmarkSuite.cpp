@@ -0,0 +1,629 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#include "BenchmarkSuite.h"
+#include "CommandBenchmark.h"
+#include "DepthOnlyShaderProgram.h"
+#include "GraphicsPipeline.h"
+#include "JobBenchmark.h"
+#include "JobSystem.h"
+#include "MathBenchmark.h"
+#include "Mesh.h"
+#include "ShadowMap.h"
+#include "StaticBatch.h"
+#include "StressScene.h"
+#include "TextureBenchmark.h"
+#include "TexturedDirectionalLightningShaderProgram.h"
+#include "VertexBenchmark.h"
+
+namespace
+{
+	typedef TexturedDirectionalLightningShaderProgram Program;
+	typedef UnshadowedTexturedDirectionalLightningShaderProgram UnshadowedProgram;
+
+	// Unit sphere, a vertex per ring and segment crossing and two triangles per quad between them
+	void CreateSphere(int rings, int segments, std::vector<Vec3>& vertices, std::vector<size_t>& indices)
+	{
+		for (int ring = 0; ring <= rings; ring++)
+		{
+			const float theta = static_cast<float>(M_PI) * ring / rings;
+			for (int segment = 0; segment <= segments; segment++)
+			{
+				const float phi = 2.0f * static_cast<float>(M_PI) * segment / segments;
+				vertices.emplace_back(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			}
+		}
+		for (int ring = 0; ring < rings; ring++)
+		{
+			for (int segment = 0; segment < segments; segment++)
+			{
+				const size_t first = static_cast<size_t>(ring) * (segments + 1) + segment;
+				const size_t below = first + segments + 1;
+				indices.insert(indices.end(), { first, below, first + 1, first + 1, below, below + 1 });
+			}
+		}
+	}
+
+	std::vector<Program::VSIn> CreateInput(const Mesh& mesh)
+	{
+		std::vector<Program::VSIn> input;
+		for (size_t i = 0; i < mesh.GetVertices().size(); i++)
+		{
+			input.push_back({ mesh.GetVertices()[i], mesh.GetNormals()[i], mesh.GetUvCoordinates()[i] });
+		}
+		return input;
+	}
+
+	void BenchmarkLoading(int repetitions)
+	{
+		using namespace Benchmarking;
+		s_ResultGroup = "load";
+
+		for (const char* path : BenchmarkSuite::ModelPaths)
+		{
+			Mesh mesh;
+			const double loadMs = MeasureNanoseconds(repetitions, 1, [&]() { mesh.Load(path); }) / 1.0e6;
+
+			// Per MiB as well, models of different sizes compare
+			std::error_code error;
+			const double mebibytes = std::filesystem::file_size(path, error) / (1024.0 * 1024.0);
+			AddResult(std::string(path) + " ms", loadMs, "ms");
+			if (!error && mebibytes > 0.0) AddResult(std::string(path) + " ms per MiB", loadMs / mebibytes, "ms");
+		}
+	}
+
+	void BenchmarkVertices(Graphics& graphics, JobSystem& jobs, int repetitions)
+	{
+		using namespace Benchmarking;
+		s_ResultGroup = "vertex";
+
+		// Behind the camera, nothing but vertex shading and triangle assembly is left
+		std::vector<Vec3> vertices;
+		std::vector<size_t> indices;
+		CreateSphere(256, 512, vertices, indices);
+		const Mat4 projection = Mat4::PerspectiveProjection(0.1f, 100.0f, 1.57f, 1.0f);
+		const Mat4 view = Mat4::Translate(0.0f, 0.0f, 3.0f);
+
+		GraphicsPipeline<DepthOnlyShaderProgram> depthPipeline(graphics, 512, 512);
+		depthPipeline.BindVertices(vertices);
+		depthPipeline.BindIndices(indices);
+		depthPipeline.GetVertexShader().SetMVP(projection * view);
+
+		std::vector<Program::VSIn> texturedVertices;
+		for (const Vec3& vertex : vertices) texturedVertices.push_back({ vertex, vertex, Vec2(0.0f, 0.0f) });
+		GraphicsPipeline<Program> texturedPipeline(graphics);
+		texturedPipeline.BindVertices(texturedVertices);
+		texturedPipeline.BindIndices(indices);
+		texturedPipeline.GetVertexShader().SetMVP(projection * view);
+		texturedPipeline.GetVertexShader().SetMV(view);
+		texturedPipeline.GetVertexShader().SetP(projection);
+
+		auto measure = [&](auto& pipeline, JobSystem* pJobs)
+		{
+			pipeline.SetJobSystem(pJobs);
+			return MeasureNanoseconds(repetitions, static_cast<int>(vertices.size()), [&]() { pipeline.Draw(); });
+		};
+
+		AddResult("depth only ns per vertex", measure(depthPipeline, nullptr), "ns");
+		AddResult("depth only ns per vertex, job system", measure(depthPipeline, &jobs), "ns");
+		AddResult("textured ns per vertex", measure(texturedPipeline, nullptr), "ns");
+		AddResult("textured ns per vertex, job system", measure(texturedPipeline, &jobs), "ns");
+	}
+
+	void BenchmarkClipping(Graphics& graphics, int repetitions)
+	{
+		using namespace Benchmarking;
+		s_ResultGroup = "clip";
+
+		// Triangles of about a pixel spread over the view, every one reaching from in front of the near plane (at 0.1)
+		// to behind it, so clipping and not filling is what they cost. The same triangles moved past the near plane
+		// give the cost without clipping.
+		constexpr int TriangleCount = 100000;
+		std::mt19937 random(1234u);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+		std::vector<Vec3> vertices;
+		std::vector<size_t> indices;
+		for (int i = 0; i < TriangleCount; i++)
+		{
+			const float x = distribution(random) * 0.09f;
+			const float y = distribution(random) * 0.09f;
+			vertices.insert(vertices.end(), { Vec3(x, y, -0.095f), Vec3(x + 0.0005f, y, -0.105f), Vec3(x, y + 0.0005f, -0.105f) });
+			indices.insert(indices.end(), { 3u * i, 3u * i + 1u, 3u * i + 2u });
+		}
+
+		GraphicsPipeline<DepthOnlyShaderProgram> pipeline(graphics, 512, 512);
+		pipeline.BindVertices(vertices);
+		pipeline.BindIndices(indices);
+		const Mat4 projection = Mat4::PerspectiveProjection(0.1f, 100.0f, 1.57f, 1.0f);
+
+		auto measure = [&](const Mat4& view)
+		{
+			pipeline.GetVertexShader().SetMVP(projection * view);
+			return MeasureNanoseconds(repetitions, TriangleCount, [&]()
+			{
+				pipeline.ClearZBuffer();
+				pipeline.Draw();
+			});
+		};
+
+		AddResult("ns per triangle crossing the near plane", measure(Mat4::Identity()), "ns");
+		AddResult("ns per triangle in front", measure(Mat4::Translate(0.0f, 0.0f, -0.01f)), "ns");
+	}
+
+	void BenchmarkFillRate(Graphics& graphics, const std::shared_ptr<const Texture>& pTexture, int repetitions)
+	{
+		using namespace Benchmarking;
+		s_ResultGroup = "fill";
+
+		// The screen tiled with square pairs of triangles of each size, given in clip space so every pixel is drawn once
+		GraphicsPipeline<UnshadowedProgram> pipeline(graphics);
+		pipeline.BindTexture(pTexture);
+		pipeline.GetVertexShader().SetMVP(Mat4::Identity());
+		pipeline.GetVertexShader().SetMV(Mat4::Identity());
+		pipeline.GetVertexShader().SetP(Mat4::Identity());
+		const int pixelCount = Graphics::ScreenWidth * Graphics::ScreenHeight;
+
+		for (int size : { 2, 8, 32, 128 })
+		{
+			std::vector<UnshadowedProgram::VSIn> vertices;
+			std::vector<size_t> indices;
+			const Vec3 normal(0.0f, 0.0f, -1.0f);
+			for (int y = 0; y < Graphics::ScreenHeight; y += size)
+			{
+				for (int x = 0; x < Graphics::ScreenWidth; x += size)
+				{
+					auto toClip = [](int pixel, int extent) { return 2.0f * pixel / extent - 1.0f; };
+					const float left = toClip(x, Graphics::ScreenWidth);
+					const float right = toClip(std::min(x + size, static_cast<int>(Graphics::ScreenWidth)), Graphics::ScreenWidth);
+					const float top = -toClip(y, Graphics::ScreenHeight);
+					const float bottom = -toClip(std::min(y + size, static_cast<int>(Graphics::ScreenHeight)), Graphics::ScreenHeight);
+
+					const size_t first = vertices.size();
+					vertices.push_back({ Vec3(left, top, 0.5f), normal, Vec2(0.0f, 0.0f) });
+					vertices.push_back({ Vec3(right, top, 0.5f), normal, Vec2(1.0f, 0.0f) });
+					vertices.push_back({ Vec3(left, bottom, 0.5f), normal, Vec2(0.0f, 1.0f) });
+					vertices.push_back({ Vec3(right, bottom, 0.5f), normal, Vec2(1.0f, 1.0f) });
+					indices.insert(indices.end(), { first, first + 1u, first + 2u, first + 1u, first + 3u, first + 2u });
+				}
+			}
+
+			pipeline.BindVertices(vertices);
+			pipeline.BindIndices(indices);
+			const double nanoseconds = MeasureNanoseconds(repetitions, pixelCount, [&]()
+			{
+				pipeline.ClearZBuffer();
+				pipeline.Draw();
+			});
+			AddResult("ns per pixel, " + std::to_string(size) + " px triangles", nanoseconds, "ns");
+		}
+	}
+
+	void BenchmarkFrames(Graphics& graphics, JobSystem& jobs, const std::shared_ptr<const Texture>& pTexture, int repetitions)
+	{
+		using namespace Benchmarking;
+		s_ResultGroup = "frame";
+
+		// Drawn as the preview scene draws its model: shadow pass, then the textured main pass
+		GraphicsPipeline<Program> pipeline(graphics);
+		pipeline.SetJobSystem(&jobs);
+		pipeline.BindTexture(pTexture);
+		ShadowMap shadowMap(graphics, 1024, 3);
+		shadowMap.SetJobSystem(&jobs);
+
+		for (const char* path : BenchmarkSuite::ModelPaths)
+		{
+			Mesh mesh;
+			if (!mesh.Load(path)) continue;
+			const std::vector<Program::VSIn> input = CreateInput(mesh);
+
+			// Scaled to fill most of the view, whatever size the model was made at
+			float radius = 0.0f;
+			for (const Vec3& vertex : mesh.GetVertices()) radius = std::max(radius, Vec3::Magnitude(vertex));
+			const float scale = 1.5f / std::max(radius, 1.0e-6f);
+			const Mat4 model = Mat4::RotateX(0.4f) * Mat4::RotateY(0.6f) * Mat4::Scale(scale, scale, scale);
+			const Vec3 cameraPosition(0.0f, 0.0f, 3.0f);
+			const Mat4 view = Mat4::Translate(-cameraPosition);
+			const Mat4 projection = Mat4::PerspectiveProjection(0.1f, 100.0f, 90.0f * (static_cast<float>(M_PI) / 180.0f), Graphics::AspectRatio);
+			const Vec3 sunDirection = Vec3::Normalize({ 0.4f, -0.8f, -0.6f });
+			const Vec4 sunDirectionViewSpace = view * Vec4(-sunDirection.x, -sunDirection.y, -sunDirection.z, 0.0f);
+
+			const double frameMs = MeasureNanoseconds(repetitions, 1, [&]()
+			{
+				shadowMap.SetDirectionalLight(sunDirection, Vec3::Zero(), 2.0f, 20.0f);
+				shadowMap.BeginPass();
+				shadowMap.Draw(mesh, model);
+				shadowMap.EndPass();
+
+				auto& pixelShader = pipeline.GetPixelShader();
+				pixelShader.ClearLights();
+				pixelShader.AddLight(Program::Light::Directional(sunDirectionViewSpace, &shadowMap, shadowMap.GetViewProjection() * Mat4::Translate(cameraPosition)));
+
+				pipeline.BindIndices(mesh.GetIndices());
+				pipeline.BindVertices(input);
+				pipeline.GetVertexShader().SetMVP(projection * view * model);
+				pipeline.GetVertexShader().SetMV(view * model);
+				pipeline.GetVertexShader().SetP(projection);
+				pipeline.ClearZBuffer();
+				pipeline.Draw();
+			}) / 1.0e6;
+			AddResult(std::string(path) + " ms", frameMs, "ms");
+		}
+	}
+
+	// Frames of generated scenes, every knob swept on its own from the same base
+	void BenchmarkStressScenes(Graphics& graphics, JobSystem& jobs, int repetitions)
+	{
+		using namespace Benchmarking;
+		s_ResultGroup = "stress";
+
+		GraphicsPipeline<UnshadowedProgram> pipeline(graphics);
+		pipeline.SetJobSystem(&jobs);
+
+		auto measure = [&](const char* knob, int value, const StressScene::Settings& settings)
+		{
+			const StressScene scene(settings);
+			std::vector<std::vector<UnshadowedProgram::VSIn>> inputs;
+			for (const Entity& entity : scene.GetEntities())
+			{
+				const Mesh& mesh = *entity.GetMesh();
+				auto& input = inputs.emplace_back();
+				for (size_t i = 0; i < mesh.GetVertices().size(); i++)
+				{
+					input.push_back({ mesh.GetVertices()[i], mesh.GetNormals()[i], mesh.GetUvCoordinates()[i] });
+				}
+			}
+
+			pipeline.BindTexture(scene.GetTexture());
+			const Mat4 projection = StressScene::GetProjection();
+
+			const double frameMs = MeasureNanoseconds(repetitions, 1, [&]()
+			{
+				pipeline.ClearZBuffer();
+				for (size_t i = 0; i < scene.GetEntities().size(); i++)
+				{
+					const Entity& entity = scene.GetEntities()[i];
+					const Mat4 model = entity.GetModelTransform();
+					pipeline.BindVertices(inputs[i]);
+					pipeline.BindIndices(entity.GetMesh()->GetIndices());
+					pipeline.GetVertexShader().SetMVP(projection * model);
+					pipeline.GetVertexShader().SetMV(model);
+					pipeline.GetVertexShader().SetP(projection);
+					pipeline.Draw();
+				}
+			}) / 1.0e6;
+			AddResult(std::string(knob) + " " + std::to_string(value) + " ms", frameMs, "ms");
+		};
+
+		// About 160000 pixels, small enough that every sweep stays on the screen
+		StressScene::Settings base;
+		base.m_TriangleCount = 20000;
+		base.m_TriangleSize = 4.0f;
+		base.m_OverdrawDepth = 1;
+		base.m_InstanceCount = 16;
+		base.m_TextureResolution = 256;
+		base.m_NearPlaneCrossingFraction = 0.0f;
+
+		for (int triangleCount : { 5000, 20000, 80000 })
+		{
+			StressScene::Settings settings = base;
+			settings.m_TriangleCount = triangleCount;
+			measure("triangles", triangleCount, settings);
+		}
+		for (int size : { 2, 4, 8 })
+		{
+			StressScene::Settings settings = base;
+			settings.m_TriangleSize = static_cast<float>(size);
+			measure("triangle px", size, settings);
+		}
+		for (int depth : { 1, 2, 4, 8 })
+		{
+			StressScene::Settings settings = base;
+			settings.m_OverdrawDepth = depth;
+			measure("overdraw", depth, settings);
+		}
+		for (int instanceCount : { 1, 16, 256 })
+		{
+			StressScene::Settings settings = base;
+			settings.m_InstanceCount = instanceCount;
+			measure("instances", instanceCount, settings);
+		}
+		for (int resolution : { 64, 256, 1024, 4096 })
+		{
+			StressScene::Settings settings = base;
+			settings.m_TextureResolution = resolution;
+			measure("texture px", resolution, settings);
+		}
+		for (int percent : { 0, 10, 50 })
+		{
+			StressScene::Settings settings = base;
+			settings.m_NearPlaneCrossingFraction = percent / 100.0f;
+			measure("near plane crossing %", percent, settings);
+		}
+		for (int batched : { 0, 1 })
+		{
+			StressScene::Settings settings = base;
+			settings.m_InstanceCount = 256;
+			settings.m_StaticBatching = batched != 0;
+			measure("static batching at 256 instances", batched, settings);
+		}
+	}
+
+	// A field of small props around the camera, drawn an entity at a time and then merged by a StaticBatch,
+	// the difference is the overhead of binding and drawing every one of them
+	void BenchmarkStaticBatching(Graphics& graphics, JobSystem& jobs, const std::shared_ptr<const Texture>& pTexture, int repetitions)
+	{
+		using namespace Benchmarking;
+		s_ResultGroup = "batch";
+
+		std::vector<Vec3> sphereVertices;
+		std::vector<size_t> indices;
+		CreateSphere(4, 6, sphereVertices, indices);
+		std::vector<Vec3> vertices;
+		std::vector<Vec2> uvCoordinates;
+		for (const Vec3& vertex : sphereVertices)
+		{
+			vertices.push_back(vertex * 0.3f);
+			uvCoordinates.emplace_back(vertex.x * 0.5f + 0.5f, vertex.y * 0.5f + 0.5f);
+		}
+		const auto pProp = std::make_shared<const Mesh>(vertices, sphereVertices, uvCoordinates, indices);
+		const std::vector<UnshadowedProgram::VSIn> propInput = CreateInput(*pProp);
+
+		// Every other prop with the other material
+		auto pCompressedTexture = std::make_shared<Texture>();
+		pCompressedTexture->Load(BenchmarkSuite::TexturePath, Texture::Format::BC1, &jobs);
+		const StaticBatch::Material materials[] = { pTexture, pCompressedTexture };
+
+		GraphicsPipeline<UnshadowedProgram> pipeline(graphics);
+		pipeline.SetJobSystem(&jobs);
+		const Mat4 projection = Mat4::PerspectiveProjection(0.1f, 100.0f, 1.57f, Graphics::AspectRatio);
+		const Vec3 eyePosition(0.0f, 1.5f, 0.0f);
+		const Mat4 view = Mat4::Translate(-eyePosition);
+
+		for (int propCount : { 256, 1024, 4096 })
+		{
+			// On a grid over the ground, part of it behind the camera and beyond the sides of the view
+			std::mt19937 random(1234u);
+			std::uniform_real_distribution<float> angle(0.0f, 2.0f * static_cast<float>(M_PI));
+			const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(propCount))));
+			std::vector<Entity> props;
+			for (int i = 0; i < propCount; i++)
+			{
+				const float x = -40.0f + 80.0f * (i % columns + 0.5f) / columns;
+				const float z = 20.0f - 100.0f * (i / columns + 0.5f) / columns;
+				props.emplace_back(pProp, Vec3(x, 0.3f, z), Vec3(angle(random), angle(random), 0.0f));
+			}
+
+			// Both recorded as a scene records its draws, vertices are bound by reference and never copied
+			CommandBuffer<UnshadowedProgram> commands;
+			const double propsMs = MeasureNanoseconds(repetitions, 1, [&]()
+			{
+				commands.Clear();
+				for (size_t i = 0; i < props.size(); i++)
+				{
+					const Mat4 modelView = view * props[i].GetModelTransform();
+					commands.BindTexture(materials[i % 2u]);
+					commands.BindVertices(propInput);
+					commands.BindIndices(pProp->GetIndices());
+					commands.SetConstants({ projection * modelView, modelView, projection });
+					commands.Draw();
+				}
+				pipeline.ClearZBuffer();
+				pipeline.Execute(commands);
+			}) / 1.0e6;
+
+			StaticBatch batch;
+			const double buildMs = MeasureNanoseconds(1, 1, [&]()
+			{
+				batch.Clear();
+				for (size_t i = 0; i < props.size(); i++) batch.Add(props[i], materials[i % 2u]);
+				batch.Build();
+			}) / 1.0e6;
+
+			std::vector<std::vector<UnshadowedProgram::VSIn>> chunkInputs;
+			for (const StaticBatch::Chunk& chunk : batch.GetChunks()) chunkInputs.push_back(CreateInput(*chunk.m_pMesh));
+
+			const double batchedMs = MeasureNanoseconds(repetitions, 1, [&]()
+			{
+				commands.Clear();
+				commands.SetConstants({ projection * view, view, projection });
+				for (size_t i : batch.GetVisibleChunks(projection * view, eyePosition))
+				{
+					const StaticBatch::Chunk& chunk = batch.GetChunks()[i];
+					commands.BindTexture(chunk.m_pMaterial);
+					commands.BindVertices(chunkInputs[i]);
+					commands.BindIndices(chunk.m_pMesh->GetIndices());
+					commands.Draw();
+				}
+				pipeline.ClearZBuffer();
+				pipeline.Execute(commands);
+			}) / 1.0e6;
+
+			const std::string name = "props " + std::to_string(propCount);
+			AddResult(name + " ms", propsMs, "ms");
+			AddResult(name + " batched ms", batchedMs, "ms");
+			AddResult(name + " batch build ms", buildMs, "ms");
+		}
+	}
+
+	std::string Escape(const std::string& value)
+	{
+		std::string escaped;
+		for (char c : value)
+		{
+			if (c == '"' || c == '\\') escaped.push_back('\\');
+			escaped.push_back(c);
+		}
+		return escaped;
+	}
+
+	// Value of "key": in the line, the line is one result as ToJson writes it
+	bool FindString(const std::string& line, const char* key, std::string& value)
+	{
+		const std::string prefix = std::string("\"") + key + "\": \"";
+		size_t position = line.find(prefix);
+		if (position == std::string::npos) return false;
+
+		value.clear();
+		for (position += prefix.size(); position < line.size() && line[position] != '"'; position++)
+		{
+			if (line[position] == '\\' && position + 1 < line.size()) position++;
+			value.push_back(line[position]);
+		}
+		return position < line.size();
+	}
+
+	bool FindNumber(const std::string& line, const char* key, double& value)
+	{
+		const std::string prefix = std::string("\"") + key + "\": ";
+		const size_t position = line.find(prefix);
+		if (position == std::string::npos) return false;
+
+		std::istringstream stream(line.substr(position + prefix.size()));
+		return static_cast<bool>(stream >> value);
+	}
+
+	const Benchmarking::Result* FindResult(const std::vector<Benchmarking::Result>& results, const std::string& name)
+	{
+		for (const auto& result : results)
+		{
+			if (result.m_Name == name) return &result;
+		}
+		return nullptr;
+	}
+}
+
+std::vector<Benchmarking::Result> BenchmarkSuite::Run(Graphics& graphics, JobSystem& jobs, int repetitions)
+{
+	using namespace Benchmarking;
+
+	std::vector<Result> results;
+	s_pResults = &results;
+
+	s_ResultGroup = "math";
+	MathBenchmark::Run(100000, repetitions);
+
+	s_ResultGroup = "texture";
+	TextureBenchmark::Run(TexturePath, 512, repetitions);
+
+	s_ResultGroup = "job";
+	JobBenchmark::Run(100000, repetitions);
+
+	BenchmarkLoading(repetitions);
+	BenchmarkVertices(graphics, jobs, repetitions);
+
+	// A quarter of the triangles the benchmark draws on its own, the sweep runs once per core
+	s_ResultGroup = "vertex scaling";
+	VertexBenchmark::Run(graphics, 256, 512, repetitions);
+
+	s_ResultGroup = "command";
+	CommandBenchmark::Run(graphics, 50000, 8, repetitions);
+
+	BenchmarkClipping(graphics, repetitions);
+
+	auto pTexture = std::make_shared<Texture>();
+	pTexture->Load(TexturePath, Texture::Format::RGB8, &jobs);
+	BenchmarkFillRate(graphics, pTexture, repetitions);
+	BenchmarkFrames(graphics, jobs, pTexture, repetitions);
+	BenchmarkStressScenes(graphics, jobs, repetitions);
+	BenchmarkStaticBatching(graphics, jobs, pTexture, repetitions);
+
+	s_pResults = nullptr;
+	s_ResultGroup.clear();
+	return results;
+}
+
+std::string BenchmarkSuite::ToJson(const std::vector<Benchmarking::Result>& results, const std::vector<Benchmarking::Result>* pBaseline)
+{
+	// One result per line, ReadJson relies on it
+	std::ostringstream json;
+	json << std::setprecision(6) << "{\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const auto& result = results[i];
+		json << "    { \"name\": \"" << Escape(result.m_Name) << "\", \"value\": " << result.m_Value << ", \"unit\": \"" << Escape(result.m_Unit) << "\"";
+
+		const Benchmarking::Result* pPrevious = pBaseline != nullptr ? FindResult(*pBaseline, result.m_Name) : nullptr;
+		if (pPrevious != nullptr && pPrevious->m_Value > 0.0)
+		{
+			json << ", \"baseline\": " << pPrevious->m_Value << ", \"delta_percent\": " << (result.m_Value / pPrevious->m_Value - 1.0) * 100.0;
+		}
+		json << (i + 1 < results.size() ? " },\n" : " }\n");
+	}
+	json << "  ]\n}\n";
+
+	return json.str();
+}
+
+bool BenchmarkSuite::ReadJson(const std::string& path, std::vector<Benchmarking::Result>& results)
+{
+	results.clear();
+
+	std::ifstream stream(path);
+	if (!stream) return false;
+
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		Benchmarking::Result result;
+		if (FindString(line, "name", result.m_Name) && FindNumber(line, "value", result.m_Value) && FindString(line, "unit", result.m_Unit))
+		{
+			results.push_back(std::move(result));
+		}
+	}
+
+	return true;
+}
+
+std::string BenchmarkSuite::Save(const std::vector<Benchmarking::Result>& results, const std::string& path, const std::string& baselinePath)
+{
+	std::vector<Benchmarking::Result> baseline;
+	const bool compare = !baselinePath.empty() && ReadJson(baselinePath, baseline);
+	std::ofstream(path) << ToJson(results, compare ? &baseline : nullptr);
+
+	std::string report = "Benchmark results written to " + path + "\n";
+	if (compare)
+	{
+		report += Compare(results, baseline);
+		std::ofstream(path + ".txt") << report;
+	}
+	else if (!baselinePath.empty())
+	{
+		report += "Can't read the baseline " + baselinePath + "\n";
+	}
+
+	return report;
+}
+
+std::string BenchmarkSuite::Compare(const std::vector<Benchmarking::Result>& results, const std::vector<Benchmarking::Result>& baseline, double thresholdPercent)
+{
+	std::ostringstream report;
+	report << "Benchmark comparison, changes beyond " << thresholdPercent << "% flagged\n";
+
+	int regressions = 0;
+	int improvements = 0;
+	for (const auto& result : results)
+	{
+		const Benchmarking::Result* pPrevious = FindResult(baseline, result.m_Name);
+		if (pPrevious == nullptr || pPrevious->m_Value <= 0.0)
+		{
+			report << "  " << std::left << std::setw(56) << result.m_Name << std::right << "   new\n";
+			continue;
+		}
+
+		const double delta = (result.m_Value / pPrevious->m_Value - 1.0) * 100.0;
+		const char* flag = delta > thresholdPercent ? "  REGRESSION" : delta < -thresholdPercent ? "  improvement" : "";
+		regressions += delta > thresholdPercent;
+		improvements += delta < -thresholdPercent;
+
+		report << "  " << std::left << std::setw(56) << result.m_Name << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(12) << pPrevious->m_Value << " -> " << std::setw(12) << result.m_Value << " " << result.m_Unit
+			<< std::setprecision(1) << std::showpos << std::setw(9) << delta << "%" << std::noshowpos << flag << "\n";
+	}
+	report << "  " << regressions << " regressions, " << improvements << " improvements\n";
+
+	return report.str();
+}
\ No newline at end of file
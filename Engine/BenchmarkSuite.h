@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Benchmarking.h"
+
+class Graphics;
+class JobSystem;
+
+// Every benchmark of the engine in one run, with results that can be saved and compared between builds:
+// Vec/Mat4 operations, job system overhead and scaling, OBJ parsing per model, vertex processing and its scaling
+// with the thread count, command buffer recording and execution, clipping heavy geometry, fill rate at several
+// triangle sizes, texture sampling patterns, whole frames of the bundled models and of generated scenes along each
+// of their knobs (see StressScene), and a prop heavy scene with and without static batching. Every result is a time, lower is better.
+// Runs from the windowed build's -benchmark argument, and without a window from Headless/ on any platform.
+class BenchmarkSuite
+{
+public:
+	static std::vector<Benchmarking::Result> Run(Graphics& graphics, JobSystem& jobs, int repetitions = 5);
+
+	// With the baseline, every result that is in it carries its change in percent
+	static std::string ToJson(const std::vector<Benchmarking::Result>& results, const std::vector<Benchmarking::Result>* pBaseline = nullptr);
+	// Reads what ToJson wrote, false when the file can't be read
+	static bool ReadJson(const std::string& path, std::vector<Benchmarking::Result>& results);
+
+	// Changes against the baseline, the ones beyond the threshold flagged as regressions or improvements
+	static std::string Compare(const std::vector<Benchmarking::Result>& results, const std::vector<Benchmarking::Result>& baseline, double thresholdPercent = 5.0);
+
+	// Writes the results as JSON to the path and returns a report of it. With a baseline path that can be read
+	// the JSON carries the changes against it, and they are compared in the report and in <path>.txt as well.
+	static std::string Save(const std::vector<Benchmarking::Result>& results, const std::string& path, const std::string& baselinePath = "");
+
+	static constexpr const char* ModelPaths[] = { "models/box.obj", "models/suzanne.obj", "models/gnomeFigure.obj" };
+	static constexpr const char* TexturePath = "models/boxTexture.png";
+};
\ No newline at end of file
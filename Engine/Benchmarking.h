@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Timing and reporting helpers shared by the microbenchmarks
+namespace Benchmarking
+{
+	// Best of several runs, per operation
+	template <typename TFunction>
+	double MeasureNanoseconds(int repetitions, int operations, TFunction function)
+	{
+		double best = 0.0;
+		for (int i = 0; i < repetitions; i++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			function();
+			const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+			const double perOperation = elapsed.count() / operations;
+			if (i == 0 || perOperation < best) best = perOperation;
+		}
+
+		return best;
+	}
+
+	// Keeps the optimizer from dropping results nobody reads
+	inline volatile float s_Sink;
+
+	// Measurement for machine readable reports, lower is better whatever the unit
+	struct Result
+	{
+		std::string m_Name;
+		double m_Value;
+		std::string m_Unit;
+	};
+
+	// Set while BenchmarkSuite runs, every measurement reported is added to it as group/name
+	inline std::vector<Result>* s_pResults = nullptr;
+	inline std::string s_ResultGroup;
+
+	inline void AddResult(const std::string& name, double value, const char* unit)
+	{
+		if (s_pResults != nullptr) s_pResults->push_back({ s_ResultGroup + "/" + name, value, unit });
+	}
+
+	inline void ReportLine(std::ostringstream& report, const char* name, double nanoseconds, double baseline)
+	{
+		report << "  " << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(8) << nanoseconds << " ns  x" << baseline / nanoseconds << "\n";
+		AddResult(name, nanoseconds, "ns");
+	}
+
+	// Nearest rank, the values have to be sorted
+	inline double Percentile(const std::vector<double>& sorted, double fraction)
+	{
+		const size_t index = static_cast<size_t>(fraction * (sorted.size() - 1u) + 0.5);
+		return sorted[std::min(index, sorted.size() - 1u)];
+	}
+
+	// Min, median and p99 of whole frames, for the replays
+	inline void ReportFrameTimes(std::ostringstream& report, std::vector<double> frameMilliseconds)
+	{
+		if (frameMilliseconds.empty()) return;
+
+		std::sort(frameMilliseconds.begin(), frameMilliseconds.end());
+		report << std::fixed << std::setprecision(3)
+			<< "  frame time min " << frameMilliseconds.front() << " ms, median " << Percentile(frameMilliseconds, 0.5)
+			<< " ms, p99 " << Percentile(frameMilliseconds, 0.99) << " ms\n";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "CommandBenchmark.h"
+#include "Benchmarking.h"
+#include "CommandBuffer.h"
+#include "DepthOnlyShaderProgram.h"
+#include "GraphicsPipeline.h"
+#include "JobSystem.h"
+
+std::string CommandBenchmark::Run(Graphics& graphics, int drawCount, int threadCount, int repetitions)
+{
+	using namespace Benchmarking;
+
+	std::ostringstream report;
+	report << "Command buffer benchmark, " << drawCount << " draws, " << threadCount << " recording threads, best of " << repetitions << " runs\n";
+
+	const std::vector<Vec3> vertices = { Vec3(0.0f, 0.0f, 0.0f), Vec3(0.02f, 0.0f, 0.0f), Vec3(0.0f, 0.02f, 0.0f) };
+	const std::vector<size_t> indices = { 0u, 1u, 2u };
+
+	std::vector<Mat4> models;
+	std::mt19937 random(1234u);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	for (int i = 0; i < drawCount; i++)
+	{
+		models.push_back(Mat4::Translate(distribution(random), distribution(random), -2.0f + distribution(random)) * Mat4::RotateY(distribution(random)));
+	}
+
+	const Mat4 viewProjection = Mat4::PerspectiveProjection(0.1f, 100.0f, 1.57f, 1.0f);
+
+	typedef CommandBuffer<DepthOnlyShaderProgram> Commands;
+	auto record = [&](Commands& commands, size_t first, size_t last)
+	{
+		commands.Clear();
+		for (size_t i = first; i < last; i++)
+		{
+			commands.BindVertices(vertices);
+			commands.BindIndices(indices);
+			commands.SetConstants({ viewProjection * models[i] });
+			commands.Draw();
+		}
+	};
+
+	// Recording, one buffer on this thread and then a buffer per thread
+	std::vector<Commands> buffers(threadCount);
+	const double serialRecording = MeasureNanoseconds(repetitions, drawCount, [&]()
+	{
+		record(buffers[0], 0u, models.size());
+	});
+	ReportLine(report, "record, 1 thread", serialRecording, serialRecording);
+
+	const size_t drawsPerBuffer = (models.size() + threadCount - 1) / threadCount;
+	{
+		JobSystem jobs(threadCount - 1);
+		const double parallelRecording = MeasureNanoseconds(repetitions, drawCount, [&]()
+		{
+			jobs.ParallelFor(0u, buffers.size(), 1u, [&](size_t firstBuffer, size_t lastBuffer)
+			{
+				for (size_t i = firstBuffer; i < lastBuffer; i++)
+				{
+					record(buffers[i], std::min(i * drawsPerBuffer, models.size()), std::min((i + 1) * drawsPerBuffer, models.size()));
+				}
+			});
+		});
+		const std::string name = "record, " + std::to_string(threadCount) + " threads";
+		ReportLine(report, name.c_str(), parallelRecording, serialRecording);
+	}
+
+	// Execution of the recorded buffers in order, against binding and drawing directly
+	GraphicsPipeline<DepthOnlyShaderProgram> pipeline(graphics, 256, 256);
+	const double imperative = MeasureNanoseconds(repetitions, drawCount, [&]()
+	{
+		pipeline.ClearZBuffer();
+		for (const Mat4& model : models)
+		{
+			pipeline.BindVertices(vertices);
+			pipeline.BindIndices(indices);
+			pipeline.GetVertexShader().SetMVP(viewProjection * model);
+			pipeline.Draw();
+		}
+	});
+	ReportLine(report, "imperative draws", imperative, imperative);
+
+	const double execution = MeasureNanoseconds(repetitions, drawCount, [&]()
+	{
+		pipeline.ClearZBuffer();
+		for (const Commands& commands : buffers) pipeline.Execute(commands);
+	});
+	ReportLine(report, "execute recorded", execution, imperative);
+
+	return report.str();
+}
\ No newline at end of file
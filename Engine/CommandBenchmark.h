@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+class Graphics;
+
+// Cost of recording draws into command buffers, on one thread and split over threads recording buffers of their own,
+// and of executing them, against drawing the same way through the imperative pipeline calls.
+// Every draw is a small triangle of its own with its own MVP, through the depth only pipeline.
+class CommandBenchmark
+{
+public:
+	static std::string Run(Graphics& graphics, int drawCount = 50000, int threadCount = 8, int repetitions = 5);
+};
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Texture.h"
+
+enum class CommandType : uint8_t
+{
+	BindVertices,
+	BindIndices,
+	BindTexture,
+	SetConstants,
+	Draw
+};
+
+// Draws recorded for a GraphicsPipeline and run later by GraphicsPipeline::Execute, in recording order.
+// Shader constants are recorded by value. Vertices and indices are recorded by reference: they have to stay alive
+// and unchanged until the buffer was executed, and stay bound to the pipeline after that until something else is bound.
+// Textures are held by the buffer until it is cleared.
+//
+// Recording touches nothing but the buffer, so any number of threads can record buffers of their own at once
+// (traversal, culling and constant setup run in parallel), the buffers are then executed one after the other
+// on the thread drawing with the pipeline.
+template <class TShaderProgram>
+class CommandBuffer
+{
+public:
+	typedef typename TShaderProgram::VSIn VSIn;
+	typedef typename TShaderProgram::VertexShader::Constants Constants;
+
+	// The argument indexes the recorded values of the command's type, nothing for draws
+	struct Command
+	{
+		CommandType m_Type;
+		uint32_t m_Argument;
+	};
+
+	void BindVertices(const std::vector<VSIn>& vertices) { Record(CommandType::BindVertices, m_Vertices, &vertices); }
+	void BindIndices(const std::vector<size_t>& indices)
+	{
+		assert(indices.size() % 3 == 0);
+		Record(CommandType::BindIndices, m_Indices, &indices);
+	}
+	void BindTexture(std::shared_ptr<const Texture> pTexture) { Record(CommandType::BindTexture, m_Textures, std::move(pTexture)); }
+	void SetConstants(const Constants& constants) { Record(CommandType::SetConstants, m_Constants, constants); }
+	void Draw()
+	{
+		m_Commands.push_back({ CommandType::Draw, 0u });
+		m_DrawCount++;
+	}
+
+	// Keeps the memory for the next recording
+	void Clear()
+	{
+		m_Commands.clear();
+		m_Vertices.clear();
+		m_Indices.clear();
+		m_Textures.clear();
+		m_Constants.clear();
+		m_DrawCount = 0u;
+	}
+
+	const std::vector<Command>& GetCommands() const { return m_Commands; }
+	size_t GetDrawCount() const { return m_DrawCount; }
+
+	const std::vector<VSIn>& GetVertices(uint32_t argument) const { return *m_Vertices[argument]; }
+	const std::vector<size_t>& GetIndices(uint32_t argument) const { return *m_Indices[argument]; }
+	const std::shared_ptr<const Texture>& GetTexture(uint32_t argument) const { return m_Textures[argument]; }
+	const Constants& GetConstants(uint32_t argument) const { return m_Constants[argument]; }
+
+private:
+	template <class TValue, class TArgument>
+	void Record(CommandType type, std::vector<TValue>& values, TArgument&& value)
+	{
+		m_Commands.push_back({ type, static_cast<uint32_t>(values.size()) });
+		values.push_back(std::forward<TArgument>(value));
+	}
+
+	// Commands are two words, the values they refer to are packed by type
+	std::vector<Command> m_Commands;
+	std::vector<const std::vector<VSIn>*> m_Vertices;
+	std::vector<const std::vector<size_t>*> m_Indices;
+	std::vector<std::shared_ptr<const Texture>> m_Textures;
+	std::vector<Constants> m_Constants;
+
+	size_t m_DrawCount = 0u;
+};
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <cassert>
+
+#include "DepthBuffer.h"
+#include "AllocationTracker.h"
+
+DepthBuffer::DepthBuffer(int width, int height)
+	:
+	m_Width(width),
+	m_Height(height),
+	m_TilesX((width + TileSize - 1) / TileSize),
+	m_TilesY((height + TileSize - 1) / TileSize)
+{
+	assert(width > 0 && height > 0);
+
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Pipeline);
+	m_Depths.assign(static_cast<size_t>(width) * height, ClearValue);
+	m_TileGenerations.assign(static_cast<size_t>(m_TilesX) * m_TilesY, m_Generation);
+}
+
+void DepthBuffer::Clear()
+{
+	// Every tile is now stale, nothing gets written until it is touched or resolved
+	m_Generation++;
+}
+
+void DepthBuffer::Resolve()
+{
+	for (int tileY = 0; tileY < m_TilesY; tileY++)
+	{
+		for (int tileX = 0; tileX < m_TilesX; tileX++)
+		{
+			uint64_t& tileGeneration = m_TileGenerations[tileY * m_TilesX + tileX];
+			if (tileGeneration != m_Generation)
+			{
+				ClearTile(tileX, tileY);
+				tileGeneration = m_Generation;
+			}
+		}
+	}
+}
+
+void DepthBuffer::ClearTile(int tileX, int tileY)
+{
+	const int startX = tileX * TileSize;
+	const int tileWidth = std::min(TileSize, m_Width - startX);
+	const int endY = std::min((tileY + 1) * TileSize, m_Height);
+
+	for (int y = tileY * TileSize; y < endY; y++)
+	{
+		std::fill_n(m_Depths.begin() + (y * m_Width + startX), tileWidth, ClearValue);
+	}
+}
\ No newline at end of file
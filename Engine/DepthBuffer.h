@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+// Depth buffer with lazy clears.
+// The buffer is split into tiles that remember the clear generation they were last written in.
+// Clear() only bumps the generation, a tile is filled with the clear value the first time it is
+// touched afterwards, and Resolve() fills the tiles nothing touched before the depths are read.
+class DepthBuffer
+{
+public:
+	DepthBuffer(int width, int height);
+
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+
+	// Reads require the buffer to be resolved since the last Clear
+	float At(int x, int y) const { return m_Depths[y * m_Width + x]; }
+
+	// Rows are stored contiguously, so filters can read several neighbouring texels with one load
+	const float* GetRow(int y) const { return m_Depths.data() + y * m_Width; }
+
+	void Clear();
+	void Resolve();
+
+	// Returns true and stores the depth if it is closer than the one already in the buffer
+	bool TestAndSet(int x, int y, float depth)
+	{
+		uint64_t& tileGeneration = m_TileGenerations[(y >> TileShift) * m_TilesX + (x >> TileShift)];
+		if (tileGeneration != m_Generation)
+		{
+			ClearTile(x >> TileShift, y >> TileShift);
+			tileGeneration = m_Generation;
+		}
+
+		float& stored = m_Depths[y * m_Width + x];
+		if (depth >= stored) return false;
+
+		stored = depth;
+		return true;
+	}
+
+	static constexpr float ClearValue = std::numeric_limits<float>::max();
+
+	static constexpr int TileShift = 4;
+	static constexpr int TileSize = 1 << TileShift;
+
+private:
+	void ClearTile(int tileX, int tileY);
+
+	int m_Width;
+	int m_Height;
+	int m_TilesX;
+	int m_TilesY;
+
+	std::vector<float> m_Depths;
+
+	uint64_t m_Generation = 0u;
+	std::vector<uint64_t> m_TileGenerations;
+};
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "Vec3.h"
+#include "Mat4.h"
+#include "TransformKernels.h"
+#include "Varyings.h"
+
+// Position-only program used for depth passes (shadow maps).
+// Nothing but the clip space position is interpolated, and no color is ever written.
+class DepthOnlyShaderProgram
+{
+public:
+	static constexpr bool WritesColor = false;
+	static constexpr bool BatchesVertices = true;
+	static constexpr bool RecordsHeatmap = false;
+
+	typedef Vec3 VSIn;
+
+	typedef VaryingVertex<> VSOut;
+
+	class VertexShader
+	{
+	public:
+		VSOut Main(const VSIn& vIn) { return { m_MVP * vIn }; }
+
+		// Several threads may shade different ranges at once
+		void MainBatch(const VSIn* pVertices, size_t count, VSOut* pOutputs)
+		{
+			BatchScratch& scratch = GetBatchScratch();
+
+			scratch.m_Positions.Resize(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				scratch.m_Positions.Set(i, pVertices[i]);
+			}
+
+			scratch.m_ClipPositions.resize(count);
+			TransformKernels::TransformPoints(m_MVP, scratch.m_Positions, scratch.m_ClipPositions.data());
+
+			std::copy(scratch.m_ClipPositions.begin(), scratch.m_ClipPositions.end(), pOutputs);
+		}
+
+		struct Constants
+		{
+			Mat4 m_MVP;
+		};
+
+		void SetConstants(const Constants& constants) { m_MVP = constants.m_MVP; }
+		Constants GetConstants() const { return { m_MVP }; }
+
+		void SetMVP(const Mat4& value) { m_MVP = value; }
+
+	private:
+		struct BatchScratch
+		{
+			Vec3Stream m_Positions;
+			std::vector<Vec4> m_ClipPositions;
+		};
+
+		// One per thread, kept around so the memory is reused between draws
+		static BatchScratch& GetBatchScratch()
+		{
+			thread_local BatchScratch s_Scratch;
+			return s_Scratch;
+		}
+
+		Mat4 m_MVP;
+	};
+
+	struct PSOut
+	{
+	};
+
+	class PixelShader
+	{
+	};
+};
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include "DrawCapture.h"
+
+namespace
+{
+	// The bytes "CAP\x01" as a little endian word, the last one is the version and bumped whenever the layout changes
+	constexpr uint32_t CaptureMagic = 0x01504143u;
+
+	// Mostly less than this, more means a damaged file
+	constexpr uint32_t MaxCount = 1u << 24;
+	constexpr int32_t MaxShadowResolution = 8192;
+
+	// Frame state as stored, followed by the shadow draws and the draws
+	struct FrameRecord
+	{
+		uint8_t m_RasterizationMode;
+		uint8_t m_PixelTraversal;
+		uint8_t m_BackgroundColor;
+		uint8_t m_Shadowed;
+		int32_t m_AntiAliasing;
+		float m_SunDirection[3];
+		int32_t m_ShadowResolution;
+		int32_t m_ShadowFilterSize;
+		float m_ShadowDepthBias;
+		Mat4 m_ShadowViewProjection;
+		Mat4 m_ViewToLightClip;
+		uint32_t m_ShadowDrawCount;
+		uint32_t m_DrawCount;
+	};
+
+	template <class T>
+	bool WriteValue(std::ostream& stream, const T& value)
+	{
+		return static_cast<bool>(stream.write(reinterpret_cast<const char*>(&value), sizeof(T)));
+	}
+
+	template <class T>
+	bool ReadValue(std::istream& stream, T& value)
+	{
+		return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+
+	bool WriteString(std::ostream& stream, const std::string& value)
+	{
+		return WriteValue(stream, static_cast<uint32_t>(value.size())) && stream.write(value.data(), value.size());
+	}
+
+	bool ReadString(std::istream& stream, std::string& value)
+	{
+		uint32_t size;
+		if (!ReadValue(stream, size) || size > MaxCount) return false;
+
+		value.resize(size);
+		return static_cast<bool>(stream.read(&value[0], size));
+	}
+
+	template <class T>
+	bool WriteArray(std::ostream& stream, const std::vector<T>& values)
+	{
+		return static_cast<bool>(stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T)));
+	}
+
+	template <class T>
+	bool ReadArray(std::istream& stream, std::vector<T>& values, uint32_t count)
+	{
+		values.resize(count);
+		return static_cast<bool>(stream.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T)));
+	}
+}
+
+uint32_t DrawCapture::AddMesh(const std::string& path)
+{
+	const auto it = std::find(m_MeshPaths.begin(), m_MeshPaths.end(), path);
+	if (it != m_MeshPaths.end()) return static_cast<uint32_t>(it - m_MeshPaths.begin());
+
+	m_MeshPaths.push_back(path);
+	return static_cast<uint32_t>(m_MeshPaths.size() - 1u);
+}
+
+uint32_t DrawCapture::AddTexture(const std::string& path, Texture::Format format)
+{
+	const auto it = std::find_if(m_Textures.begin(), m_Textures.end(), [&](const TextureReference& texture)
+	{
+		return texture.m_Path == path && texture.m_Format == format;
+	});
+	if (it != m_Textures.end()) return static_cast<uint32_t>(it - m_Textures.begin());
+
+	m_Textures.push_back({ path, format });
+	return static_cast<uint32_t>(m_Textures.size() - 1u);
+}
+
+void DrawCapture::Clear()
+{
+	m_MeshPaths.clear();
+	m_Textures.clear();
+	m_Frames.clear();
+}
+
+bool DrawCapture::Write(const std::string& path) const
+{
+	std::error_code error;
+	const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	if (!directory.empty()) std::filesystem::create_directories(directory, error);
+
+	std::ofstream stream(path, std::ios::binary);
+	if (!stream) return false;
+
+	bool written =
+		WriteValue(stream, CaptureMagic) &&
+		WriteValue(stream, static_cast<uint32_t>(m_MeshPaths.size())) &&
+		WriteValue(stream, static_cast<uint32_t>(m_Textures.size())) &&
+		WriteValue(stream, static_cast<uint32_t>(m_Frames.size()));
+
+	for (const std::string& meshPath : m_MeshPaths)
+	{
+		written = written && WriteString(stream, meshPath);
+	}
+	for (const TextureReference& texture : m_Textures)
+	{
+		written = written && WriteString(stream, texture.m_Path) && WriteValue(stream, static_cast<uint32_t>(texture.m_Format));
+	}
+
+	for (const Frame& frame : m_Frames)
+	{
+		const FrameRecord record =
+		{
+			static_cast<uint8_t>(frame.m_RasterizationMode),
+			static_cast<uint8_t>(frame.m_PixelTraversal),
+			frame.m_BackgroundColor,
+			static_cast<uint8_t>(frame.m_Shadowed),
+			frame.m_AntiAliasing,
+			{ frame.m_SunDirection.x, frame.m_SunDirection.y, frame.m_SunDirection.z },
+			frame.m_ShadowResolution,
+			frame.m_ShadowFilterSize,
+			frame.m_ShadowDepthBias,
+			frame.m_ShadowViewProjection,
+			frame.m_ViewToLightClip,
+			static_cast<uint32_t>(frame.m_ShadowDraws.size()),
+			static_cast<uint32_t>(frame.m_Draws.size())
+		};
+
+		written = written &&
+			WriteValue(stream, record) &&
+			WriteArray(stream, frame.m_ShadowDraws) &&
+			WriteArray(stream, frame.m_Draws);
+	}
+
+	return written;
+}
+
+bool DrawCapture::Read(const std::string& path)
+{
+	Clear();
+
+	std::ifstream stream(path, std::ios::binary);
+
+	uint32_t magic, meshCount, textureCount, frameCount;
+	if (!ReadValue(stream, magic) || magic != CaptureMagic ||
+		!ReadValue(stream, meshCount) || !ReadValue(stream, textureCount) || !ReadValue(stream, frameCount) ||
+		meshCount > MaxCount || textureCount > MaxCount || frameCount > MaxCount)
+	{
+		return false;
+	}
+
+	bool read = true;
+	m_MeshPaths.resize(meshCount);
+	for (std::string& meshPath : m_MeshPaths)
+	{
+		read = read && ReadString(stream, meshPath);
+	}
+
+	m_Textures.resize(textureCount);
+	for (TextureReference& texture : m_Textures)
+	{
+		uint32_t format = 0u;
+		read = read && ReadString(stream, texture.m_Path) && ReadValue(stream, format) && format <= static_cast<uint32_t>(Texture::Format::BC1);
+		texture.m_Format = static_cast<Texture::Format>(format);
+	}
+
+	m_Frames.resize(read ? frameCount : 0u);
+	for (Frame& frame : m_Frames)
+	{
+		FrameRecord record;
+		read = read && ReadValue(stream, record) && record.m_ShadowDrawCount <= MaxCount && record.m_DrawCount <= MaxCount &&
+			ReadArray(stream, frame.m_ShadowDraws, record.m_ShadowDrawCount) &&
+			ReadArray(stream, frame.m_Draws, record.m_DrawCount);
+		if (!read) break;
+
+		frame.m_RasterizationMode = static_cast<RasterizationMode>(record.m_RasterizationMode);
+		frame.m_PixelTraversal = static_cast<PixelTraversal>(record.m_PixelTraversal);
+		frame.m_BackgroundColor = record.m_BackgroundColor;
+		frame.m_Shadowed = record.m_Shadowed != 0u;
+		frame.m_AntiAliasing = record.m_AntiAliasing;
+		frame.m_SunDirection = Vec3(record.m_SunDirection[0], record.m_SunDirection[1], record.m_SunDirection[2]);
+		frame.m_ShadowResolution = record.m_ShadowResolution;
+		frame.m_ShadowFilterSize = record.m_ShadowFilterSize;
+		frame.m_ShadowDepthBias = record.m_ShadowDepthBias;
+		frame.m_ShadowViewProjection = record.m_ShadowViewProjection;
+		frame.m_ViewToLightClip = record.m_ViewToLightClip;
+
+		// Every reference has to point into the lists, and the state has to be something the renderer accepts
+		read = read &&
+			record.m_RasterizationMode <= static_cast<uint8_t>(RasterizationMode::Homogeneous) &&
+			record.m_PixelTraversal <= static_cast<uint8_t>(PixelTraversal::Blocks) &&
+			record.m_AntiAliasing >= NoAntiAliasing && record.m_AntiAliasing <= static_cast<int32_t>(MultisampleTarget::Mode::SSAA4x) &&
+			(!frame.m_Shadowed || (record.m_ShadowResolution > 0 && record.m_ShadowResolution <= MaxShadowResolution && record.m_ShadowFilterSize > 0 && record.m_ShadowFilterSize % 2 == 1));
+		for (const ShadowDraw& draw : frame.m_ShadowDraws) read = read && draw.m_Mesh < meshCount;
+		for (const Draw& draw : frame.m_Draws) read = read && draw.m_Mesh < meshCount && draw.m_Texture < textureCount;
+	}
+
+	if (!read)
+	{
+		Clear();
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
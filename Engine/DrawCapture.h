@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GraphicsPipeline.h"
+#include "Mat4.h"
+#include "Texture.h"
+#include "Vec3.h"
+
+// Frames of the textured renderer as streams of draws, everything needed to draw them again without the scene.
+// Meshes and textures are referenced by path (and format), the draws by index into those lists, so a capture
+// of many frames stays small. Written to and read from a compact binary file, see DrawReplay.
+class DrawCapture
+{
+public:
+	struct TextureReference
+	{
+		std::string m_Path;
+		Texture::Format m_Format;
+	};
+
+	// Depth pass into the frame's shadow map
+	struct ShadowDraw
+	{
+		uint32_t m_Mesh;
+		Mat4 m_ModelTransform;
+	};
+
+	// Main pass through the textured program
+	struct Draw
+	{
+		uint32_t m_Mesh;
+		uint32_t m_Texture;
+		Mat4 m_MVP;
+		Mat4 m_MV;
+		Mat4 m_P;
+	};
+
+	struct Frame
+	{
+		RasterizationMode m_RasterizationMode = RasterizationMode::Scanline;
+		PixelTraversal m_PixelTraversal = PixelTraversal::Rows;
+		// NoAntiAliasing or a MultisampleTarget::Mode
+		int32_t m_AntiAliasing = NoAntiAliasing;
+		uint8_t m_BackgroundColor = 0u;
+
+		// Directional sun in view space. With m_Shadowed the shadow map is drawn first and the main pass
+		// looks it up through m_ViewToLightClip.
+		Vec3 m_SunDirection;
+		bool m_Shadowed = false;
+		int32_t m_ShadowResolution = 0;
+		int32_t m_ShadowFilterSize = 1;
+		float m_ShadowDepthBias = 0.0f;
+		Mat4 m_ShadowViewProjection;
+		Mat4 m_ViewToLightClip;
+
+		std::vector<ShadowDraw> m_ShadowDraws;
+		std::vector<Draw> m_Draws;
+	};
+
+	// Index of the path, the same one for every call with the same path
+	uint32_t AddMesh(const std::string& path);
+	uint32_t AddTexture(const std::string& path, Texture::Format format);
+	void AddFrame(Frame frame) { m_Frames.push_back(std::move(frame)); }
+	void Clear();
+
+	const std::vector<std::string>& GetMeshPaths() const { return m_MeshPaths; }
+	const std::vector<TextureReference>& GetTextures() const { return m_Textures; }
+	const std::vector<Frame>& GetFrames() const { return m_Frames; }
+
+	// Creates the directory of the file when needed
+	bool Write(const std::string& path) const;
+	// Leaves the capture empty when the file can't be read or wasn't written by this version
+	bool Read(const std::string& path);
+
+	static constexpr int32_t NoAntiAliasing = -1;
+
+private:
+	std::vector<std::string> m_MeshPaths;
+	std::vector<TextureReference> m_Textures;
+	std::vector<Frame> m_Frames;
+};
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include "DrawReplay.h"
+#include "AssetManager.h"
+#include "Benchmarking.h"
+#include "CommandBuffer.h"
+#include "DrawCapture.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "MultisampleTarget.h"
+#include "PipelineProfiler.h"
+#include "ShadowMap.h"
+#include "TexturedDirectionalLightningShaderProgram.h"
+
+namespace
+{
+	// FNV-1a over the colors of the frame being drawn
+	uint64_t HashImage(const Graphics& graphics)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (int y = 0; y < static_cast<int>(Graphics::ScreenHeight); y++)
+		{
+			for (int x = 0; x < static_cast<int>(Graphics::ScreenWidth); x++)
+			{
+				const unsigned int color = graphics.GetPixel(x, y).dword & 0xFFFFFFu;
+				for (int i = 0; i < 3; i++)
+				{
+					hash ^= (color >> (8 * i)) & 0xFFu;
+					hash *= 1099511628211ull;
+				}
+			}
+		}
+
+		return hash;
+	}
+}
+
+std::string DrawReplay::Run(Graphics& graphics, JobSystem& jobs, const std::string& capturePath, int repetitions)
+{
+	std::ostringstream report;
+
+	DrawCapture capture;
+	if (!capture.Read(capturePath))
+	{
+		report << "Replay: can't read the capture " << capturePath << "\n";
+		return report.str();
+	}
+	if (capture.GetFrames().empty())
+	{
+		report << "Replay: " << capturePath << " holds no frames\n";
+		return report.str();
+	}
+
+	typedef TexturedDirectionalLightningShaderProgram Program;
+	typedef UnshadowedTexturedDirectionalLightningShaderProgram UnshadowedProgram;
+	static_assert(std::is_same_v<Program::VSIn, UnshadowedProgram::VSIn>, "Both programs draw the same vertices");
+
+	// Everything is loaded before the first frame, loading shouldn't show up in the frame times
+	AssetManager assets;
+	assets.SetJobSystem(&jobs);
+
+	std::vector<std::shared_ptr<const Mesh>> meshes;
+	std::vector<std::vector<Program::VSIn>> meshInputs;
+	for (const std::string& path : capture.GetMeshPaths())
+	{
+		const auto pMesh = assets.LoadMesh(path);
+		if (pMesh == nullptr)
+		{
+			report << "Replay: can't load the mesh " << path << "\n";
+			return report.str();
+		}
+
+		std::vector<Program::VSIn> input;
+		for (size_t i = 0; i < pMesh->GetVertices().size(); i++)
+		{
+			input.push_back({ pMesh->GetVertices()[i], pMesh->GetNormals()[i], pMesh->GetUvCoordinates()[i] });
+		}
+
+		meshes.push_back(pMesh);
+		meshInputs.push_back(std::move(input));
+	}
+
+	std::vector<std::shared_ptr<const Texture>> textures;
+	for (const DrawCapture::TextureReference& reference : capture.GetTextures())
+	{
+		const auto pTexture = assets.LoadTexture(reference.m_Path, reference.m_Format);
+		if (pTexture == nullptr)
+		{
+			report << "Replay: can't load the texture " << reference.m_Path << "\n";
+			return report.str();
+		}
+
+		textures.push_back(pTexture);
+	}
+
+	GraphicsPipeline<Program> pipeline(graphics);
+	GraphicsPipeline<UnshadowedProgram> unshadowedPipeline(graphics);
+	pipeline.SetJobSystem(&jobs);
+	unshadowedPipeline.SetJobSystem(&jobs);
+	CommandBuffer<Program> commands;
+	CommandBuffer<UnshadowedProgram> unshadowedCommands;
+
+	// Created on first use, one per resolution and filter size and one per anti-aliasing mode
+	std::map<std::pair<int32_t, int32_t>, std::unique_ptr<ShadowMap>> shadowMaps;
+	std::map<int32_t, std::unique_ptr<MultisampleTarget>> multisampleTargets;
+	// Set for the profiled pass only
+	PipelineProfiler* pShadowProfiler = nullptr;
+
+	auto record = [&](auto& commandBuffer, const DrawCapture::Frame& frame)
+	{
+		commandBuffer.Clear();
+		for (const DrawCapture::Draw& draw : frame.m_Draws)
+		{
+			commandBuffer.BindIndices(meshes[draw.m_Mesh]->GetIndices());
+			commandBuffer.BindVertices(meshInputs[draw.m_Mesh]);
+			commandBuffer.BindTexture(textures[draw.m_Texture]);
+			commandBuffer.SetConstants({ draw.m_MVP, draw.m_MV, draw.m_P });
+			commandBuffer.Draw();
+		}
+	};
+
+	auto drawFrame = [&](const DrawCapture::Frame& frame)
+	{
+		MultisampleTarget* pMultisampleTarget = nullptr;
+		if (frame.m_AntiAliasing != DrawCapture::NoAntiAliasing)
+		{
+			auto& pTarget = multisampleTargets[frame.m_AntiAliasing];
+			if (!pTarget)
+			{
+				pTarget = std::make_unique<MultisampleTarget>(Graphics::ScreenWidth, Graphics::ScreenHeight, static_cast<MultisampleTarget::Mode>(frame.m_AntiAliasing));
+			}
+
+			pMultisampleTarget = pTarget.get();
+			pMultisampleTarget->Clear(Color(frame.m_BackgroundColor, frame.m_BackgroundColor, frame.m_BackgroundColor));
+		}
+
+		if (frame.m_Shadowed)
+		{
+			auto& pShadowMap = shadowMaps[{ frame.m_ShadowResolution, frame.m_ShadowFilterSize }];
+			if (!pShadowMap)
+			{
+				pShadowMap = std::make_unique<ShadowMap>(graphics, frame.m_ShadowResolution, frame.m_ShadowFilterSize);
+				pShadowMap->SetJobSystem(&jobs);
+			}
+
+			pShadowMap->SetProfiler(pShadowProfiler);
+			pShadowMap->SetViewProjection(frame.m_ShadowViewProjection);
+			pShadowMap->SetDepthBias(frame.m_ShadowDepthBias);
+			pShadowMap->BeginPass();
+			for (const DrawCapture::ShadowDraw& draw : frame.m_ShadowDraws)
+			{
+				pShadowMap->Draw(*meshes[draw.m_Mesh], draw.m_ModelTransform);
+			}
+			pShadowMap->EndPass();
+
+			auto& pixelShader = pipeline.GetPixelShader();
+			pixelShader.ClearLights();
+			pixelShader.AddLight(Program::Light::Directional(frame.m_SunDirection, pShadowMap.get(), frame.m_ViewToLightClip));
+
+			pipeline.BindMultisampleTarget(pMultisampleTarget);
+			pipeline.SetRasterizationMode(frame.m_RasterizationMode);
+			pipeline.SetPixelTraversal(frame.m_PixelTraversal);
+			record(commands, frame);
+			pipeline.ClearZBuffer();
+			pipeline.Execute(commands);
+		}
+		else
+		{
+			auto& pixelShader = unshadowedPipeline.GetPixelShader();
+			pixelShader.ClearLights();
+			pixelShader.AddLight(UnshadowedProgram::Light::Directional(frame.m_SunDirection));
+
+			unshadowedPipeline.BindMultisampleTarget(pMultisampleTarget);
+			unshadowedPipeline.SetRasterizationMode(frame.m_RasterizationMode);
+			unshadowedPipeline.SetPixelTraversal(frame.m_PixelTraversal);
+			record(unshadowedCommands, frame);
+			unshadowedPipeline.ClearZBuffer();
+			unshadowedPipeline.Execute(unshadowedCommands);
+		}
+
+		if (pMultisampleTarget) pMultisampleTarget->Resolve(graphics);
+	};
+
+	// Time spent drawing, not waiting for the presentation of earlier frames in BeginFrame
+	std::vector<double> frameMilliseconds;
+	uint64_t imageHash = 0u;
+	for (int repetition = 0; repetition < repetitions; repetition++)
+	{
+		for (size_t i = 0; i < capture.GetFrames().size(); i++)
+		{
+			const DrawCapture::Frame& frame = capture.GetFrames()[i];
+
+			FrameArena::BeginFrame();
+			graphics.SetBackgroundColor(frame.m_BackgroundColor);
+			graphics.BeginFrame();
+
+			const auto start = std::chrono::steady_clock::now();
+			drawFrame(frame);
+			const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			frameMilliseconds.push_back(elapsed.count());
+
+			if (repetition == repetitions - 1 && i == capture.GetFrames().size() - 1u)
+			{
+				imageHash = HashImage(graphics);
+			}
+			graphics.EndFrame();
+		}
+	}
+
+	// Once more with profilers, reading counters around every triangle would skew the frame times
+	int32_t shadowResolution = 0;
+	for (const DrawCapture::Frame& frame : capture.GetFrames())
+	{
+		if (frame.m_Shadowed) shadowResolution = std::max(shadowResolution, frame.m_ShadowResolution);
+	}
+
+	PipelineProfiler profiler;
+	PipelineProfiler shadowProfiler(true, std::max(shadowResolution, 1), std::max(shadowResolution, 1));
+	pipeline.SetProfiler(&profiler);
+	unshadowedPipeline.SetProfiler(&profiler);
+	pShadowProfiler = &shadowProfiler;
+	for (const DrawCapture::Frame& frame : capture.GetFrames())
+	{
+		FrameArena::BeginFrame();
+		graphics.SetBackgroundColor(frame.m_BackgroundColor);
+		graphics.BeginFrame();
+		drawFrame(frame);
+		graphics.EndFrame();
+	}
+
+	report << "Replay of " << capturePath << ", " << capture.GetFrames().size() << " frames " << repetitions << " times\n";
+	Benchmarking::ReportFrameTimes(report, std::move(frameMilliseconds));
+	report << "  last image hash " << std::hex << std::setw(16) << std::setfill('0') << imageHash << std::dec << "\n";
+	report << profiler.GetReport("Main passes");
+	if (shadowResolution > 0) report << shadowProfiler.GetReport("Shadow passes");
+
+	return report.str();
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+class Graphics;
+class JobSystem;
+
+// Draws the frames of a DrawCapture again, without the scene that recorded them, so changes to the pipeline
+// can be compared on the same workload. Every frame is drawn as the preview scene draws it (shadow pass, main pass,
+// resolve) and the capture is played repetitions times. Reports the min, median and p99 of the time spent drawing
+// a frame, and a hash of the last image, which has to stay the same for changes that shouldn't change the output.
+// A last, untimed play of the capture reports the costs of the pipeline stages (see PipelineProfiler).
+// Runs from the windowed build's -replay argument, and without a window from Headless/ on any platform.
+class DrawReplay
+{
+public:
+	// A report of what went wrong when the capture can't be read
+	static std::string Run(Graphics& graphics, JobSystem& jobs, const std::string& capturePath, int repetitions = 10);
+};
\ No newline at end of file
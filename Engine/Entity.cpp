@@ -1,46 +1,55 @@
-#include <Windows.h>
+#ifdef ENGINE_HEADLESS
+	#include <iostream>
+#else
+	#include <Windows.h>
+#endif
 
 #include "Entity.h"
-#include "OBJ_Loader.h"
 
 Entity::Entity(const std::vector<Vec3>& vertices, const std::vector<Vec3>& normals, const std::vector<size_t>& indices, const Vec3& position, const Vec3& eulerAngles)
 	:
-	m_Vertices(vertices),
-	m_Normals(normals),
-	m_Indices(indices),
-	m_Position(position),
-	m_EulerAngles(eulerAngles)
+	Entity(std::make_shared<const Mesh>(vertices, normals, indices), position, eulerAngles)
 {
-	UpdateModelTransform();
 }
 
 Entity::Entity(const std::string& modelPath, const Vec3& position, const Vec3& eulerAngles)
+	:
+	Entity(LoadModelFromFile(modelPath), position, eulerAngles)
+{
+}
+
+Entity::Entity(std::shared_ptr<const Mesh> pMesh, const Vec3& position, const Vec3& eulerAngles)
 	:
 	m_Position(position),
 	m_EulerAngles(eulerAngles)
 {
-	LoadModelFromFile(modelPath);
+	SetMesh(std::move(pMesh));
 	UpdateModelTransform();
 }
 
+void Entity::SetMesh(std::shared_ptr<const Mesh> pMesh)
+{
+	m_pMesh = pMesh != nullptr ? std::move(pMesh) : std::make_shared<const Mesh>();
+}
+
 const std::vector<size_t>& Entity::GetIndices() const
 {
-	return m_Indices;
+	return m_pMesh->GetIndices();
 }
 
 const std::vector<Vec3>& Entity::GetVertices() const
 {
-	return m_Vertices;
+	return m_pMesh->GetVertices();
 }
 
 const std::vector<Vec3>& Entity::GetNormals() const
 {
-	return m_Normals;
+	return m_pMesh->GetNormals();
 }
 
 const std::vector<Vec2>& Entity::GetUvCoordinates() const
 {
-	return m_UvCoordinates;
+	return m_pMesh->GetUvCoordinates();
 }
 
 void Entity::SetPosition(const Vec3& position)
@@ -78,32 +87,19 @@ Mat4 Entity::GetModelTransform() const
 	return m_ModelTransform;
 }
 
-void Entity::LoadModelFromFile(const std::string& path)
+std::shared_ptr<const Mesh> Entity::LoadModelFromFile(const std::string& path)
 {
-	objl::Loader loader;
-	if (loader.LoadFile(path))
-	{
-		m_Indices.clear();
-		m_Vertices.clear();
-		m_UvCoordinates.clear();
-		m_Normals.clear();
-
-		for (auto index : loader.LoadedIndices)
-		{
-			m_Indices.push_back(index);
-		}
-
-		for (const auto& vertex : loader.LoadedVertices)
-		{
-			m_Vertices.push_back(Vec3(vertex.Position.X, vertex.Position.Y, vertex.Position.Z));
-			m_UvCoordinates.push_back(Vec2(vertex.TextureCoordinate.X, vertex.TextureCoordinate.Y));
-			m_Normals.push_back(Vec3(vertex.Normal.X, vertex.Normal.Y, vertex.Normal.Z));
-		}
-	}
-	else
+	auto pMesh = std::make_shared<Mesh>();
+	if (!pMesh->Load(path))
 	{
+#ifdef ENGINE_HEADLESS
+		std::cerr << "ERROR: LoadModelFromFile WRONG PATH!\n";
+#else
 		OutputDebugStringA("ERROR: LoadModelFromFile WRONG PATH!\n");
+#endif
 	}
+
+	return pMesh;
 }
 
 void Entity::UpdateModelTransform()
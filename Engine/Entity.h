@@ -1,9 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "Mat4.h"
+#include "Mesh.h"
 
 class Entity
 {
@@ -17,6 +19,7 @@ public:
 		const Vec3& eulerAngles = Vec3::Zero()
 	);
 
+	// Loads a mesh of its own, entities that should share one get it from an AssetManager instead
 	Entity
 	(
 		const std::string& modelPath,
@@ -24,6 +27,17 @@ public:
 		const Vec3& eulerAngles = Vec3::Zero()
 	);
 
+	Entity
+	(
+		std::shared_ptr<const Mesh> pMesh,
+		const Vec3& position = Vec3::Zero(),
+		const Vec3& eulerAngles = Vec3::Zero()
+	);
+
+	const std::shared_ptr<const Mesh>& GetMesh() const { return m_pMesh; }
+	// nullptr leaves the entity with an empty mesh, which draws nothing
+	void SetMesh(std::shared_ptr<const Mesh> pMesh);
+
 	const std::vector<size_t>& GetIndices() const;
 	const std::vector<Vec3>& GetVertices() const;
 	const std::vector<Vec3>& GetNormals() const;
@@ -42,12 +56,9 @@ public:
 	void UpdateModelTransform();
 
 private:
-	void LoadModelFromFile(const std::string& path);
+	static std::shared_ptr<const Mesh> LoadModelFromFile(const std::string& path);
 
-	std::vector<size_t> m_Indices;
-	std::vector<Vec3> m_Vertices;
-	std::vector<Vec3> m_Normals;
-	std::vector<Vec2> m_UvCoordinates;
+	std::shared_ptr<const Mesh> m_pMesh;
 
 	Vec3 m_Position;
 	Vec3 m_EulerAngles;
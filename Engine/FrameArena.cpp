@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+
+#include "FrameArena.h"
+#include "AllocationTracker.h"
+
+namespace
+{
+	// Frames begun so far. Each thread resets its own arena the first time it takes it in a new frame,
+	// so no thread ever touches the arena of another.
+	std::atomic<uint64_t> s_Frame{ 0u };
+
+	struct ThreadArena
+	{
+		FrameArena m_Arena;
+		uint64_t m_Frame = 0u;
+	};
+}
+
+FrameArena::FrameArena(size_t chunkBytes)
+	:
+	m_ChunkBytes(chunkBytes)
+{
+}
+
+FrameArena::~FrameArena() = default;
+
+void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+	assert(alignment != 0u && (alignment & (alignment - 1u)) == 0u);
+
+	for (; m_Chunk < m_Chunks.size(); m_Chunk++, m_Offset = 0u)
+	{
+		Chunk& chunk = m_Chunks[m_Chunk];
+		const uintptr_t address = reinterpret_cast<uintptr_t>(chunk.m_pMemory.get()) + m_Offset;
+		const size_t start = m_Offset + ((alignment - address % alignment) % alignment);
+		if (start + bytes <= chunk.m_Bytes)
+		{
+			m_Offset = start + bytes;
+			return chunk.m_pMemory.get() + start;
+		}
+	}
+
+	// Nothing left that fits, the new chunk goes after all of them, with room for the alignment
+	const size_t chunkBytes = std::max(m_ChunkBytes, bytes + alignment);
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Pipeline);
+	m_Chunks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[chunkBytes]), chunkBytes });
+	m_Chunk = m_Chunks.size() - 1u;
+	m_Offset = 0u;
+	return Allocate(bytes, alignment);
+}
+
+void FrameArena::Reset()
+{
+	if (m_Chunks.size() > 1u)
+	{
+		const size_t capacityBytes = GetCapacityBytes();
+		AllocationTracker::TagScope tag(AllocationTracker::Tag::Pipeline);
+		m_Chunks.clear();
+		m_Chunks.push_back({ std::unique_ptr<unsigned char[]>(new unsigned char[capacityBytes]), capacityBytes });
+	}
+
+	m_Chunk = 0u;
+	m_Offset = 0u;
+}
+
+size_t FrameArena::GetUsedBytes() const
+{
+	size_t usedBytes = m_Offset;
+	for (size_t i = 0u; i < m_Chunk && i < m_Chunks.size(); i++) usedBytes += m_Chunks[i].m_Bytes;
+	return usedBytes;
+}
+
+size_t FrameArena::GetCapacityBytes() const
+{
+	size_t capacityBytes = 0u;
+	for (const Chunk& chunk : m_Chunks) capacityBytes += chunk.m_Bytes;
+	return capacityBytes;
+}
+
+FrameArena& FrameArena::ForThisThread()
+{
+	thread_local ThreadArena s_Arena;
+
+	const uint64_t frame = s_Frame.load(std::memory_order_acquire);
+	if (s_Arena.m_Frame != frame)
+	{
+		s_Arena.m_Arena.Reset();
+		s_Arena.m_Frame = frame;
+	}
+	return s_Arena.m_Arena;
+}
+
+void FrameArena::BeginFrame()
+{
+	s_Frame.fetch_add(1u, std::memory_order_release);
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Linear allocator for data that lives no longer than a frame. Allocating bumps an offset, freeing does nothing,
+// and everything is released at once, either by rewinding a Scope or by BeginFrame.
+// The chunks are kept between frames, so once the arena has grown to the largest frame it never calls malloc again.
+// Every thread has an arena of its own, an arena must only be used by its thread.
+class FrameArena
+{
+public:
+	// Rewinds the arena to where it was when the scope was created
+	class Scope
+	{
+	public:
+		explicit Scope(FrameArena& arena) : m_Arena(arena), m_Chunk(arena.m_Chunk), m_Offset(arena.m_Offset) { }
+		~Scope() { m_Arena.m_Chunk = m_Chunk; m_Arena.m_Offset = m_Offset; }
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		FrameArena& m_Arena;
+		size_t m_Chunk;
+		size_t m_Offset;
+	};
+
+	explicit FrameArena(size_t chunkBytes = DefaultChunkBytes);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void* Allocate(size_t bytes, size_t alignment);
+
+	// Releases everything. A frame that needed more than one chunk leaves one chunk large enough for all of it.
+	void Reset();
+
+	// Bytes up to the current position (including what alignment and chunk ends skipped), and bytes held in chunks
+	size_t GetUsedBytes() const;
+	size_t GetCapacityBytes() const;
+
+	// The calling thread's arena, reset first when it's taken for the first time since BeginFrame
+	static FrameArena& ForThisThread();
+	// Starts a new frame, nothing allocated from the arena of any thread may be in use any more.
+	// The arenas aren't touched here, every thread resets its own the next time it takes it.
+	static void BeginFrame();
+
+	static constexpr size_t DefaultChunkBytes = 1024u * 1024u;
+
+private:
+	struct Chunk
+	{
+		std::unique_ptr<unsigned char[]> m_pMemory;
+		size_t m_Bytes;
+	};
+
+	size_t m_ChunkBytes;
+	std::vector<Chunk> m_Chunks;
+	// Allocations come from m_Chunks[m_Chunk] at m_Offset, the chunks before it are full
+	size_t m_Chunk = 0u;
+	size_t m_Offset = 0u;
+};
+
+// Standard allocator handing out memory of a FrameArena, so std::vector can hold transient data.
+// Deallocation is a no-op: reserve the final size up front, growing leaves the old buffers behind until the arena is reset.
+template <class T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	explicit FrameAllocator(FrameArena& arena) : m_pArena(&arena) { }
+	template <class U> FrameAllocator(const FrameAllocator<U>& other) : m_pArena(other.m_pArena) { }
+
+	T* allocate(size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "Arena memory is never destroyed, only trivially destructible types may live in it");
+		return static_cast<T*>(m_pArena->Allocate(count * sizeof(T), alignof(T)));
+	}
+	void deallocate(T*, size_t) { }
+
+	template <class U> bool operator==(const FrameAllocator<U>& other) const { return m_pArena == other.m_pArena; }
+	template <class U> bool operator!=(const FrameAllocator<U>& other) const { return m_pArena != other.m_pArena; }
+
+private:
+	template <class U> friend class FrameAllocator;
+
+	FrameArena* m_pArena;
+};
+
+template <class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
\ No newline at end of file
@@ -20,24 +20,166 @@
  ******************************************************************************************/
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <chrono>
+#include <fstream>
+#include <sstream>
 
 #include "MainWindow.h"
 #include "Game.h"
+#include "FrameArena.h"
+#include "BenchmarkSuite.h"
+#include "DrawReplay.h"
 
 Game::Game( MainWindow& wnd )
 	:
 	wnd( wnd ),
 	gfx( wnd ),
-	scene(gfx, wnd)
+	scene(gfx, wnd, jobs)
 {
+	ParseArgs( wnd.GetArgs() );
 	scene.Start();
 }
 
+Game::~Game()
+{
+	if( input.IsRecording() )
+	{
+		input.Stop();
+		const std::string report = input.Write( inputPath )
+			? "Recorded " + std::to_string( input.GetFrameCount() ) + " frames of input to " + inputPath + "\n"
+			: "Can't write the input recording to " + inputPath + "\n";
+		OutputDebugStringA( report.c_str() );
+	}
+}
+
+void Game::ParseArgs( const std::wstring& args )
+{
+	// paths are plain ascii, like the asset paths
+	auto narrow = []( const std::wstring& arg )
+	{
+		std::string path;
+		for( wchar_t c : arg )
+		{
+			path.push_back( char( c ) );
+		}
+		return path;
+	};
+
+	std::wistringstream stream( args );
+	std::wstring arg;
+	while( stream >> arg )
+	{
+		if( arg == L"-replay" && stream >> arg )
+		{
+			replayPath = narrow( arg );
+			int repetitions;
+			if( stream >> repetitions && repetitions > 0 )
+			{
+				replayRepetitions = repetitions;
+			}
+			stream.clear();
+		}
+		else if( arg == L"-recordinput" && stream >> arg )
+		{
+			inputPath = narrow( arg );
+			input.StartRecording( wnd.kbd,wnd.mouse );
+		}
+		else if( arg == L"-replayinput" && stream >> arg )
+		{
+			inputPath = narrow( arg );
+			if( input.Read( inputPath ) )
+			{
+				input.StartPlayback( wnd.kbd,wnd.mouse );
+				// the frames are timed, reports and files written from the keys would be in them
+				scene.SetDebugKeysEnabled( false );
+			}
+			else
+			{
+				const std::string report = "Can't read the input recording " + inputPath + "\n";
+				OutputDebugStringA( report.c_str() );
+			}
+		}
+		else if( arg == L"-benchmark" && stream >> arg )
+		{
+			benchmarkPath = narrow( arg );
+		}
+		else if( arg == L"-baseline" && stream >> arg )
+		{
+			benchmarkBaselinePath = narrow( arg );
+		}
+	}
+}
+
+void Game::RunReplay()
+{
+	const std::string report = DrawReplay::Run( gfx,jobs,replayPath,replayRepetitions );
+	OutputDebugStringA( report.c_str() );
+	std::ofstream( replayPath + ".txt" ) << report;
+
+	replayPath.clear();
+	wnd.Kill();
+}
+
+void Game::FinishInputReplay()
+{
+	std::ostringstream report;
+	report << "Input replay of " << inputPath << ", " << input.GetFrameCount() << " frames at a fixed "
+		<< InputRecording::FixedTimestep * 1000.0f << " ms step\n";
+	Benchmarking::ReportFrameTimes( report,std::move( inputReplayFrameMs ) );
+	OutputDebugStringA( report.str().c_str() );
+	std::ofstream( inputPath + ".txt" ) << report.str();
+
+	input.Stop();
+	wnd.Kill();
+}
+
+void Game::RunBenchmarks()
+{
+	// pipelines draw into the frame like the scene does
+	gfx.BeginFrame();
+	const std::vector<Benchmarking::Result> results = BenchmarkSuite::Run( gfx,jobs );
+	gfx.EndFrame();
+
+	const std::string report = BenchmarkSuite::Save( results,benchmarkPath,benchmarkBaselinePath );
+	OutputDebugStringA( report.c_str() );
+
+	benchmarkPath.clear();
+	wnd.Kill();
+}
+
 void Game::Go()
 {
+	if( !benchmarkPath.empty() )
+	{
+		RunBenchmarks();
+		return;
+	}
+
+	if( !replayPath.empty() )
+	{
+		RunReplay();
+		return;
+	}
+
+	if( input.IsPlaying() && input.IsPlaybackFinished() )
+	{
+		FinishInputReplay();
+		return;
+	}
+
+	// Nothing of the previous frame is in use any more
+	FrameArena::BeginFrame();
 	gfx.BeginFrame();
+	// hands over the recorded input of this frame before the scene reads it
+	input.BeginFrame();
+	const auto start = std::chrono::steady_clock::now();
 	UpdateModel();
 	ComposeFrame();
+	if( input.IsPlaying() )
+	{
+		const std::chrono::duration<double,std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		inputReplayFrameMs.push_back( elapsed.count() );
+	}
 	gfx.EndFrame();
 }
 
@@ -23,6 +23,8 @@
 #include "Keyboard.h"
 #include "Mouse.h"
 #include "Graphics.h"
+#include "InputRecording.h"
+#include "JobSystem.h"
 #include "ModelPreviewScene.h"
 #include "Mat4.h"
 
@@ -30,12 +32,22 @@ class Game
 {
 public:
 	Game( class MainWindow& wnd );
+	// writes the input recorded with -recordinput
+	~Game();
 	Game( const Game& ) = delete;
 	Game& operator=( const Game& ) = delete;
 	void Go();
 private:
 	void ComposeFrame();
 	void UpdateModel();
+	// -replay <capture> [repetitions] on the command line draws the capture instead of the scene and quits,
+	// -recordinput <file> records the keyboard and mouse until the window closes,
+	// -replayinput <file> runs the scene on that input instead and quits with a report of the frame times,
+	// -benchmark <results.json> [-baseline <results.json>] runs the benchmark suite and quits
+	void ParseArgs( const std::wstring& args );
+	void RunReplay();
+	void FinishInputReplay();
+	void RunBenchmarks();
 	/********************************/
 	/*  User Functions              */
 	/********************************/
@@ -46,5 +58,19 @@ private:
 	/*  User Variables              */
 	/********************************/
 
+	// Before the scene, which hands work to it from Update and Draw
+	JobSystem jobs;
+
 	ModelPreviewScene scene;
+
+	std::string replayPath;
+	int replayRepetitions = 10;
+
+	InputRecording input;
+	std::string inputPath;
+	// update and draw of every frame during an input replay
+	std::vector<double> inputReplayFrameMs;
+
+	std::string benchmarkPath;
+	std::string benchmarkBaselinePath;
 };
\ No newline at end of file
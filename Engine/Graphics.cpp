@@ -25,6 +25,12 @@
 #include <assert.h>
 #include <string>
 #include <array>
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <utility>
 
 // Ignore the intellisense error "cannot open source file" for .shh files.
 // They will be created during the build sequence before the preprocessor runs.
@@ -40,6 +46,10 @@ namespace FramebufferShaders
 
 using Microsoft::WRL::ComPtr;
 
+// screen is split into 16x16 lazily cleared tiles, both dimensions are multiples of the tile size
+static constexpr int ClearTilesX = Graphics::ScreenWidth >> 4;
+static constexpr int ClearTilesY = Graphics::ScreenHeight >> 4;
+
 Graphics::Graphics( HWNDKey& key )
 {
 	assert( key.hWnd != nullptr );
@@ -235,24 +245,121 @@ Graphics::Graphics( HWNDKey& key )
 		throw CHILI_GFX_EXCEPTION( hr,L"Creating sampler state" );
 	}
 
-	// allocate memory for sysbuffer (16-byte aligned for faster access)
-	pSysBuffer = reinterpret_cast<Color*>( 
-		_aligned_malloc( sizeof( Color ) * Graphics::ScreenWidth * Graphics::ScreenHeight,16u ) );
+	// allocate memory for sysbuffers (16-byte aligned for faster access)
+	for( int i = 0; i < MaxSysBuffers; i++ )
+	{
+		pSysBuffers[i] = reinterpret_cast<Color*>(
+			_aligned_malloc( sizeof( Color ) * Graphics::ScreenWidth * Graphics::ScreenHeight,16u ) );
+		sysBufferTileFrames[i].assign( ClearTilesX * ClearTilesY,0u );
+		freeBuffers.push_back( i );
+	}
+
+	// from here on the device context belongs to the present thread
+	presentThread = std::thread( &Graphics::PresentThreadMain,this );
 }
 
 Graphics::~Graphics()
 {
+	// let the present thread drain the queue and exit before anything it uses goes away
+	{
+		std::lock_guard<std::mutex> lock( presentMutex );
+		stopPresenting = true;
+	}
+	frameSubmitted.notify_one();
+	if( presentThread.joinable() )
+	{
+		presentThread.join();
+	}
+
 	// free sysbuffer memory (aligned free)
-	if( pSysBuffer )
+	for( auto& pBuffer : pSysBuffers )
 	{
-		_aligned_free( pSysBuffer );
-		pSysBuffer = nullptr;
+		if( pBuffer )
+		{
+			_aligned_free( pBuffer );
+			pBuffer = nullptr;
+		}
 	}
+	pSysBuffer = nullptr;
+	pTileFrames = nullptr;
 	// clear the state of the device context before destruction
 	if( pImmediateContext ) pImmediateContext->ClearState();
 }
 
 void Graphics::EndFrame()
+{
+	assert( renderBufferIndex >= 0 );
+
+	// hand the finished sysbuffer over to the present thread and return right away
+	{
+		std::lock_guard<std::mutex> lock( presentMutex );
+		RethrowPresentError();
+		presentQueue.push_back( { renderBufferIndex,std::chrono::steady_clock::now(),clearFrame,clearColor } );
+		frameStats.framesInFlight++;
+	}
+	frameSubmitted.notify_one();
+
+	renderBufferIndex = -1;
+	pSysBuffer = nullptr;
+	pTileFrames = nullptr;
+}
+
+void Graphics::PresentThreadMain()
+{
+	for( ;; )
+	{
+		PendingFrame frame;
+		std::string dumpDirectory;
+		unsigned long long frameIndex;
+		{
+			std::unique_lock<std::mutex> lock( presentMutex );
+			frameSubmitted.wait( lock,[this]() { return stopPresenting || !presentQueue.empty(); } );
+			if( presentQueue.empty() )
+			{
+				return;
+			}
+			frame = presentQueue.front();
+			presentQueue.pop_front();
+			dumpDirectory = frameDumpDirectory;
+			frameIndex = frameStats.framesPresented;
+		}
+
+		std::exception_ptr error;
+		try
+		{
+			PresentSysBuffer( frame );
+			if( !dumpDirectory.empty() )
+			{
+				ResolveSysBuffer( frame );
+				DumpSysBuffer( pSysBuffers[frame.bufferIndex],dumpDirectory,frameIndex );
+			}
+		}
+		catch( ... )
+		{
+			error = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock( presentMutex );
+			if( error && !presentError )
+			{
+				presentError = error;
+			}
+
+			const std::chrono::duration<float,std::milli> latency = std::chrono::steady_clock::now() - frame.submitTime;
+			frameStats.lastLatencyMs = latency.count();
+			frameStats.maxLatencyMs = std::max( frameStats.maxLatencyMs,latency.count() );
+			frameStats.averageLatencyMs += (latency.count() - frameStats.averageLatencyMs) / float( frameStats.framesPresented + 1u );
+			frameStats.framesPresented++;
+			frameStats.framesInFlight--;
+
+			freeBuffers.push_back( frame.bufferIndex );
+		}
+		bufferReleased.notify_one();
+	}
+}
+
+void Graphics::PresentSysBuffer( const PendingFrame& frame )
 {
 	HRESULT hr;
 
@@ -263,14 +370,37 @@ void Graphics::EndFrame()
 		throw CHILI_GFX_EXCEPTION( hr,L"Mapping sysbuffer" );
 	}
 	// setup parameters for copy operation
+	const Color* pBuffer = pSysBuffers[frame.bufferIndex];
+	const unsigned long long* pFrameTiles = sysBufferTileFrames[frame.bufferIndex].data();
 	Color* pDst = reinterpret_cast<Color*>(mappedSysBufferTexture.pData );
 	const size_t dstPitch = mappedSysBufferTexture.RowPitch / sizeof( Color );
 	const size_t srcPitch = Graphics::ScreenWidth;
-	const size_t rowBytes = srcPitch * sizeof( Color );
-	// perform the copy line-by-line
+	// perform the copy line-by-line, runs of drawn tiles are copied and runs of untouched
+	// tiles are filled with the clear color straight into the adapter memory
 	for( size_t y = 0u; y < Graphics::ScreenHeight; y++ )
 	{
-		memcpy( &pDst[ y * dstPitch ],&pSysBuffer[y * srcPitch],rowBytes );
+		const unsigned long long* pRowTiles = &pFrameTiles[(y >> ClearTileShift) * ClearTilesX];
+		for( int tileX = 0; tileX < ClearTilesX; )
+		{
+			const bool drawn = pRowTiles[tileX] == frame.clearFrame;
+			int runEnd = tileX + 1;
+			while( runEnd < ClearTilesX && (pRowTiles[runEnd] == frame.clearFrame) == drawn )
+			{
+				runEnd++;
+			}
+
+			const size_t x = size_t( tileX ) << ClearTileShift;
+			const size_t count = size_t( runEnd - tileX ) << ClearTileShift;
+			if( drawn )
+			{
+				memcpy( &pDst[y * dstPitch + x],&pBuffer[y * srcPitch + x],count * sizeof( Color ) );
+			}
+			else
+			{
+				std::fill_n( &pDst[y * dstPitch + x],count,frame.clearColor );
+			}
+			tileX = runEnd;
+		}
 	}
 	// release the adapter memory
 	pImmediateContext->Unmap( pSysBufferTexture.Get(),0u );
@@ -301,10 +431,120 @@ void Graphics::EndFrame()
 	}
 }
 
+// fills the tiles of a submitted frame that were never drawn to, only needed when the sysbuffer itself is read back
+void Graphics::ResolveSysBuffer( const PendingFrame& frame )
+{
+	unsigned long long* pFrameTiles = sysBufferTileFrames[frame.bufferIndex].data();
+	for( int tileY = 0; tileY < ClearTilesY; tileY++ )
+	{
+		for( int tileX = 0; tileX < ClearTilesX; tileX++ )
+		{
+			unsigned long long& tileFrame = pFrameTiles[tileY * ClearTilesX + tileX];
+			if( tileFrame != frame.clearFrame )
+			{
+				ClearSysBufferTile( pSysBuffers[frame.bufferIndex],tileX,tileY,frame.clearColor );
+				tileFrame = frame.clearFrame;
+			}
+		}
+	}
+}
+
+void Graphics::ClearSysBufferTile( Color* pBuffer,int tileX,int tileY,Color c )
+{
+	Color* pRow = &pBuffer[(tileY << ClearTileShift) * Graphics::ScreenWidth + (tileX << ClearTileShift)];
+	for( int y = 0; y < ClearTileSize; y++,pRow += Graphics::ScreenWidth )
+	{
+		std::fill_n( pRow,ClearTileSize,c );
+	}
+}
+
+void Graphics::DumpSysBuffer( const Color* pBuffer,const std::string& directory,unsigned long long frameIndex ) const
+{
+	std::ostringstream path;
+	path << directory << "/frame_" << std::setw( 6 ) << std::setfill( '0' ) << frameIndex << ".bmp";
+
+	// 32 bit top-down bitmap, Color is already laid out as BGRX in memory
+	const uint32_t imageSize = sizeof( Color ) * Graphics::ScreenWidth * Graphics::ScreenHeight;
+	const uint32_t headerSize = 14u + 40u;
+	uint8_t header[headerSize] = {};
+	auto put16 = [&header]( int offset,uint16_t value ) { memcpy( &header[offset],&value,sizeof( value ) ); };
+	auto put32 = [&header]( int offset,uint32_t value ) { memcpy( &header[offset],&value,sizeof( value ) ); };
+	header[0] = 'B';
+	header[1] = 'M';
+	put32( 2,headerSize + imageSize );
+	put32( 10,headerSize );
+	put32( 14,40u );
+	put32( 18,uint32_t( Graphics::ScreenWidth ) );
+	put32( 22,uint32_t( -Graphics::ScreenHeight ) );
+	put16( 26,1u );
+	put16( 28,32u );
+	put32( 34,imageSize );
+
+	std::ofstream file( path.str(),std::ios::binary );
+	file.write( reinterpret_cast<const char*>( header ),headerSize );
+	file.write( reinterpret_cast<const char*>( pBuffer ),imageSize );
+}
+
 void Graphics::BeginFrame()
 {
-	// clear the sysbuffer
-	memset( pSysBuffer,bgColor,sizeof( Color ) * Graphics::ScreenHeight * Graphics::ScreenWidth );
+	// wait until a sysbuffer is free and the frames-in-flight limit allows starting another frame
+	{
+		const auto waitStart = std::chrono::steady_clock::now();
+		std::unique_lock<std::mutex> lock( presentMutex );
+		bufferReleased.wait( lock,[this]()
+		{
+			return presentError || (frameStats.framesInFlight < maxFramesInFlight && !freeBuffers.empty());
+		} );
+		RethrowPresentError();
+
+		renderBufferIndex = freeBuffers.back();
+		freeBuffers.pop_back();
+
+		const std::chrono::duration<float,std::milli> stall = std::chrono::steady_clock::now() - waitStart;
+		frameStats.lastStallMs = stall.count();
+		frameStats.totalStallMs += stall.count();
+	}
+	pSysBuffer = pSysBuffers[renderBufferIndex];
+	pTileFrames = sysBufferTileFrames[renderBufferIndex].data();
+
+	// clear the sysbuffer lazily, every tile is stale until PutPixel touches it
+	clearFrame++;
+	clearColor = Color( bgColor,bgColor,bgColor,bgColor );
+}
+
+void Graphics::SetMaxFramesInFlight( int count )
+{
+	std::lock_guard<std::mutex> lock( presentMutex );
+	maxFramesInFlight = std::min( std::max( count,1 ),MaxSysBuffers - 1 );
+}
+
+Graphics::FrameStats Graphics::GetFrameStats() const
+{
+	std::lock_guard<std::mutex> lock( presentMutex );
+	return frameStats;
+}
+
+void Graphics::ResetFrameStats()
+{
+	std::lock_guard<std::mutex> lock( presentMutex );
+	const int framesInFlight = frameStats.framesInFlight;
+	frameStats = FrameStats();
+	frameStats.framesInFlight = framesInFlight;
+}
+
+void Graphics::SetFrameDumpDirectory( const std::string& directory )
+{
+	std::lock_guard<std::mutex> lock( presentMutex );
+	frameDumpDirectory = directory;
+}
+
+// called with presentMutex held
+void Graphics::RethrowPresentError()
+{
+	if( presentError )
+	{
+		std::rethrow_exception( std::exchange( presentError,nullptr ) );
+	}
 }
 
 void Graphics::PutPixel( int x,int y,Color c )
@@ -313,9 +553,29 @@ void Graphics::PutPixel( int x,int y,Color c )
 	assert( x < int( Graphics::ScreenWidth ) );
 	assert( y >= 0 );
 	assert( y < int( Graphics::ScreenHeight ) );
+	unsigned long long& tileFrame = pTileFrames[(y >> ClearTileShift) * ClearTilesX + (x >> ClearTileShift)];
+	if( tileFrame != clearFrame )
+	{
+		ClearSysBufferTile( pSysBuffer,x >> ClearTileShift,y >> ClearTileShift,clearColor );
+		tileFrame = clearFrame;
+	}
 	pSysBuffer[Graphics::ScreenWidth * y + x] = c;
 }
 
+Color Graphics::GetPixel( int x,int y ) const
+{
+	assert( x >= 0 );
+	assert( x < int( Graphics::ScreenWidth ) );
+	assert( y >= 0 );
+	assert( y < int( Graphics::ScreenHeight ) );
+	// tiles nothing was drawn to this frame still hold an older frame
+	if( pTileFrames[(y >> ClearTileShift) * ClearTilesX + (x >> ClearTileShift)] != clearFrame )
+	{
+		return clearColor;
+	}
+	return pSysBuffer[Graphics::ScreenWidth * y + x];
+}
+
 void Graphics::SetBackgroundColor(unsigned char value)
 {
 	bgColor = value;
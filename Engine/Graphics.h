@@ -19,11 +19,24 @@
 *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
 ******************************************************************************************/
 #pragma once
+#ifdef ENGINE_HEADLESS
+// no window, frames are drawn to memory only
+#include "HeadlessGraphics.h"
+#else
 #include "ChiliWin.h"
 #include <d3d11.h>
 #include <wrl.h>
 #include "ChiliException.h"
 #include "Colors.h"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 class Graphics
 {
@@ -46,6 +59,28 @@ private:
 		float x,y,z;		// position
 		float u,v;			// texcoords
 	};
+	// a finished sysbuffer waiting for the present thread
+	struct PendingFrame
+	{
+		int bufferIndex;
+		std::chrono::steady_clock::time_point submitTime;
+		// tiles not stamped with this frame were never drawn to and present as clearColor
+		unsigned long long clearFrame;
+		Color clearColor;
+	};
+public:
+	struct FrameStats
+	{
+		int framesInFlight = 0;
+		unsigned long long framesPresented = 0u;
+		// time from EndFrame handing the frame over until Present returned
+		float lastLatencyMs = 0.0f;
+		float averageLatencyMs = 0.0f;
+		float maxLatencyMs = 0.0f;
+		// time BeginFrame spent waiting for a free sysbuffer
+		float lastStallMs = 0.0f;
+		float totalStallMs = 0.0f;
+	};
 public:
 	Graphics( class HWNDKey& key );
 	Graphics( const Graphics& ) = delete;
@@ -57,8 +92,23 @@ public:
 		PutPixel( x,y,{ unsigned char( r ),unsigned char( g ),unsigned char( b ) } );
 	}
 	void PutPixel( int x,int y,Color c );
+	// pixel of the frame being drawn, between BeginFrame and EndFrame
+	Color GetPixel( int x,int y ) const;
 	void SetBackgroundColor(unsigned char value);
+	// number of finished frames allowed to queue up behind the render thread (1 = double, 2 = triple buffering)
+	void SetMaxFramesInFlight( int count );
+	FrameStats GetFrameStats() const;
+	void ResetFrameStats();
+	// when set, every presented frame is also written as a .bmp to this directory by the present thread
+	void SetFrameDumpDirectory( const std::string& directory );
 	~Graphics();
+private:
+	void PresentThreadMain();
+	void PresentSysBuffer( const PendingFrame& frame );
+	void ResolveSysBuffer( const PendingFrame& frame );
+	void ClearSysBufferTile( Color* pBuffer,int tileX,int tileY,Color c );
+	void DumpSysBuffer( const Color* pBuffer,const std::string& directory,unsigned long long frameIndex ) const;
+	void RethrowPresentError();
 private:
 	Microsoft::WRL::ComPtr<IDXGISwapChain>				pSwapChain;
 	Microsoft::WRL::ComPtr<ID3D11Device>				pDevice;
@@ -74,8 +124,33 @@ private:
 	D3D11_MAPPED_SUBRESOURCE							mappedSysBufferTexture;
 	Color*                                              pSysBuffer = nullptr;
 	unsigned char                                       bgColor = 0u;
+	// frame pipelining: the render thread fills one sysbuffer while the present thread
+	// copies out and presents the ones that were already finished
+	static constexpr int                                MaxSysBuffers = 3;
+	std::array<Color*,MaxSysBuffers>                    pSysBuffers = {};
+	// lazy clears: BeginFrame only bumps clearFrame, a 16x16 tile is filled with the clear color
+	// the first time PutPixel touches it and the present thread fills the untouched ones on copy-out
+	static constexpr int                                ClearTileShift = 4;
+	static constexpr int                                ClearTileSize = 1 << ClearTileShift;
+	std::array<std::vector<unsigned long long>,MaxSysBuffers> sysBufferTileFrames;
+	unsigned long long*                                 pTileFrames = nullptr;
+	unsigned long long                                  clearFrame = 0u;
+	Color                                               clearColor;
+	int                                                 renderBufferIndex = -1;
+	int                                                 maxFramesInFlight = MaxSysBuffers - 1;
+	std::vector<int>                                    freeBuffers;
+	std::deque<PendingFrame>                            presentQueue;
+	FrameStats                                          frameStats;
+	std::string                                         frameDumpDirectory;
+	bool                                                stopPresenting = false;
+	std::exception_ptr                                  presentError;
+	mutable std::mutex                                  presentMutex;
+	std::condition_variable                             frameSubmitted;
+	std::condition_variable                             bufferReleased;
+	std::thread                                         presentThread;
 public:
 	static constexpr int ScreenWidth = 1280;
 	static constexpr int ScreenHeight = 960;
 	static constexpr float AspectRatio = static_cast<float>(Graphics::ScreenWidth) / Graphics::ScreenHeight;
-};
\ No newline at end of file
+};
+#endif
\ No newline at end of file
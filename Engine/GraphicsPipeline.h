@@ -1,14 +1,45 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <memory>
 #include <cmath>
 #include <limits>
-
-#include "stb_image.h"
+#include <type_traits>
 
 #include "Vec3.h"
+#include "AllocationTracker.h"
 #include "Graphics.h"
+#include "CommandBuffer.h"
+#include "DepthBuffer.h"
+#include "MultisampleTarget.h"
+#include "Varyings.h"
+#include "AttributePlanes.h"
+#include "FrameArena.h"
+#include "Heatmap.h"
+#include "JobSystem.h"
+#include "PipelineProfiler.h"
+#include "Texture.h"
+
+// How triangles get from clip space to pixels
+enum class RasterizationMode
+{
+	// Near plane clipping in NDC, then flat-top and flat-bottom scanline traversal
+	Scanline,
+	// Edge functions set up in 2D homogeneous coordinates straight from clip space (Olano and Greer),
+	// triangles crossing the near plane are never split, the plane is just one more per pixel constraint
+	Homogeneous
+};
+
+// Order in which the pixels of a triangle are visited, the image is the same either way
+enum class PixelTraversal
+{
+	// One row after the other
+	Rows,
+	// 4x4 pixel blocks, band by band. Neighbouring pixels in both directions follow each other closely,
+	// so texture fetches of rotated and minified surfaces stay within a few cache lines.
+	Blocks
+};
 
 template <class TShaderProgram>
 class GraphicsPipeline
@@ -18,9 +49,12 @@ class GraphicsPipeline
 	typedef typename TShaderProgram::VSIn VSIn;
 	typedef typename TShaderProgram::VSOut VSOut;
 	typedef typename TShaderProgram::PSOut PSOut;
+	// Timing fragments is compiled in for HeatmapProgram pipelines only
+	typedef std::conditional_t<TShaderProgram::RecordsHeatmap, Heatmap::PixelTimer, Heatmap::NoPixelTimer> PixelTimer;
 
 public:
 	GraphicsPipeline(Graphics& graphics);
+	GraphicsPipeline(Graphics& graphics, int viewportWidth, int viewportHeight);
 	~GraphicsPipeline();
 
 	VertexShader& GetVertexShader() { return m_VertexShader; }
@@ -29,50 +63,127 @@ public:
 	void BindIndices(const std::vector<size_t>& indices);
 	void BindVertices(const std::vector<VSIn>& vertices);
 
-	void LoadTexture(const std::string& path);
+	// Loads a texture of its own, pipelines that should share one bind it from an AssetManager instead
+	void LoadTexture(const std::string& path, Texture::Format format = Texture::Format::RGB8);
+	void BindTexture(std::shared_ptr<const Texture> pTexture) { m_pTexture = std::move(pTexture); }
+	const std::shared_ptr<const Texture>& GetTexture() const { return m_pTexture; }
 	void UnloadTexture();
 
+	// With a job system, vertices are shaded in parallel batches and the triangles of a batch are rasterized
+	// (on the calling thread, in order) while later batches are still shaded. The job system has to outlive the pipeline.
+	void SetJobSystem(JobSystem* pJobs) { m_pJobs = pJobs; }
+
+	// While a profiler is set, the stages of every draw add their costs to it. It has to outlive the pipeline.
+	void SetProfiler(PipelineProfiler* pProfiler) { m_pProfiler = pProfiler; }
+
+	// While a multisample target is bound, color and depth go to its samples instead of the screen and the depth buffer
+	void BindMultisampleTarget(MultisampleTarget* pTarget) { m_pMultisampleTarget = pTarget; }
+
+	// While a heatmap is bound, every fragment tested adds itself and the time spent on it to its pixel
+	void BindHeatmap(Heatmap* pHeatmap)
+	{
+		static_assert(TShaderProgram::RecordsHeatmap, "Only pipelines of a HeatmapProgram fill heatmaps");
+		m_pHeatmap = pHeatmap;
+	}
+
+	void SetRasterizationMode(RasterizationMode mode) { m_RasterizationMode = mode; }
+	RasterizationMode GetRasterizationMode() const { return m_RasterizationMode; }
+
+	// Only single sampled drawing traverses in blocks, multisample targets are always filled row by row
+	void SetPixelTraversal(PixelTraversal traversal) { m_PixelTraversal = traversal; }
+	PixelTraversal GetPixelTraversal() const { return m_PixelTraversal; }
+
 	void Draw();
+	// Runs the commands in the order they were recorded, on this thread. Buffers recorded for another program
+	// with the same inputs run too, so a HeatmapProgram pipeline executes those of the program it wraps.
+	template <class TRecordedProgram>
+	void Execute(const CommandBuffer<TRecordedProgram>& commands);
 	void ClearZBuffer();
+	// Clears are lazy, depths have to be resolved before anything reads them back
+	void ResolveZBuffer();
+
+	const DepthBuffer& GetDepthBuffer() const { return m_DepthBuffer; }
 
 private:
 	Graphics& m_Graphics;
 
+	int m_ViewportWidth;
+	int m_ViewportHeight;
+
 	VertexShader m_VertexShader;
 	PixelShader m_PixelShader;
 
+	// Copies made by BindIndices and BindVertices
 	std::vector<size_t> m_InputIndices;
 	std::vector<VSIn> m_InputVertices;
-
-	std::vector<VSOut> m_TransformedVertices;
-
-	float** zBuffer;
-
-	unsigned char* m_TextureData = nullptr;
-	int m_TextureWidth = 0;
-	int m_TextureHeight = 0;
+	// What draws read, the copies or the vectors a command buffer referenced
+	const std::vector<size_t>* m_pIndices = &m_InputIndices;
+	const std::vector<VSIn>* m_pVertices = &m_InputVertices;
+
+	// Plane equations of the triangle that is being rasterized
+	AttributePlanes<VSOut> m_AttributePlanes;
+
+	DepthBuffer m_DepthBuffer;
+	MultisampleTarget* m_pMultisampleTarget = nullptr;
+	Heatmap* m_pHeatmap = nullptr;
+	JobSystem* m_pJobs = nullptr;
+	PipelineProfiler* m_pProfiler = nullptr;
+	// Pixels visited by rasterization so far, the profiler counts them per triangle
+	uint64_t m_PixelCount = 0u;
+	RasterizationMode m_RasterizationMode = RasterizationMode::Scanline;
+	PixelTraversal m_PixelTraversal = PixelTraversal::Rows;
+
+	// Null while no texture is bound or the bound one failed to load
+	std::shared_ptr<const Texture> m_pTexture;
+
+	static constexpr int TraversalBlockSize = 4;
+
+	// Vertices shaded by one job, and the least triangles assembled per job. Draws of more than
+	// MaxTriangleJobs * TrianglesPerJob triangles use larger batches, the jobs a thread may have unfinished are limited.
+	static constexpr size_t VerticesPerJob = 4096u;
+	static constexpr size_t TrianglesPerJob = 2048u;
+	static constexpr size_t MaxTriangleJobs = 256u;
 
 	#pragma region Pipeline stages
 
 	void VertexProcessing();
-	void TriangleAssembly();
+	void TriangleAssembly(VSOut* pVertices, size_t count);
 	void Clipping(VSOut& v1, VSOut& v2, VSOut& v3);
 	void ScreenMapping(VSOut v1, VSOut v2, VSOut v3);
 	void Rasterization(const VSOut& v1, const VSOut& v2, const VSOut& v3);
-	void PixelProcessing(int screenX, int screenY, VSOut& fragment);
+	// Replaces Clipping, ScreenMapping and Rasterization in RasterizationMode::Homogeneous
+	void HomogeneousRasterization(const VSOut& v1, const VSOut& v2, const VSOut& v3);
+	void PixelProcessing(int screenX, int screenY, float depth);
+	Color ShadeFragment(float screenX, float screenY);
 
 	#pragma endregion
 
 	#pragma region Helper functions
 
+	static bool IsOutsideViewVolume(const VSOut& v1, const VSOut& v2, const VSOut& v3);
+
 	void ClipSpaceToNDCSpaceVertex(VSOut& v);
 	void ClipSpaceToNDCSpaceTriangle(VSOut& v1, VSOut& v2, VSOut& v3);
 	void NDCSpaceToScreenSpaceVertex(VSOut& v);
 	void NDCSpaceToScreenSpaceTriangle(VSOut& v1, VSOut& v2, VSOut& v3);
 
-	void DrawFlatTopTriangle(const VSOut& v1, const VSOut& v2, const VSOut& v3);
-	void DrawFlatBottomTriangle(const VSOut& v1, const VSOut& v2, const VSOut& v3);
-	void DrawFlatTriangle(const VSOut& leftEdgeFrom, const VSOut& leftEdgeTo, const VSOut& rightEdgeFrom, const VSOut& rightEdgeTo);
+	void DrawFlatTopTriangle(const Vec4& v1, const Vec4& v2, const Vec4& v3);
+	void DrawFlatBottomTriangle(const Vec4& v1, const Vec4& v2, const Vec4& v3);
+	void DrawFlatTriangle(const Vec4& leftEdgeFrom, const Vec4& leftEdgeTo, const Vec4& rightEdgeFrom, const Vec4& rightEdgeTo);
+	void DrawFlatTriangleMultisampled(const Vec4& leftEdgeFrom, const Vec4& leftEdgeTo, const Vec4& rightEdgeFrom, const Vec4& rightEdgeTo);
+	void ShadeSamples(MultisampleTarget::Sample* pSamples, unsigned int passedMask, float centerX, float centerY);
+
+	// Tile of the center of the screen space bounding box, for the profiler
+	int GetProfilerTile(const Vec2& v1, const Vec2& v2, const Vec2& v3) const;
+
+	void DrawHomogeneousTriangle(const Vec3 (&constraints)[4], int startY, int endY);
+	void DrawHomogeneousTriangleMultisampled(const Vec3 (&constraints)[4], int startY, int endY);
+	bool HomogeneousSpan(const Vec3 (&constraints)[4], float sampleY, float offsetX, int& startX, int& endX) const;
+
+	// Row spans are collected for a band of rows, one row in PixelTraversal::Rows and the rows of one block
+	// in PixelTraversal::Blocks, and then drawn in traversal order
+	int GetBandEnd(int bandY, int endY) const;
+	void DrawBand(int bandY, int rowCount, const int (&startX)[TraversalBlockSize], const int (&endX)[TraversalBlockSize]);
 
 	#pragma endregion
 };
@@ -82,25 +193,25 @@ private:
 template<class TShaderProgram>
 inline GraphicsPipeline<TShaderProgram>::GraphicsPipeline(Graphics& graphics)
 	:
-	m_Graphics(graphics)
+	GraphicsPipeline(graphics, Graphics::ScreenWidth, Graphics::ScreenHeight)
 {
-	zBuffer = new float*[Graphics::ScreenHeight];
-	for (int i = 0; i < Graphics::ScreenHeight; i++)
-	{
-		zBuffer[i] = new float[Graphics::ScreenWidth];
-	}
 }
 
 template<class TShaderProgram>
-inline GraphicsPipeline<TShaderProgram>::~GraphicsPipeline()
+inline GraphicsPipeline<TShaderProgram>::GraphicsPipeline(Graphics& graphics, int viewportWidth, int viewportHeight)
+	:
+	m_Graphics(graphics),
+	m_ViewportWidth(viewportWidth),
+	m_ViewportHeight(viewportHeight),
+	m_DepthBuffer(viewportWidth, viewportHeight)
 {
-	for (int i = 0; i < Graphics::ScreenHeight; i++)
-	{
-		delete[] zBuffer[i];
-	}
-
-	delete[] zBuffer;
+	// Color is written straight to the screen, so color passes can't use a different viewport
+	assert(!TShaderProgram::WritesColor || (viewportWidth == Graphics::ScreenWidth && viewportHeight == Graphics::ScreenHeight));
+}
 
+template<class TShaderProgram>
+inline GraphicsPipeline<TShaderProgram>::~GraphicsPipeline()
+{
 	UnloadTexture();
 }
 
@@ -108,29 +219,31 @@ template<class TShaderProgram>
 inline void GraphicsPipeline<TShaderProgram>::BindIndices(const std::vector<size_t>& indices)
 {
 	assert(indices.size() % 3 == 0);
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Pipeline);
 	m_InputIndices = indices;
+	m_pIndices = &m_InputIndices;
 }
 
 template<class TShaderProgram>
 inline void GraphicsPipeline<TShaderProgram>::BindVertices(const std::vector<VSIn>& vertices)
 {
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Pipeline);
 	m_InputVertices = vertices;
+	m_pVertices = &m_InputVertices;
 }
 
 template<class TShaderProgram>
-inline void GraphicsPipeline<TShaderProgram>::LoadTexture(const std::string& path)
+inline void GraphicsPipeline<TShaderProgram>::LoadTexture(const std::string& path, Texture::Format format)
 {
-	UnloadTexture();
-
-	int discard;
-	m_TextureData = stbi_load(path.c_str(), &m_TextureWidth, &m_TextureHeight, &discard, 3);
+	auto pTexture = std::make_shared<Texture>();
+	pTexture->Load(path, format);
+	m_pTexture = pTexture->IsLoaded() ? std::move(pTexture) : nullptr;
 }
 
 template<class TShaderProgram>
 inline void GraphicsPipeline<TShaderProgram>::UnloadTexture()
 {
-	stbi_image_free(m_TextureData);
-	m_TextureData = nullptr;
+	m_pTexture.reset();
 }
 
 template<class TShaderProgram>
@@ -139,61 +252,133 @@ inline void GraphicsPipeline<TShaderProgram>::Draw()
 	VertexProcessing();
 }
 
+template<class TShaderProgram>
+template<class TRecordedProgram>
+inline void GraphicsPipeline<TShaderProgram>::Execute(const CommandBuffer<TRecordedProgram>& commands)
+{
+	static_assert(std::is_same_v<typename TRecordedProgram::VSIn, VSIn> &&
+		std::is_same_v<typename TRecordedProgram::VertexShader::Constants, typename VertexShader::Constants>, "Commands have to bind the vertices and constants of this program");
+
+	for (const auto& command : commands.GetCommands())
+	{
+		switch (command.m_Type)
+		{
+		case CommandType::BindVertices:
+			m_pVertices = &commands.GetVertices(command.m_Argument);
+			break;
+		case CommandType::BindIndices:
+			m_pIndices = &commands.GetIndices(command.m_Argument);
+			break;
+		case CommandType::BindTexture:
+			m_pTexture = commands.GetTexture(command.m_Argument);
+			break;
+		case CommandType::SetConstants:
+			m_VertexShader.SetConstants(commands.GetConstants(command.m_Argument));
+			break;
+		case CommandType::Draw:
+			Draw();
+			break;
+		}
+	}
+}
+
 template<class TShaderProgram>
 inline void GraphicsPipeline<TShaderProgram>::VertexProcessing()
 {
-	m_TransformedVertices.clear();
+	// Vertex shader outputs only live until their triangles are rasterized, so they go to the frame arena
+	// and are released when the draw is done
+	FrameArena& arena = FrameArena::ForThisThread();
+	FrameArena::Scope scope(arena);
+
+	const std::vector<size_t>& indices = *m_pIndices;
+	const std::vector<VSIn>& vertices = *m_pVertices;
+
+	// One vertex per index, every job writes its own range
+	const size_t indexCount = indices.size();
+	FrameVector<VSOut> transformedVertices(indexCount, FrameAllocator<VSOut>(arena));
+	FrameVector<VSOut> shadedVertices{ FrameAllocator<VSOut>(arena) };
+
+	if constexpr (TShaderProgram::BatchesVertices)
+	{
+		// Every vertex is shaded once, the indices only pick the results. Indices can point anywhere,
+		// so all vertices are shaded before any triangle is assembled.
+		shadedVertices.resize(vertices.size());
+		auto shade = [this, &vertices, &shadedVertices](size_t first, size_t last)
+		{
+			PipelineProfiler::Scope scope(m_pProfiler, PipelineProfiler::Stage::VertexShading);
+			scope.AddItems(last - first);
+			m_VertexShader.MainBatch(&vertices[first], last - first, &shadedVertices[first]);
+		};
+
+		if (m_pJobs != nullptr) m_pJobs->ParallelFor(0u, vertices.size(), VerticesPerJob, shade);
+		else shade(0u, vertices.size());
+	}
+
+	auto transform = [this, &indices, &vertices, &shadedVertices, &transformedVertices](size_t first, size_t last)
+	{
+		// Only picking results of batches isn't shading
+		PipelineProfiler::Scope scope(m_pProfiler, PipelineProfiler::Stage::VertexShading);
+		if constexpr (!TShaderProgram::BatchesVertices) scope.AddItems(last - first);
 
-	for (const auto& index : m_InputIndices)
+		for (size_t i = first; i < last; i++)
+		{
+			if constexpr (TShaderProgram::BatchesVertices) transformedVertices[i] = shadedVertices[indices[i]];
+			else transformedVertices[i] = m_VertexShader.Main(vertices[indices[i]]);
+		}
+	};
+
+	const size_t trianglesPerJob = std::max(TrianglesPerJob, (indexCount / 3u + MaxTriangleJobs - 1u) / MaxTriangleJobs);
+	const size_t indicesPerJob = trianglesPerJob * 3u;
+	if (m_pJobs == nullptr || indexCount <= indicesPerJob)
 	{
-		m_TransformedVertices.push_back(m_VertexShader.Main(m_InputVertices[index]));
+		transform(0u, indexCount);
+		TriangleAssembly(transformedVertices.data(), indexCount);
+		return;
 	}
 
-	TriangleAssembly();
+	// Rasterization writes to shared targets, so batches are assembled here one after the other in draw order,
+	// each as soon as its job is done
+	FrameVector<JobSystem::Job*> jobs{ FrameAllocator<JobSystem::Job*>(arena) };
+	jobs.reserve((indexCount + indicesPerJob - 1u) / indicesPerJob);
+	for (size_t first = 0u; first < indexCount; first += indicesPerJob)
+	{
+		const size_t last = std::min(first + indicesPerJob, indexCount);
+		jobs.push_back(m_pJobs->Create([&transform, first, last]() { transform(first, last); }));
+		m_pJobs->Run(jobs.back());
+	}
+
+	for (size_t i = 0u; i < jobs.size(); i++)
+	{
+		m_pJobs->Wait(jobs[i]);
+
+		const size_t first = i * indicesPerJob;
+		TriangleAssembly(&transformedVertices[first], std::min(indicesPerJob, indexCount - first));
+	}
 }
 
 template<class TShaderProgram>
-inline void GraphicsPipeline<TShaderProgram>::TriangleAssembly()
+inline void GraphicsPipeline<TShaderProgram>::TriangleAssembly(VSOut* pVertices, size_t count)
 {
-	for (auto it = m_TransformedVertices.begin(); it != m_TransformedVertices.end(); std::advance(it, 3))
+	PipelineProfiler::Scope scope(m_pProfiler, PipelineProfiler::Stage::Clipping);
+	scope.AddItems(count / 3u);
+
+	for (VSOut* it = pVertices; it != pVertices + count; it += 3)
 	{
-		Clipping(*it, *(it + 1), *(it + 2));
+		if (m_RasterizationMode == RasterizationMode::Homogeneous)
+		{
+			HomogeneousRasterization(*it, *(it + 1), *(it + 2));
+		}
+		else
+		{
+			Clipping(*it, *(it + 1), *(it + 2));
+		}
 	}
 }
 
 template<class TShaderProgram>
 inline void GraphicsPipeline<TShaderProgram>::Clipping(VSOut& v1, VSOut& v2, VSOut& v3)
 {
-	// Cull triangles completley out of the view volume
-	// Near and far plane
-	if (v1.m_Position.z <= -v1.m_Position.w &&
-		v2.m_Position.z <= -v2.m_Position.w &&
-		v3.m_Position.z <= -v3.m_Position.w)
-		return;
-	if (v1.m_Position.z >= v1.m_Position.w &&
-		v2.m_Position.z >= v2.m_Position.w &&
-		v3.m_Position.z >= v3.m_Position.w)
-		return;
-
-	// Left and right plane
-	if (v1.m_Position.x <= -v1.m_Position.w &&
-		v2.m_Position.x <= -v2.m_Position.w &&
-		v3.m_Position.x <= -v3.m_Position.w)
-		return;
-	if (v1.m_Position.x >= v1.m_Position.w &&
-		v2.m_Position.x >= v2.m_Position.w &&
-		v3.m_Position.x >= v3.m_Position.w)
-		return;
-
-	// Bottom and top plane
-	if (v1.m_Position.y <= -v1.m_Position.w &&
-		v2.m_Position.y <= -v2.m_Position.w &&
-		v3.m_Position.y <= -v3.m_Position.w)
-		return;
-	if (v1.m_Position.y >= v1.m_Position.w &&
-		v2.m_Position.y >= v2.m_Position.w &&
-		v3.m_Position.y >= v3.m_Position.w)
-		return;
+	if (IsOutsideViewVolume(v1, v2, v3)) return;
 
 	// Sort vertices by x (descending)
 	if (v1.m_Position.x < v2.m_Position.x) std::swap(v1, v2);
@@ -278,28 +463,39 @@ inline void GraphicsPipeline<TShaderProgram>::ScreenMapping(VSOut v1, VSOut v2,
 template<class TShaderProgram>
 inline void GraphicsPipeline<TShaderProgram>::Rasterization(const VSOut& v1, const VSOut& v2, const VSOut& v3)
 {
-	// Sort vertices by y (from bottom to top on screen)
-	const VSOut* pv1 = &v1;
-	const VSOut* pv2 = &v2;
-	const VSOut* pv3 = &v3;
-	if (pv1->m_Position.y < pv2->m_Position.y) std::swap(pv1, pv2);
-	if (pv2->m_Position.y < pv3->m_Position.y) std::swap(pv2, pv3);
-	if (pv1->m_Position.y < pv2->m_Position.y) std::swap(pv1, pv2);
+	const int tile = m_pProfiler != nullptr ? GetProfilerTile
+	(
+		Vec2(v1.m_Position.x, v1.m_Position.y),
+		Vec2(v2.m_Position.x, v2.m_Position.y),
+		Vec2(v3.m_Position.x, v3.m_Position.y)
+	) : -1;
+	PipelineProfiler::Scope scope(m_pProfiler, PipelineProfiler::Stage::Rasterization, tile, &m_PixelCount);
 
-	if (pv1->m_Position.y == pv2->m_Position.y)
+	if (!m_AttributePlanes.Setup(v1, v2, v3)) return;
+
+	// Edges only need positions, every other value is read from the planes
+	// Sort vertices by y (from bottom to top on screen)
+	const Vec4* pv1 = &v1.m_Position;
+	const Vec4* pv2 = &v2.m_Position;
+	const Vec4* pv3 = &v3.m_Position;
+	if (pv1->y < pv2->y) std::swap(pv1, pv2);
+	if (pv2->y < pv3->y) std::swap(pv2, pv3);
+	if (pv1->y < pv2->y) std::swap(pv1, pv2);
+
+	if (pv1->y == pv2->y)
 	{
 		DrawFlatBottomTriangle(*pv1, *pv2, *pv3);
 		return;
 	}
-	if (pv2->m_Position.y == pv3->m_Position.y)
+	if (pv2->y == pv3->y)
 	{
 		DrawFlatTopTriangle(*pv1, *pv2, *pv3);
 		return;
 	}
 
 	// Split triangle into flat top, and flat bottom triangles
-	const float t = (pv1->m_Position.y - pv2->m_Position.y) / (pv1->m_Position.y - pv3->m_Position.y);
-	VSOut vSplit = VSOut::Lerp(*pv1, *pv3, t);
+	const float t = (pv1->y - pv2->y) / (pv1->y - pv3->y);
+	const Vec4 vSplit = *pv1 + (*pv3 - *pv1) * t;
 
 	// Draw the triangles
 	DrawFlatTopTriangle(*pv1, vSplit, *pv2);
@@ -307,38 +503,76 @@ inline void GraphicsPipeline<TShaderProgram>::Rasterization(const VSOut& v1, con
 }
 
 template<class TShaderProgram>
-inline void GraphicsPipeline<TShaderProgram>::PixelProcessing(int screenX, int screenY, VSOut& fragment)
+inline void GraphicsPipeline<TShaderProgram>::PixelProcessing(int screenX, int screenY, float depth)
 {
-	if (fragment.m_Position.z >= zBuffer[screenY][screenX]) return;
+	PixelTimer timer(m_pHeatmap, screenX, screenY);
+	if (!m_DepthBuffer.TestAndSet(screenX, screenY, depth)) return;
 
-	zBuffer[screenY][screenX] = fragment.m_Position.z;
-
-	if (m_TextureData != nullptr)
+	// Depth-only programs (shadow passes) never write color
+	if constexpr (TShaderProgram::WritesColor)
 	{
-		Vei2 textureCoordinates
-		(
-			static_cast<int>(fragment.m_UvCoordinates.x * m_TextureWidth),
-			static_cast<int>((1.0f - fragment.m_UvCoordinates.y) * m_TextureHeight)
-		);
+		m_Graphics.PutPixel(screenX, screenY, ShadeFragment(static_cast<float>(screenX) + 0.5f, static_cast<float>(screenY) + 0.5f));
+	}
+}
 
-		int yOffset = textureCoordinates.y * m_TextureWidth;
-		int xOffset = textureCoordinates.x;
+template<class TShaderProgram>
+inline Color GraphicsPipeline<TShaderProgram>::ShadeFragment(float screenX, float screenY)
+{
+	// Only fragments that get shaded evaluate more than depth
+	float components[VSOut::ComponentCount];
+	m_AttributePlanes.EvaluatePerspectiveCorrect(screenX, screenY, components);
 
-		int textureArrayIndex = std::min((yOffset + xOffset) * 3, (m_TextureWidth * m_TextureHeight) * 3 - 1);
+	VSOut fragment;
+	fragment.FromComponents(components);
 
-		fragment.m_Color = Vec3
-		(
-			static_cast<float>(m_TextureData[textureArrayIndex]) / 255.0f,
-			static_cast<float>(m_TextureData[textureArrayIndex + 1]) / 255.0f,
-			static_cast<float>(m_TextureData[textureArrayIndex + 2]) / 255.0f
-		);
-	}
-	else
+	Vec3 textureColor = Vec3::One();
+	// Programs without texture coordinates are shaded as if the texture was white
+	if constexpr (VSOut::Contains(Varying::UvCoordinates))
 	{
-		fragment.m_Color = Vec3::One();
+		if (m_pTexture != nullptr)
+		{
+			textureColor = m_pTexture->Sample(GetVarying<Varying::UvCoordinates>(fragment));
+		}
 	}
 
-	m_Graphics.PutPixel(screenX, screenY, m_PixelShader.Main(fragment).m_Color);
+	return m_PixelShader.Main(fragment, textureColor).m_Color;
+}
+
+template<class TShaderProgram>
+inline bool GraphicsPipeline<TShaderProgram>::IsOutsideViewVolume(const VSOut& v1, const VSOut& v2, const VSOut& v3)
+{
+	// Cull triangles completley out of the view volume
+	// Near and far plane
+	if (v1.m_Position.z <= -v1.m_Position.w &&
+		v2.m_Position.z <= -v2.m_Position.w &&
+		v3.m_Position.z <= -v3.m_Position.w)
+		return true;
+	if (v1.m_Position.z >= v1.m_Position.w &&
+		v2.m_Position.z >= v2.m_Position.w &&
+		v3.m_Position.z >= v3.m_Position.w)
+		return true;
+
+	// Left and right plane
+	if (v1.m_Position.x <= -v1.m_Position.w &&
+		v2.m_Position.x <= -v2.m_Position.w &&
+		v3.m_Position.x <= -v3.m_Position.w)
+		return true;
+	if (v1.m_Position.x >= v1.m_Position.w &&
+		v2.m_Position.x >= v2.m_Position.w &&
+		v3.m_Position.x >= v3.m_Position.w)
+		return true;
+
+	// Bottom and top plane
+	if (v1.m_Position.y <= -v1.m_Position.w &&
+		v2.m_Position.y <= -v2.m_Position.w &&
+		v3.m_Position.y <= -v3.m_Position.w)
+		return true;
+	if (v1.m_Position.y >= v1.m_Position.w &&
+		v2.m_Position.y >= v2.m_Position.w &&
+		v3.m_Position.y >= v3.m_Position.w)
+		return true;
+
+	return false;
 }
 
 template<class TShaderProgram>
@@ -360,8 +594,8 @@ inline void GraphicsPipeline<TShaderProgram>::ClipSpaceToNDCSpaceTriangle(VSOut&
 template<class TShaderProgram>
 inline void GraphicsPipeline<TShaderProgram>::NDCSpaceToScreenSpaceVertex(VSOut& v)
 {
-	v.m_Position.x = Graphics::ScreenWidth / 2.0f * (1 + v.m_Position.x);
-	v.m_Position.y = Graphics::ScreenHeight / 2.0f * (1 - v.m_Position.y);
+	v.m_Position.x = m_ViewportWidth / 2.0f * (1 + v.m_Position.x);
+	v.m_Position.y = m_ViewportHeight / 2.0f * (1 - v.m_Position.y);
 }
 
 template<class TShaderProgram>
@@ -375,21 +609,21 @@ inline void GraphicsPipeline<TShaderProgram>::NDCSpaceToScreenSpaceTriangle(VSOu
 template<class TShaderProgram>
 inline void GraphicsPipeline<TShaderProgram>::ClearZBuffer()
 {
-	for (int i = 0; i < Graphics::ScreenHeight; i++)
-	{
-		for (int j = 0; j < Graphics::ScreenWidth; j++)
-		{
-			zBuffer[i][j] = std::numeric_limits<float>::max();
-		}
-	}
+	m_DepthBuffer.Clear();
+}
+
+template<class TShaderProgram>
+inline void GraphicsPipeline<TShaderProgram>::ResolveZBuffer()
+{
+	m_DepthBuffer.Resolve();
 }
 
 template<class TShaderProgram>
-inline void GraphicsPipeline<TShaderProgram>::DrawFlatTopTriangle(const VSOut& v1, const VSOut& v2, const VSOut& v3)
+inline void GraphicsPipeline<TShaderProgram>::DrawFlatTopTriangle(const Vec4& v1, const Vec4& v2, const Vec4& v3)
 {
-	const VSOut* pv2 = &v2;
-	const VSOut* pv3 = &v3;
-	if (pv2->m_Position.x > pv3->m_Position.x)
+	const Vec4* pv2 = &v2;
+	const Vec4* pv3 = &v3;
+	if (pv2->x > pv3->x)
 		std::swap(pv2, pv3);
 
 	DrawFlatTriangle
@@ -400,11 +634,11 @@ inline void GraphicsPipeline<TShaderProgram>::DrawFlatTopTriangle(const VSOut& v
 }
 
 template<class TShaderProgram>
-inline void GraphicsPipeline<TShaderProgram>::DrawFlatBottomTriangle(const VSOut& v1, const VSOut& v2, const VSOut& v3)
+inline void GraphicsPipeline<TShaderProgram>::DrawFlatBottomTriangle(const Vec4& v1, const Vec4& v2, const Vec4& v3)
 {
-	const VSOut* pv1 = &v1;
-	const VSOut* pv2 = &v2;
-	if (pv1->m_Position.x > pv2->m_Position.x)
+	const Vec4* pv1 = &v1;
+	const Vec4* pv2 = &v2;
+	if (pv1->x > pv2->x)
 		std::swap(pv1, pv2);
 
 	DrawFlatTriangle
@@ -415,46 +649,436 @@ inline void GraphicsPipeline<TShaderProgram>::DrawFlatBottomTriangle(const VSOut
 }
 
 template<class TShaderProgram>
-inline void GraphicsPipeline<TShaderProgram>::DrawFlatTriangle(const VSOut& leftEdgeFrom, const VSOut& leftEdgeTo, const VSOut& rightEdgeFrom, const VSOut& rightEdgeTo)
+inline void GraphicsPipeline<TShaderProgram>::DrawFlatTriangle(const Vec4& leftEdgeFrom, const Vec4& leftEdgeTo, const Vec4& rightEdgeFrom, const Vec4& rightEdgeTo)
 {
+	if constexpr (TShaderProgram::WritesColor)
+	{
+		if (m_pMultisampleTarget != nullptr)
+		{
+			DrawFlatTriangleMultisampled(leftEdgeFrom, leftEdgeTo, rightEdgeFrom, rightEdgeTo);
+			return;
+		}
+	}
+
 	// We're always going to send leftEdgeFrom and rightEdgeFrom to be at a lower y coordinate,
 	// which means they are always going to be on the "top" of the triangle
 
-	auto leftEdgeInterpolant = leftEdgeFrom;
-	auto rightEdgeInterpolant = rightEdgeFrom;
+	const float deltaY = leftEdgeTo.y - leftEdgeFrom.y;
+	const float leftStepX = (leftEdgeTo.x - leftEdgeFrom.x) / deltaY;
+	const float rightStepX = (rightEdgeTo.x - rightEdgeFrom.x) / deltaY;
+
+	int startY = std::max(static_cast<int>(std::ceil(leftEdgeFrom.y - 0.5f)), 0);
+	int endY = std::min(static_cast<int>(std::ceil(leftEdgeTo.y - 0.5f)), m_ViewportHeight - 1);
+
+	int startX[TraversalBlockSize];
+	int endX[TraversalBlockSize];
+
+	for (int bandY = startY, bandEndY; bandY < endY; bandY = bandEndY)
+	{
+		bandEndY = GetBandEnd(bandY, endY);
+		for (int curY = bandY; curY < bandEndY; curY++)
+		{
+			// Every row starts from the edge equations, nothing is carried over from the row above
+			const float centerY = static_cast<float>(curY) + 0.5f;
+			const float leftEdgeX = leftEdgeFrom.x + (centerY - leftEdgeFrom.y) * leftStepX;
+			const float rightEdgeX = rightEdgeFrom.x + (centerY - rightEdgeFrom.y) * rightStepX;
+
+			startX[curY - bandY] = std::max(static_cast<int>(std::ceil(leftEdgeX - 0.5f)), 0);
+			endX[curY - bandY] = std::min(static_cast<int>(std::ceil(rightEdgeX - 0.5f)), m_ViewportWidth - 1);
+		}
+
+		DrawBand(bandY, bandEndY - bandY, startX, endX);
+	}
+}
+
+template<class TShaderProgram>
+inline int GraphicsPipeline<TShaderProgram>::GetBandEnd(int bandY, int endY) const
+{
+	// Bands in block order are aligned to the block grid, only the first and last one of a triangle can be partial
+	if (m_PixelTraversal == PixelTraversal::Blocks)
+		return std::min((bandY & ~(TraversalBlockSize - 1)) + TraversalBlockSize, endY);
+
+	return bandY + 1;
+}
+
+template<class TShaderProgram>
+inline void GraphicsPipeline<TShaderProgram>::DrawBand(int bandY, int rowCount, const int (&startX)[TraversalBlockSize], const int (&endX)[TraversalBlockSize])
+{
+	int bandStartX = m_ViewportWidth;
+	int bandEndX = 0;
+	for (int row = 0; row < rowCount; row++)
+	{
+		if (startX[row] >= endX[row]) continue;
+
+		bandStartX = std::min(bandStartX, startX[row]);
+		bandEndX = std::max(bandEndX, endX[row]);
+	}
+	if (bandStartX >= bandEndX) return;
+
+	// Row order is a single column of blocks as wide as the viewport
+	const bool inBlocks = m_PixelTraversal == PixelTraversal::Blocks;
+	const int blockWidth = inBlocks ? TraversalBlockSize : m_ViewportWidth;
+	const int firstBlockX = inBlocks ? bandStartX & ~(TraversalBlockSize - 1) : bandStartX;
+
+	// Spans only step what the depth test needs, z and 1 / w
+	const float depthStepX = m_AttributePlanes.GetGradientX(VSOut::PositionZ);
+	const float wInverseStepX = m_AttributePlanes.GetGradientX(VSOut::PositionW);
+
+	for (int blockX = firstBlockX; blockX < bandEndX; blockX += blockWidth)
+	{
+		for (int row = 0; row < rowCount; row++)
+		{
+			const int spanStartX = std::max(startX[row], blockX);
+			const int spanEndX = std::min(endX[row], blockX + blockWidth);
+			if (spanStartX >= spanEndX) continue;
+
+			// Every piece of a span starts from the plane equations
+			const int curY = bandY + row;
+			m_PixelCount += spanEndX - spanStartX;
+			const float centerX = static_cast<float>(spanStartX) + 0.5f;
+			const float centerY = static_cast<float>(curY) + 0.5f;
+			float depth = m_AttributePlanes.Evaluate(VSOut::PositionZ, centerX, centerY);
+			float wInverse = m_AttributePlanes.Evaluate(VSOut::PositionW, centerX, centerY);
+
+			for (int curX = spanStartX; curX < spanEndX; curX++, depth += depthStepX, wInverse += wInverseStepX)
+			{
+				// The depth buffer keeps z with the divide by w undone
+				PixelProcessing(curX, curY, depth / wInverse);
+			}
+		}
+	}
+}
+
+template<class TShaderProgram>
+inline void GraphicsPipeline<TShaderProgram>::DrawFlatTriangleMultisampled(const Vec4& leftEdgeFrom, const Vec4& leftEdgeTo, const Vec4& rightEdgeFrom, const Vec4& rightEdgeTo)
+{
+	// Same edge walk as DrawFlatTriangle, but coverage and depth are evaluated at every sample position.
+	// Rows and spans are widened so that pixels whose center is outside but a sample is inside still get visited.
+	MultisampleTarget& target = *m_pMultisampleTarget;
+	const int sampleCount = target.GetSampleCount();
+
+	float minOffsetX = 0.0f, maxOffsetX = 0.0f, minOffsetY = 0.0f, maxOffsetY = 0.0f;
+	for (int i = 0; i < sampleCount; i++)
+	{
+		minOffsetX = std::min(minOffsetX, target.GetSampleOffset(i).x);
+		maxOffsetX = std::max(maxOffsetX, target.GetSampleOffset(i).x);
+		minOffsetY = std::min(minOffsetY, target.GetSampleOffset(i).y);
+		maxOffsetY = std::max(maxOffsetY, target.GetSampleOffset(i).y);
+	}
 
-	const float deltaY = leftEdgeTo.m_Position.y - leftEdgeFrom.m_Position.y;
-	const auto leftStep = (leftEdgeTo - leftEdgeFrom) / deltaY;
-	const auto rightStep = (rightEdgeTo - rightEdgeFrom) / deltaY;
+	const float topY = leftEdgeFrom.y;
+	const float bottomY = leftEdgeTo.y;
+	const float deltaY = bottomY - topY;
+	const float leftStepX = (leftEdgeTo.x - leftEdgeFrom.x) / deltaY;
+	const float rightStepX = (rightEdgeTo.x - rightEdgeFrom.x) / deltaY;
 
-	int startY = std::max(static_cast<int>(std::ceilf(leftEdgeFrom.m_Position.y - 0.5f)), 0);
-	int endY = std::min(static_cast<int>(std::ceilf(leftEdgeTo.m_Position.y - 0.5f)), Graphics::ScreenHeight - 1);
+	// Depth is NDC z, which is affine in screen space, so samples offset it by the plane gradients
+	const float depthStepX = m_AttributePlanes.GetGradientX(VSOut::PositionZ);
+	const float depthStepY = m_AttributePlanes.GetGradientY(VSOut::PositionZ);
 
-	// Prestep
-	leftEdgeInterpolant += (static_cast<float>(startY) + 0.5f - leftEdgeFrom.m_Position.y) * leftStep;
-	rightEdgeInterpolant += (static_cast<float>(startY) + 0.5f - rightEdgeFrom.m_Position.y) * rightStep;
+	const int startY = std::max(static_cast<int>(std::ceil(topY - 0.5f - maxOffsetY)), 0);
+	const int endY = std::min(static_cast<int>(std::ceil(bottomY - 0.5f - minOffsetY)), target.GetHeight());
 
-	for (int curY = startY; curY < endY; curY++, leftEdgeInterpolant += leftStep, rightEdgeInterpolant += rightStep)
+	float sampleLeftX[4];
+	float sampleRightX[4];
+	assert(sampleCount <= 4);
+
+	for (int curY = startY; curY < endY; curY++)
 	{
-		auto xInterpolant = leftEdgeInterpolant;
+		const float centerY = static_cast<float>(curY) + 0.5f;
+		const float leftEdgeX = leftEdgeFrom.x + (centerY - topY) * leftStepX;
+		const float rightEdgeX = rightEdgeFrom.x + (centerY - topY) * rightStepX;
+
+		// Edge positions at the height of each sample, and which samples of this row are inside the triangle vertically
+		unsigned int rowMask = 0u;
+		float spanStart = std::numeric_limits<float>::max();
+		float spanEnd = std::numeric_limits<float>::lowest();
+		for (int i = 0; i < sampleCount; i++)
+		{
+			const Vec2& offset = target.GetSampleOffset(i);
+			const float sampleY = centerY + offset.y;
+			if (sampleY < topY || sampleY >= bottomY) continue;
+
+			rowMask |= 1u << i;
+			sampleLeftX[i] = leftEdgeX + offset.y * leftStepX;
+			sampleRightX[i] = rightEdgeX + offset.y * rightStepX;
+			spanStart = std::min(spanStart, sampleLeftX[i] - offset.x);
+			spanEnd = std::max(spanEnd, sampleRightX[i] - offset.x);
+		}
+		if (rowMask == 0u) continue;
+
+		const int startX = std::max(static_cast<int>(std::ceil(spanStart - 0.5f)), 0);
+		const int endX = std::min(static_cast<int>(std::ceil(spanEnd - 0.5f)), target.GetWidth());
+		if (startX >= endX) continue;
+		m_PixelCount += endX - startX;
 
-		const float deltaX = rightEdgeInterpolant.m_Position.x - leftEdgeInterpolant.m_Position.x;
-		const auto xStep = (rightEdgeInterpolant - leftEdgeInterpolant) / deltaX;
+		float centerDepth = m_AttributePlanes.Evaluate(VSOut::PositionZ, static_cast<float>(startX) + 0.5f, centerY);
 
-		int startX = std::max(static_cast<int>(std::ceilf(leftEdgeInterpolant.m_Position.x - 0.5f)), 0);
-		int endX = std::min(static_cast<int>(std::ceilf(rightEdgeInterpolant.m_Position.x - 0.5f)), Graphics::ScreenWidth - 1);
+		for (int curX = startX; curX < endX; curX++, centerDepth += depthStepX)
+		{
+			PixelTimer timer(m_pHeatmap, curX, curY);
+			MultisampleTarget::Sample* pSamples = target.GetPixelSamples(curX, curY);
+			const float centerX = static_cast<float>(curX) + 0.5f;
+
+			// Coverage and depth test per sample
+			unsigned int passedMask = 0u;
+			for (int i = 0; i < sampleCount; i++)
+			{
+				const Vec2& offset = target.GetSampleOffset(i);
+				const float sampleX = centerX + offset.x;
+				if (!(rowMask & (1u << i)) || sampleX < sampleLeftX[i] || sampleX >= sampleRightX[i]) continue;
+
+				const float depth = centerDepth + offset.x * depthStepX + offset.y * depthStepY;
+				if (depth >= pSamples[i].m_Depth) continue;
+
+				pSamples[i].m_Depth = depth;
+				passedMask |= 1u << i;
+			}
+			if (passedMask == 0u) continue;
+
+			ShadeSamples(pSamples, passedMask, centerX, centerY);
+		}
+	}
+}
 
-		xInterpolant += (static_cast<float>(startX) + 0.5f - leftEdgeInterpolant.m_Position.x) * xStep;
+template<class TShaderProgram>
+inline void GraphicsPipeline<TShaderProgram>::ShadeSamples(MultisampleTarget::Sample* pSamples, unsigned int passedMask, float centerX, float centerY)
+{
+	const MultisampleTarget& target = *m_pMultisampleTarget;
 
-		for (int curX = startX; curX < endX; curX++, xInterpolant += xStep)
+	if (target.ShadesPerSample())
+	{
+		for (int i = 0; i < target.GetSampleCount(); i++)
 		{
-			auto fragment = xInterpolant;
-			const float w = 1.0f / fragment.m_Position.w;
-			fragment *= w;
+			if (!(passedMask & (1u << i))) continue;
+
+			pSamples[i].m_Color = ShadeFragment(centerX + target.GetSampleOffset(i).x, centerY + target.GetSampleOffset(i).y);
+		}
+	}
+	else
+	{
+		// Shade once at the pixel center and share the result between the samples that passed
+		const Color color = ShadeFragment(centerX, centerY);
 
-			PixelProcessing(curX, curY, fragment);
+		for (int i = 0; i < target.GetSampleCount(); i++)
+		{
+			if (passedMask & (1u << i)) pSamples[i].m_Color = color;
 		}
 	}
 }
 
-#pragma endregion
+template<class TShaderProgram>
+inline int GraphicsPipeline<TShaderProgram>::GetProfilerTile(const Vec2& v1, const Vec2& v2, const Vec2& v3) const
+{
+	return m_pProfiler->GetTile
+	(
+		(std::min({ v1.x, v2.x, v3.x }) + std::max({ v1.x, v2.x, v3.x })) / 2.0f,
+		(std::min({ v1.y, v2.y, v3.y }) + std::max({ v1.y, v2.y, v3.y })) / 2.0f
+	);
+}
+
+template<class TShaderProgram>
+inline void GraphicsPipeline<TShaderProgram>::HomogeneousRasterization(const VSOut& v1, const VSOut& v2, const VSOut& v3)
+{
+	if (IsOutsideViewVolume(v1, v2, v3)) return;
+
+	// Viewport transform without the divide: (x, y, w) is the screen position times w
+	const VSOut* vertices[3] = { &v1, &v2, &v3 };
+	Vec3 screen[3];
+	bool allInFront = true;
+	for (int i = 0; i < 3; i++)
+	{
+		const Vec4& position = vertices[i]->m_Position;
+		screen[i] = Vec3
+		(
+			m_ViewportWidth / 2.0f * (position.w + position.x),
+			m_ViewportHeight / 2.0f * (position.w - position.y),
+			position.w
+		);
+		allInFront = allInFront && position.w > 0.0f;
+	}
+
+	// Triangles reaching behind the camera have no bounding box on the screen, the profiler counts them in no tile
+	const int tile = m_pProfiler != nullptr && allInFront ? GetProfilerTile
+	(
+		Vec2(screen[0].x / screen[0].z, screen[0].y / screen[0].z),
+		Vec2(screen[1].x / screen[1].z, screen[1].y / screen[1].z),
+		Vec2(screen[2].x / screen[2].z, screen[2].y / screen[2].z)
+	) : -1;
+	PipelineProfiler::Scope scope(m_pProfiler, PipelineProfiler::Stage::Rasterization, tile, &m_PixelCount);
+
+	// The rows of the inverse of the matrix with the vertices as columns are the edge functions,
+	// each gives the barycentric coordinate of its vertex divided by w at a screen position
+	const float determinant = Vec3::Dot(screen[0], Vec3::Cross(screen[1], screen[2]));
+	if (determinant == 0.0f) return;
+
+	const float determinantInverse = 1.0f / determinant;
+	const Vec3 edges[3] =
+	{
+		Vec3::Cross(screen[1], screen[2]) * determinantInverse,
+		Vec3::Cross(screen[2], screen[0]) * determinantInverse,
+		Vec3::Cross(screen[0], screen[1]) * determinantInverse
+	};
+
+	m_AttributePlanes.SetupHomogeneous(v1, v2, v3, edges);
+
+	// A point is covered when all three edge functions are non-negative, which also means it is in front of the camera
+	// (their sum is 1 / w). The near plane adds the fourth constraint NDC z >= -1, NDC z being affine in screen space.
+	const Vec3 constraints[4] =
+	{
+		edges[0],
+		edges[1],
+		edges[2],
+		Vec3
+		(
+			m_AttributePlanes.GetGradientX(VSOut::PositionZ),
+			m_AttributePlanes.GetGradientY(VSOut::PositionZ),
+			m_AttributePlanes.Evaluate(VSOut::PositionZ, 0.0f, 0.0f) + 1.0f
+		)
+	};
+
+	// Rows outside the projected vertices can only be skipped while no vertex is behind the camera,
+	// otherwise the triangle projects to an unbounded region and every row is visited
+	int startY = 0;
+	int endY = m_ViewportHeight;
+	if (allInFront)
+	{
+		float minY = std::numeric_limits<float>::max();
+		float maxY = std::numeric_limits<float>::lowest();
+		for (int i = 0; i < 3; i++)
+		{
+			minY = std::min(minY, screen[i].y / screen[i].z);
+			maxY = std::max(maxY, screen[i].y / screen[i].z);
+		}
+
+		// One pixel of margin covers sample offsets
+		startY = std::max(static_cast<int>(std::floor(minY)) - 1, 0);
+		endY = std::min(static_cast<int>(std::ceil(maxY)) + 1, m_ViewportHeight);
+	}
+
+	DrawHomogeneousTriangle(constraints, startY, endY);
+}
+
+template<class TShaderProgram>
+inline void GraphicsPipeline<TShaderProgram>::DrawHomogeneousTriangle(const Vec3 (&constraints)[4], int startY, int endY)
+{
+	if constexpr (TShaderProgram::WritesColor)
+	{
+		if (m_pMultisampleTarget != nullptr)
+		{
+			DrawHomogeneousTriangleMultisampled(constraints, startY, endY);
+			return;
+		}
+	}
+
+	int startX[TraversalBlockSize];
+	int endX[TraversalBlockSize];
+
+	for (int bandY = startY, bandEndY; bandY < endY; bandY = bandEndY)
+	{
+		bandEndY = GetBandEnd(bandY, endY);
+		for (int curY = bandY; curY < bandEndY; curY++)
+		{
+			const int row = curY - bandY;
+			if (!HomogeneousSpan(constraints, static_cast<float>(curY) + 0.5f, 0.0f, startX[row], endX[row]))
+			{
+				startX[row] = endX[row] = 0;
+			}
+		}
+
+		DrawBand(bandY, bandEndY - bandY, startX, endX);
+	}
+}
+
+template<class TShaderProgram>
+inline void GraphicsPipeline<TShaderProgram>::DrawHomogeneousTriangleMultisampled(const Vec3 (&constraints)[4], int startY, int endY)
+{
+	// Same as DrawHomogeneousTriangle with one span per sample position, coverage of a sample is whether the pixel is in its span
+	MultisampleTarget& target = *m_pMultisampleTarget;
+	const int sampleCount = target.GetSampleCount();
+
+	const float depthStepX = m_AttributePlanes.GetGradientX(VSOut::PositionZ);
+	const float depthStepY = m_AttributePlanes.GetGradientY(VSOut::PositionZ);
+
+	int sampleStartX[4];
+	int sampleEndX[4];
+	assert(sampleCount <= 4);
+
+	for (int curY = startY; curY < endY; curY++)
+	{
+		const float centerY = static_cast<float>(curY) + 0.5f;
+
+		// Pixels with at least one covered sample
+		int startX = m_ViewportWidth;
+		int endX = 0;
+		for (int i = 0; i < sampleCount; i++)
+		{
+			if (!HomogeneousSpan(constraints, centerY + target.GetSampleOffset(i).y, target.GetSampleOffset(i).x, sampleStartX[i], sampleEndX[i]))
+			{
+				sampleStartX[i] = sampleEndX[i] = 0;
+				continue;
+			}
+
+			startX = std::min(startX, sampleStartX[i]);
+			endX = std::max(endX, sampleEndX[i]);
+		}
+		if (startX >= endX) continue;
+		m_PixelCount += endX - startX;
+
+		float centerDepth = m_AttributePlanes.Evaluate(VSOut::PositionZ, static_cast<float>(startX) + 0.5f, centerY);
+
+		for (int curX = startX; curX < endX; curX++, centerDepth += depthStepX)
+		{
+			PixelTimer timer(m_pHeatmap, curX, curY);
+			MultisampleTarget::Sample* pSamples = target.GetPixelSamples(curX, curY);
+			const float centerX = static_cast<float>(curX) + 0.5f;
+
+			unsigned int passedMask = 0u;
+			for (int i = 0; i < sampleCount; i++)
+			{
+				if (curX < sampleStartX[i] || curX >= sampleEndX[i]) continue;
+
+				const Vec2& offset = target.GetSampleOffset(i);
+				const float depth = centerDepth + offset.x * depthStepX + offset.y * depthStepY;
+				if (depth >= pSamples[i].m_Depth) continue;
+
+				pSamples[i].m_Depth = depth;
+				passedMask |= 1u << i;
+			}
+			if (passedMask == 0u) continue;
+
+			ShadeSamples(pSamples, passedMask, centerX, centerY);
+		}
+	}
+}
+
+template<class TShaderProgram>
+inline bool GraphicsPipeline<TShaderProgram>::HomogeneousSpan(const Vec3 (&constraints)[4], float sampleY, float offsetX, int& startX, int& endX) const
+{
+	// Every constraint is affine along the row, so it bounds the covered pixels from one side
+	float lowestX = 0.0f;
+	float highestX = static_cast<float>(m_ViewportWidth - 1);
+	for (const Vec3& constraint : constraints)
+	{
+		const float rowValue = constraint.y * sampleY + constraint.z;
+		if (constraint.x == 0.0f)
+		{
+			if (rowValue < 0.0f) return false;
+			continue;
+		}
+
+		// Index of the pixel whose sample lies exactly on the constraint's line
+		const float boundaryX = -rowValue / constraint.x - 0.5f - offsetX;
+		if (constraint.x > 0.0f)
+			lowestX = std::max(lowestX, boundaryX);
+		else
+			highestX = std::min(highestX, boundaryX);
+	}
+	if (!(lowestX <= highestX)) return false;
+
+	startX = static_cast<int>(std::ceil(lowestX));
+	endX = static_cast<int>(std::floor(highestX)) + 1;
+	return startX < endX;
+}
+
+#pragma endregion
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "Colors.h"
+
+// Graphics of builds without a window (ENGINE_HEADLESS, see Headless/CMakeLists.txt). The frame is a color buffer
+// in memory that nothing presents, with the interface the pipelines, the replays and the benchmarks draw through,
+// so they run and produce the same images on any platform.
+class Graphics
+{
+public:
+	Graphics() : m_Pixels(static_cast<size_t>(ScreenWidth) * ScreenHeight) {}
+	Graphics(const Graphics&) = delete;
+	Graphics& operator=(const Graphics&) = delete;
+
+	void BeginFrame()
+	{
+		std::fill(m_Pixels.begin(), m_Pixels.end(), Color(m_BackgroundColor, m_BackgroundColor, m_BackgroundColor, m_BackgroundColor));
+	}
+	void EndFrame() {}
+
+	void PutPixel(int x, int y, int r, int g, int b)
+	{
+		PutPixel(x, y, { static_cast<unsigned char>(r), static_cast<unsigned char>(g), static_cast<unsigned char>(b) });
+	}
+	void PutPixel(int x, int y, Color c)
+	{
+		assert(x >= 0 && x < ScreenWidth && y >= 0 && y < ScreenHeight);
+		m_Pixels[static_cast<size_t>(y) * ScreenWidth + x] = c;
+	}
+	Color GetPixel(int x, int y) const
+	{
+		assert(x >= 0 && x < ScreenWidth && y >= 0 && y < ScreenHeight);
+		return m_Pixels[static_cast<size_t>(y) * ScreenWidth + x];
+	}
+	void SetBackgroundColor(unsigned char value) { m_BackgroundColor = value; }
+
+private:
+	std::vector<Color> m_Pixels;
+	unsigned char m_BackgroundColor = 0u;
+
+public:
+	static constexpr int ScreenWidth = 1280;
+	static constexpr int ScreenHeight = 960;
+	static constexpr float AspectRatio = static_cast<float>(Graphics::ScreenWidth) / Graphics::ScreenHeight;
+};
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+
+#include "Heatmap.h"
+#include "Graphics.h"
+
+namespace
+{
+	// Blue through cyan, green and yellow to red
+	Color Ramp(float t)
+	{
+		static const float stops[][3] =
+		{
+			{ 0.0f, 0.0f, 1.0f },
+			{ 0.0f, 1.0f, 1.0f },
+			{ 0.0f, 1.0f, 0.0f },
+			{ 1.0f, 1.0f, 0.0f },
+			{ 1.0f, 0.0f, 0.0f }
+		};
+		constexpr int lastStop = 4;
+
+		const float position = std::min(std::max(t, 0.0f), 1.0f) * lastStop;
+		const int stop = std::min(static_cast<int>(position), lastStop - 1);
+		const float blend = position - stop;
+
+		unsigned char channels[3];
+		for (int i = 0; i < 3; i++)
+		{
+			const float value = stops[stop][i] + (stops[stop + 1][i] - stops[stop][i]) * blend;
+			channels[i] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+		}
+
+		return Color(channels[0], channels[1], channels[2]);
+	}
+
+	// Uncompressed 24 bit BMP, rows bottom up and padded to 4 bytes
+	bool WriteBitmap(const std::string& path, int width, int height, const std::function<Color(int, int)>& getPixel)
+	{
+		std::error_code error;
+		const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+		if (!directory.empty()) std::filesystem::create_directories(directory, error);
+
+		std::ofstream stream(path, std::ios::binary);
+		if (!stream) return false;
+
+		const uint32_t rowBytes = (static_cast<uint32_t>(width) * 3u + 3u) & ~3u;
+		const uint32_t imageBytes = rowBytes * static_cast<uint32_t>(height);
+		constexpr uint32_t headerBytes = 14u + 40u;
+
+		auto write16 = [&stream](uint16_t value) { stream.put(static_cast<char>(value & 0xFFu)).put(static_cast<char>(value >> 8)); };
+		auto write32 = [&write16](uint32_t value) { write16(static_cast<uint16_t>(value & 0xFFFFu)); write16(static_cast<uint16_t>(value >> 16)); };
+
+		stream.put('B').put('M');
+		write32(headerBytes + imageBytes);
+		write32(0u);
+		write32(headerBytes);
+
+		write32(40u);
+		write32(static_cast<uint32_t>(width));
+		write32(static_cast<uint32_t>(height));
+		write16(1u);
+		write16(24u);
+		write32(0u);
+		write32(imageBytes);
+		write32(2835u);
+		write32(2835u);
+		write32(0u);
+		write32(0u);
+
+		std::vector<char> row(rowBytes, 0);
+		for (int y = height - 1; y >= 0; y--)
+		{
+			for (int x = 0; x < width; x++)
+			{
+				const Color color = getPixel(x, y);
+				row[x * 3 + 0] = static_cast<char>(color.GetB());
+				row[x * 3 + 1] = static_cast<char>(color.GetG());
+				row[x * 3 + 2] = static_cast<char>(color.GetR());
+			}
+			stream.write(row.data(), row.size());
+		}
+
+		return static_cast<bool>(stream);
+	}
+}
+
+Heatmap::Heatmap(int width, int height)
+	:
+	m_Width(width),
+	m_Height(height),
+	m_Fragments(static_cast<size_t>(width) * height, 0u),
+	m_Ticks(static_cast<size_t>(width) * height, 0u)
+{
+}
+
+void Heatmap::Clear()
+{
+	std::fill(m_Fragments.begin(), m_Fragments.end(), 0u);
+	std::fill(m_Ticks.begin(), m_Ticks.end(), 0u);
+}
+
+std::vector<float> Heatmap::Evaluate(View view, float& scale) const
+{
+	// Negative where nothing was drawn
+	std::vector<float> values(m_Fragments.size(), -1.0f);
+
+	if (view == View::Overdraw)
+	{
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (m_Fragments[i] > 0u) values[i] = static_cast<float>(m_Fragments[i]);
+		}
+		scale = static_cast<float>(OverdrawScale);
+		return values;
+	}
+
+	if (view == View::PixelCost)
+	{
+		for (size_t i = 0; i < values.size(); i++)
+		{
+			if (m_Fragments[i] > 0u) values[i] = static_cast<float>(m_Ticks[i]);
+		}
+	}
+	else
+	{
+		// Every pixel of a tile gets the cost of the tile per pixel
+		for (int tileY = 0; tileY < m_Height; tileY += TileSize)
+		{
+			for (int tileX = 0; tileX < m_Width; tileX += TileSize)
+			{
+				const int endX = std::min(tileX + TileSize, m_Width);
+				const int endY = std::min(tileY + TileSize, m_Height);
+
+				uint64_t ticks = 0u;
+				uint64_t fragments = 0u;
+				for (int y = tileY; y < endY; y++)
+				{
+					for (int x = tileX; x < endX; x++)
+					{
+						ticks += m_Ticks[static_cast<size_t>(y) * m_Width + x];
+						fragments += m_Fragments[static_cast<size_t>(y) * m_Width + x];
+					}
+				}
+				if (fragments == 0u) continue;
+
+				const float value = static_cast<float>(ticks) / ((endX - tileX) * (endY - tileY));
+				for (int y = tileY; y < endY; y++)
+				{
+					std::fill(values.begin() + static_cast<size_t>(y) * m_Width + tileX, values.begin() + static_cast<size_t>(y) * m_Width + endX, value);
+				}
+			}
+		}
+	}
+
+	// Single pixels hit by an interrupt or a page fault would otherwise leave everything else blue
+	std::vector<float> drawn;
+	for (float value : values)
+	{
+		if (value >= 0.0f) drawn.push_back(value);
+	}
+	scale = 1.0f;
+	if (!drawn.empty())
+	{
+		const size_t percentile = static_cast<size_t>(0.99 * (drawn.size() - 1u));
+		std::nth_element(drawn.begin(), drawn.begin() + percentile, drawn.end());
+		scale = std::max(drawn[percentile], 1.0f);
+	}
+
+	return values;
+}
+
+std::vector<Color> Heatmap::Colorize(View view) const
+{
+	float scale;
+	const std::vector<float> values = Evaluate(view, scale);
+
+	std::vector<Color> colors(values.size());
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		colors[i] = values[i] < 0.0f ? Color(0u, 0u, 0u) : Ramp(values[i] / scale);
+	}
+
+	return colors;
+}
+
+void Heatmap::Resolve(Graphics& graphics, View view) const
+{
+	const std::vector<Color> colors = Colorize(view);
+
+	const int width = std::min(m_Width, static_cast<int>(Graphics::ScreenWidth));
+	const int height = std::min(m_Height, static_cast<int>(Graphics::ScreenHeight));
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
+		{
+			graphics.PutPixel(x, y, colors[static_cast<size_t>(y) * m_Width + x]);
+		}
+	}
+}
+
+bool Heatmap::WriteImage(const std::string& path, View view) const
+{
+	const std::vector<Color> colors = Colorize(view);
+	return WriteBitmap(path, m_Width, m_Height, [this, &colors](int x, int y) { return colors[static_cast<size_t>(y) * m_Width + x]; });
+}
+
+bool Heatmap::WriteScreen(const Graphics& graphics, const std::string& path)
+{
+	return WriteBitmap(path, Graphics::ScreenWidth, Graphics::ScreenHeight, [&graphics](int x, int y) { return graphics.GetPixel(x, y); });
+}
+
+std::string Heatmap::GetReport() const
+{
+	uint64_t fragments = 0u;
+	uint64_t ticks = 0u;
+	uint64_t coveredPixels = 0u;
+	uint64_t overdrawnPixels = 0u;
+	uint32_t maxFragments = 0u;
+	for (size_t i = 0; i < m_Fragments.size(); i++)
+	{
+		fragments += m_Fragments[i];
+		ticks += m_Ticks[i];
+		coveredPixels += m_Fragments[i] > 0u ? 1u : 0u;
+		overdrawnPixels += m_Fragments[i] >= OverdrawScale ? 1u : 0u;
+		maxFragments = std::max(maxFragments, m_Fragments[i]);
+	}
+
+	std::ostringstream report;
+	report << std::fixed << std::setprecision(2)
+		<< "Heatmap: " << fragments << " fragments on " << coveredPixels << " pixels, overdraw "
+		<< (coveredPixels > 0u ? static_cast<double>(fragments) / coveredPixels : 0.0) << " on average, " << maxFragments << " at most, "
+		<< overdrawnPixels << " pixels with " << OverdrawScale << " or more; "
+		<< (fragments > 0u ? static_cast<double>(ticks) / fragments : 0.0) << (ENGINE_HEATMAP_RDTSC ? " ticks" : " ns") << " per fragment\n";
+
+	return report.str();
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define ENGINE_HEATMAP_RDTSC 1
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <x86intrin.h>
+	#endif
+#else
+	#define ENGINE_HEATMAP_RDTSC 0
+#endif
+
+#include "Colors.h"
+
+class Graphics;
+
+// Per pixel diagnostics of the main pass: how many fragments were depth tested at every pixel and how long testing and
+// shading them took. Only pipelines of a HeatmapProgram fill one (see GraphicsPipeline::BindHeatmap), every other
+// pipeline is compiled without the code. Shown over the frame by Resolve, or written to an image next to a screenshot.
+class Heatmap
+{
+public:
+	enum class View
+	{
+		// Fragments per pixel, OverdrawScale of them and more are red
+		Overdraw,
+		// Time spent on a pixel, relative to the 99th percentile of the frame
+		PixelCost,
+		// Same, averaged over tiles of TileSize pixels, so costly regions stand out rather than single pixels
+		TileCost
+	};
+
+	Heatmap(int width, int height);
+
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+
+	void Clear();
+
+	// Time stamp counter ticks where the CPU has one, nanoseconds otherwise
+	static uint64_t ReadTimestamp()
+	{
+#if ENGINE_HEATMAP_RDTSC
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	void AddFragment(int x, int y, uint64_t ticks)
+	{
+		const size_t index = static_cast<size_t>(y) * m_Width + x;
+		m_Fragments[index]++;
+		m_Ticks[index] += ticks;
+	}
+
+	// Adds a fragment that took from construction to destruction to the pixel, nothing without a heatmap
+	class PixelTimer
+	{
+	public:
+		PixelTimer(Heatmap* pHeatmap, int x, int y)
+			:
+			m_pHeatmap(pHeatmap),
+			m_X(x),
+			m_Y(y),
+			m_Start(pHeatmap != nullptr ? ReadTimestamp() : 0u)
+		{
+		}
+		~PixelTimer()
+		{
+			if (m_pHeatmap != nullptr) m_pHeatmap->AddFragment(m_X, m_Y, ReadTimestamp() - m_Start);
+		}
+		PixelTimer(const PixelTimer&) = delete;
+		PixelTimer& operator=(const PixelTimer&) = delete;
+
+	private:
+		Heatmap* m_pHeatmap;
+		int m_X;
+		int m_Y;
+		uint64_t m_Start;
+	};
+
+	// Stands in for PixelTimer in pipelines compiled without heatmaps
+	struct NoPixelTimer
+	{
+		NoPixelTimer(Heatmap*, int, int) { }
+	};
+
+	// Writes the view over the whole screen, pixels no fragment reached are black
+	void Resolve(Graphics& graphics, View view) const;
+	bool WriteImage(const std::string& path, View view) const;
+	// The frame as it is before Resolve, to compare the heatmap with
+	static bool WriteScreen(const Graphics& graphics, const std::string& path);
+
+	// Overdraw and cost totals of the frame
+	std::string GetReport() const;
+
+	static constexpr int TileSize = 16;
+	static constexpr uint32_t OverdrawScale = 8u;
+
+private:
+	// Values of the view per pixel and the value shown red
+	std::vector<float> Evaluate(View view, float& scale) const;
+	std::vector<Color> Colorize(View view) const;
+
+	int m_Width;
+	int m_Height;
+	std::vector<uint32_t> m_Fragments;
+	std::vector<uint64_t> m_Ticks;
+};
+
+// Draws what TProgram draws, and has the pipeline fill the bound heatmap on the way. A program of its own,
+// so that only pipelines made for the debug view carry the timing code.
+template <class TProgram>
+class HeatmapProgram : public TProgram
+{
+public:
+	static constexpr bool RecordsHeatmap = true;
+};
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include <filesystem>
+#include <fstream>
+
+#include "InputRecording.h"
+#include "Keyboard.h"
+#include "Mouse.h"
+
+namespace
+{
+	// The bytes "INT\x01" as a little endian word, the last one is the version and bumped whenever the layout changes
+	constexpr uint32_t RecordingMagic = 0x01544E49u;
+	constexpr uint32_t MaxEventCount = 1u << 24;
+
+	template <class T>
+	bool WriteValue(std::ostream& stream, const T& value)
+	{
+		return static_cast<bool>(stream.write(reinterpret_cast<const char*>(&value), sizeof(T)));
+	}
+
+	template <class T>
+	bool ReadValue(std::istream& stream, T& value)
+	{
+		return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+	}
+}
+
+InputRecording::~InputRecording()
+{
+	Stop();
+}
+
+void InputRecording::StartRecording(Keyboard& keyboard, Mouse& mouse)
+{
+	Stop();
+
+	// Keys held when the recording starts would be released in it without ever being pressed
+	ClearDevices(keyboard, mouse);
+
+	Attach(&keyboard, &mouse);
+	m_State = State::Recording;
+	m_Events.clear();
+	m_FrameCount = 0u;
+}
+
+void InputRecording::StartPlayback(Keyboard& keyboard, Mouse& mouse)
+{
+	Stop();
+
+	// Nothing pressed before the recording started may leak into the playback
+	ClearDevices(keyboard, mouse);
+
+	Attach(&keyboard, &mouse);
+	m_State = State::Playing;
+}
+
+void InputRecording::Stop()
+{
+	if (m_State == State::Recording) m_FrameCount = m_BegunFrames;
+
+	Attach(nullptr, nullptr);
+	m_State = State::Idle;
+}
+
+void InputRecording::ClearDevices(Keyboard& keyboard, Mouse& mouse)
+{
+	keyboard.ClearState();
+	keyboard.Flush();
+	mouse.leftIsPressed = false;
+	mouse.rightIsPressed = false;
+	mouse.Flush();
+}
+
+void InputRecording::Attach(Keyboard* pKeyboard, Mouse* pMouse)
+{
+	if (m_pKeyboard != nullptr) m_pKeyboard->pRecording = nullptr;
+	if (m_pMouse != nullptr) m_pMouse->pRecording = nullptr;
+
+	m_pKeyboard = pKeyboard;
+	m_pMouse = pMouse;
+	if (m_pKeyboard != nullptr) m_pKeyboard->pRecording = this;
+	if (m_pMouse != nullptr) m_pMouse->pRecording = this;
+
+	m_BegunFrames = 0u;
+	m_NextEvent = 0u;
+	m_Start = std::chrono::steady_clock::now();
+}
+
+void InputRecording::BeginFrame()
+{
+	if (m_State == State::Playing)
+	{
+		// Detached meanwhile, the devices take the events like input of the window
+		m_pKeyboard->pRecording = nullptr;
+		m_pMouse->pRecording = nullptr;
+		for (; m_NextEvent < m_Events.size() && m_Events[m_NextEvent].m_Frame <= m_BegunFrames; m_NextEvent++)
+		{
+			Apply(m_Events[m_NextEvent]);
+		}
+		m_pKeyboard->pRecording = this;
+		m_pMouse->pRecording = this;
+	}
+
+	m_BegunFrames++;
+}
+
+bool InputRecording::IsPlaybackFinished() const
+{
+	return m_NextEvent == m_Events.size() && m_BegunFrames >= m_FrameCount;
+}
+
+float InputRecording::GetTime() const
+{
+	if (m_State == State::Playing) return m_BegunFrames * FixedTimestep;
+
+	const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - m_Start;
+	return elapsed.count();
+}
+
+bool InputRecording::OnInput(EventType type, int code, int x, int y)
+{
+	if (m_State == State::Playing) return false;
+
+	if (m_State == State::Recording)
+	{
+		const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_Start;
+		m_Events.push_back({ m_BegunFrames, elapsed.count(), type, static_cast<uint8_t>(code), static_cast<int16_t>(x), static_cast<int16_t>(y) });
+	}
+
+	return true;
+}
+
+void InputRecording::Apply(const Event& event)
+{
+	Keyboard& keyboard = *m_pKeyboard;
+	Mouse& mouse = *m_pMouse;
+
+	switch (event.m_Type)
+	{
+	case EventType::KeyPressed: keyboard.OnKeyPressed(event.m_Code); break;
+	case EventType::KeyReleased: keyboard.OnKeyReleased(event.m_Code); break;
+	case EventType::Char: keyboard.OnChar(static_cast<char>(event.m_Code)); break;
+	case EventType::KeyboardCleared: keyboard.ClearState(); break;
+	case EventType::MouseMove: mouse.OnMouseMove(event.m_X, event.m_Y); break;
+	case EventType::MouseEnter: mouse.OnMouseEnter(); break;
+	case EventType::MouseLeave: mouse.OnMouseLeave(); break;
+	case EventType::LeftPressed: mouse.OnLeftPressed(event.m_X, event.m_Y); break;
+	case EventType::LeftReleased: mouse.OnLeftReleased(event.m_X, event.m_Y); break;
+	case EventType::RightPressed: mouse.OnRightPressed(event.m_X, event.m_Y); break;
+	case EventType::RightReleased: mouse.OnRightReleased(event.m_X, event.m_Y); break;
+	case EventType::WheelUp: mouse.OnWheelUp(event.m_X, event.m_Y); break;
+	case EventType::WheelDown: mouse.OnWheelDown(event.m_X, event.m_Y); break;
+	}
+}
+
+bool InputRecording::Write(const std::string& path) const
+{
+	std::error_code error;
+	const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	if (!directory.empty()) std::filesystem::create_directories(directory, error);
+
+	std::ofstream stream(path, std::ios::binary);
+	if (!stream) return false;
+
+	// A recording still running spans the frames begun so far
+	const uint32_t frameCount = m_State == State::Recording ? m_BegunFrames : m_FrameCount;
+	bool written =
+		WriteValue(stream, RecordingMagic) &&
+		WriteValue(stream, frameCount) &&
+		WriteValue(stream, static_cast<uint32_t>(m_Events.size()));
+
+	// Field by field, the struct has padding
+	for (const Event& event : m_Events)
+	{
+		written = written &&
+			WriteValue(stream, event.m_Frame) &&
+			WriteValue(stream, event.m_Milliseconds) &&
+			WriteValue(stream, event.m_Type) &&
+			WriteValue(stream, event.m_Code) &&
+			WriteValue(stream, event.m_X) &&
+			WriteValue(stream, event.m_Y);
+	}
+
+	return written;
+}
+
+bool InputRecording::Read(const std::string& path)
+{
+	m_Events.clear();
+	m_FrameCount = 0u;
+
+	std::ifstream stream(path, std::ios::binary);
+
+	uint32_t magic, frameCount, eventCount;
+	if (!ReadValue(stream, magic) || magic != RecordingMagic ||
+		!ReadValue(stream, frameCount) || !ReadValue(stream, eventCount) || eventCount > MaxEventCount)
+	{
+		return false;
+	}
+
+	bool read = true;
+	m_Events.resize(eventCount);
+	for (size_t i = 0; i < m_Events.size() && read; i++)
+	{
+		Event& event = m_Events[i];
+		read =
+			ReadValue(stream, event.m_Frame) &&
+			ReadValue(stream, event.m_Milliseconds) &&
+			ReadValue(stream, event.m_Type) &&
+			ReadValue(stream, event.m_Code) &&
+			ReadValue(stream, event.m_X) &&
+			ReadValue(stream, event.m_Y) &&
+			event.m_Type <= EventType::WheelDown &&
+			// In the order they arrived
+			event.m_Frame <= frameCount && (i == 0 || event.m_Frame >= m_Events[i - 1].m_Frame);
+	}
+
+	if (!read)
+	{
+		m_Events.clear();
+		return false;
+	}
+
+	m_FrameCount = frameCount;
+	return true;
+}
\ No newline at end of file
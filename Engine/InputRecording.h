@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Keyboard;
+class Mouse;
+
+// Input of a Keyboard and a Mouse, recorded as it arrives and played back into them later, so the same camera and
+// model path can be run again without anyone at the keys. Every event carries the frame it arrived in and the
+// time since the recording started. Playback runs on a fixed timestep: the events of a frame are handed over when
+// that frame begins, however long the frames take now, and GetTime advances by FixedTimestep per frame.
+// Input of the window is dropped during playback.
+class InputRecording
+{
+public:
+	enum class EventType : uint8_t
+	{
+		KeyPressed,
+		KeyReleased,
+		Char,
+		KeyboardCleared,
+		MouseMove,
+		MouseEnter,
+		MouseLeave,
+		LeftPressed,
+		LeftReleased,
+		RightPressed,
+		RightReleased,
+		WheelUp,
+		WheelDown
+	};
+
+	// Input that arrived after m_Frame calls to BeginFrame, it is handed over by the next one
+	struct Event
+	{
+		uint32_t m_Frame;
+		float m_Milliseconds;
+		EventType m_Type;
+		// Key code or character
+		uint8_t m_Code;
+		int16_t m_X;
+		int16_t m_Y;
+	};
+
+	InputRecording() = default;
+	~InputRecording();
+
+	InputRecording(const InputRecording&) = delete;
+	InputRecording& operator=(const InputRecording&) = delete;
+
+	// Both start over from frame zero with the current state of the devices cleared
+	void StartRecording(Keyboard& keyboard, Mouse& mouse);
+	void StartPlayback(Keyboard& keyboard, Mouse& mouse);
+	// Detaches from the devices, the events stay
+	void Stop();
+
+	// Call at the start of every frame, before the input is read. Hands over the events of the frame during playback.
+	void BeginFrame();
+
+	bool IsRecording() const { return m_State == State::Recording; }
+	bool IsPlaying() const { return m_State == State::Playing; }
+	// Every event was handed over and as many frames were begun as were recorded
+	bool IsPlaybackFinished() const;
+
+	// Calls to BeginFrame since the start
+	uint32_t GetBegunFrames() const { return m_BegunFrames; }
+	// Seconds since the start, FixedTimestep per frame during playback
+	float GetTime() const;
+
+	const std::vector<Event>& GetEvents() const { return m_Events; }
+	// Frames the recording spans
+	uint32_t GetFrameCount() const { return m_FrameCount; }
+
+	bool Write(const std::string& path) const;
+	// Leaves the recording empty when the file can't be read
+	bool Read(const std::string& path);
+
+	static constexpr float FixedTimestep = 1.0f / 60.0f;
+
+private:
+	friend class Keyboard;
+	friend class Mouse;
+
+	enum class State
+	{
+		Idle,
+		Recording,
+		Playing
+	};
+
+	// Called by the devices for input of the window, false when they should drop it
+	bool OnInput(EventType type, int code = 0, int x = 0, int y = 0);
+	void Apply(const Event& event);
+	void Attach(Keyboard* pKeyboard, Mouse* pMouse);
+	// Releases every key and button and drops the input that wasn't read yet
+	static void ClearDevices(Keyboard& keyboard, Mouse& mouse);
+
+	State m_State = State::Idle;
+	Keyboard* m_pKeyboard = nullptr;
+	Mouse* m_pMouse = nullptr;
+
+	std::vector<Event> m_Events;
+	uint32_t m_FrameCount = 0u;
+	uint32_t m_BegunFrames = 0u;
+	size_t m_NextEvent = 0u;
+	std::chrono::steady_clock::time_point m_Start;
+};
\ No newline at end of file
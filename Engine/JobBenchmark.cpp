@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "JobBenchmark.h"
+#include "Benchmarking.h"
+#include "JobSystem.h"
+
+std::string JobBenchmark::Run(int jobCount, int repetitions)
+{
+	using namespace Benchmarking;
+
+	std::ostringstream report;
+	const int coreCount = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	report << "Job benchmark, " << jobCount << " jobs, " << coreCount << " cores, best of " << repetitions << " runs\n";
+
+	// Empty jobs, one child of a root each, in batches that stay below the jobs a thread may have unfinished
+	auto measureOverhead = [&](JobSystem& jobs)
+	{
+		return MeasureNanoseconds(repetitions, jobCount, [&]()
+		{
+			constexpr int BatchSize = static_cast<int>(JobSystem::JobsPerThread) / 2;
+			for (int first = 0; first < jobCount; first += BatchSize)
+			{
+				JobSystem::Job* pRoot = jobs.Create([]() { });
+				for (int i = first; i < std::min(first + BatchSize, jobCount); i++) jobs.Run(jobs.Create([]() { }, pRoot));
+				jobs.Run(pRoot);
+				jobs.Wait(pRoot);
+			}
+		});
+	};
+	{
+		JobSystem alone(0);
+		const double aloneNanoseconds = measureOverhead(alone);
+		ReportLine(report, "empty job, no workers", aloneNanoseconds, aloneNanoseconds);
+
+		JobSystem stealing(coreCount - 1);
+		ReportLine(report, "empty job, stealing", measureOverhead(stealing), aloneNanoseconds);
+	}
+
+	// A few hundred nanoseconds of arithmetic per element, so the split and steal overhead is small against it
+	std::vector<float> values(jobCount);
+	auto work = [&values](size_t first, size_t last)
+	{
+		for (size_t i = first; i < last; i++)
+		{
+			float value = static_cast<float>(i);
+			for (int j = 0; j < 32; j++) value = std::sqrt(value + static_cast<float>(j));
+			values[i] = value;
+		}
+	};
+
+	const double serial = MeasureNanoseconds(repetitions, jobCount, [&]()
+	{
+		work(0u, values.size());
+		s_Sink = values.back();
+	});
+	ReportLine(report, "loop", serial, serial);
+
+	for (int workerCount = 0; workerCount < coreCount; workerCount++)
+	{
+		JobSystem jobs(workerCount);
+		const double parallel = MeasureNanoseconds(repetitions, jobCount, [&]()
+		{
+			jobs.ParallelFor(0u, values.size(), 256u, work);
+			s_Sink = values.back();
+		});
+
+		const std::string name = "ParallelFor, " + std::to_string(workerCount + 1) + " threads";
+		ReportLine(report, name.c_str(), parallel, serial);
+	}
+
+	return report.str();
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+// Measures the job system: the cost of one empty job (created, queued, run and finished) when the calling thread
+// runs them alone and with workers stealing, then a ParallelFor over a compute bound loop with every worker count
+// up to the number of cores, against the plain loop.
+class JobBenchmark
+{
+public:
+	static std::string Run(int jobCount = 100000, int repetitions = 10);
+};
\ No newline at end of file
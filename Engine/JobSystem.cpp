@@ -0,0 +1,175 @@
+#include <algorithm>
+
+#include "JobSystem.h"
+
+namespace
+{
+	// Jobs of the threads that create them, handed out round robin skipping the unfinished ones
+	struct JobPool
+	{
+		std::unique_ptr<JobSystem::Job[]> m_pJobs;
+		size_t m_Next = 0u;
+	};
+
+	thread_local JobPool s_JobPool;
+
+	// Set on worker threads only
+	thread_local const JobSystem* s_pWorkerSystem = nullptr;
+	thread_local size_t s_WorkerQueue = 0u;
+}
+
+JobSystem::JobSystem(int workerCount)
+	:
+	m_Queues(std::make_unique<Queue[]>(std::max(workerCount, 0) + 1u)),
+	m_QueueCount(std::max(workerCount, 0) + 1u)
+{
+	for (size_t i = 1u; i < m_QueueCount; i++)
+	{
+		m_Workers.emplace_back(&JobSystem::Work, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+		m_Stopping = true;
+	}
+	m_JobAvailable.notify_all();
+
+	for (std::thread& worker : m_Workers) worker.join();
+}
+
+void JobSystem::Run(Job* pJob)
+{
+	Queue& queue = m_Queues[s_pWorkerSystem == this ? s_WorkerQueue : 0u];
+	{
+		std::lock_guard<std::mutex> lock(queue.m_Mutex);
+		if (queue.m_Count < JobsPerThread)
+		{
+			queue.m_Jobs[(queue.m_Front + queue.m_Count) % JobsPerThread] = pJob;
+			queue.m_Count++;
+			pJob = nullptr;
+		}
+	}
+
+	if (pJob != nullptr)
+	{
+		Execute(pJob);
+		return;
+	}
+
+	m_QueuedJobs.fetch_add(1, std::memory_order_release);
+	{
+		// Orders the notification after a worker that is about to sleep checked the count
+		std::lock_guard<std::mutex> lock(m_SleepMutex);
+	}
+	m_JobAvailable.notify_one();
+}
+
+void JobSystem::Wait(const Job* pJob)
+{
+	while (pJob->m_UnfinishedJobs.load(std::memory_order_acquire) > 0)
+	{
+		if (Job* pNext = TryGetJob())
+		{
+			Execute(pNext);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+JobSystem::Job* JobSystem::AllocateJob()
+{
+	JobPool& pool = s_JobPool;
+	if (pool.m_pJobs == nullptr) pool.m_pJobs = std::make_unique<Job[]>(JobsPerThread);
+
+	while (true)
+	{
+		for (size_t i = 0u; i < JobsPerThread; i++)
+		{
+			Job& job = pool.m_pJobs[pool.m_Next];
+			pool.m_Next = (pool.m_Next + 1u) % JobsPerThread;
+
+			if (job.m_UnfinishedJobs.load(std::memory_order_acquire) == 0)
+			{
+				job.m_UnfinishedJobs.store(1, std::memory_order_relaxed);
+				return &job;
+			}
+		}
+
+		// Every job of this thread is still running, help until one finishes
+		if (Job* pNext = TryGetJob()) Execute(pNext);
+		else std::this_thread::yield();
+	}
+}
+
+JobSystem::Job* JobSystem::TryGetJob()
+{
+	const size_t ownQueue = s_pWorkerSystem == this ? s_WorkerQueue : 0u;
+
+	// Newest of the own queue, then the oldest of the others
+	for (size_t i = 0u; i < m_QueueCount; i++)
+	{
+		const size_t index = (ownQueue + i) % m_QueueCount;
+		Queue& queue = m_Queues[index];
+
+		std::lock_guard<std::mutex> lock(queue.m_Mutex);
+		if (queue.m_Count == 0u) continue;
+
+		Job* pJob;
+		if (index == ownQueue)
+		{
+			pJob = queue.m_Jobs[(queue.m_Front + queue.m_Count - 1u) % JobsPerThread];
+		}
+		else
+		{
+			pJob = queue.m_Jobs[queue.m_Front];
+			queue.m_Front = (queue.m_Front + 1u) % JobsPerThread;
+		}
+		queue.m_Count--;
+
+		m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+		return pJob;
+	}
+
+	return nullptr;
+}
+
+void JobSystem::Execute(Job* pJob)
+{
+	pJob->m_pFunction(*pJob);
+	Finish(pJob);
+}
+
+void JobSystem::Finish(Job* pJob)
+{
+	// The job may be reused by its thread as soon as the count reaches zero
+	Job* pParent = pJob->m_pParent;
+	if (pJob->m_UnfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) == 1 && pParent != nullptr)
+	{
+		Finish(pParent);
+	}
+}
+
+void JobSystem::Work(size_t queueIndex)
+{
+	s_pWorkerSystem = this;
+	s_WorkerQueue = queueIndex;
+
+	while (true)
+	{
+		if (Job* pJob = TryGetJob())
+		{
+			Execute(pJob);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_SleepMutex);
+		m_JobAvailable.wait(lock, [this]() { return m_Stopping || m_QueuedJobs.load(std::memory_order_acquire) > 0; });
+		if (m_Stopping) return;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+
+// Work stealing scheduler for short jobs that belong to a frame: entity updates, vertex batches, texture blocks.
+// Every worker has a queue of its own, it runs the newest job it queued first (its data is still in the cache)
+// and takes the oldest job of another queue when its own is empty. Threads that aren't workers (the main thread,
+// the loading threads) share one more queue. A thread waiting for a job runs queued jobs meanwhile, so waiting
+// from inside a job never deadlocks and the main thread works along with the workers.
+//
+// A job is finished once its function and all of its children have returned. Jobs are taken from a pool of
+// the thread that creates them and hold the function inline, creating and running one never allocates.
+class JobSystem
+{
+public:
+	class alignas(64) Job
+	{
+	private:
+		friend class JobSystem;
+
+		// Taken by the members in front of the function, rounded up to its alignment: 32 on 64 bit targets, 16 on 32 bit ones
+		static constexpr size_t HeaderBytes = (2u * sizeof(void*) + sizeof(std::atomic<int>) + 15u) & ~static_cast<size_t>(15u);
+
+		void (*m_pFunction)(Job&);
+		Job* m_pParent;
+		// This job and its children that haven't finished yet, zero for a free job
+		std::atomic<int> m_UnfinishedJobs{ 0 };
+		// The rest of the two cache lines
+		alignas(16) unsigned char m_Data[128u - HeaderBytes];
+	};
+
+	// Workers besides the threads calling Wait, zero runs everything on the waiting threads
+	explicit JobSystem(int workerCount = ThreadPool::DefaultThreadCount());
+	// Every job has to be finished
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// The function takes no arguments or the job itself (to create children of it), and is destroyed after it ran.
+	// The job has to be passed to Run. With a parent it is one of the parent's children, which then only finishes
+	// after this job did: create children before Run on the parent or from inside the parent's function.
+	template <class TFunction>
+	Job* Create(TFunction&& function, Job* pParent = nullptr);
+
+	void Run(Job* pJob);
+	// Returns once the job and its children are finished, running queued jobs meanwhile
+	void Wait(const Job* pJob);
+
+	// Calls function(first, last) for subranges of [begin, end) of at most grainSize elements, in parallel, and
+	// returns when all are done. Ranges are halved into jobs on the worker that takes them, so idle workers steal large pieces.
+	template <class TFunction>
+	void ParallelFor(size_t begin, size_t end, size_t grainSize, const TFunction& function);
+
+	int GetWorkerCount() const { return static_cast<int>(m_Workers.size()); }
+
+	// Jobs one thread can have unfinished at once, creating another one runs queued jobs until one of them finishes
+	static constexpr size_t JobsPerThread = 4096u;
+
+private:
+	// Fixed ring of jobs, a full queue runs the next job right away instead
+	struct alignas(64) Queue
+	{
+		std::mutex m_Mutex;
+		Job* m_Jobs[JobsPerThread];
+		size_t m_Front = 0u;
+		size_t m_Count = 0u;
+	};
+
+	static_assert(sizeof(Job) == 128u && offsetof(Job, m_Data) == Job::HeaderBytes, "Jobs are two cache lines");
+
+	Job* AllocateJob();
+	// nullptr when every queue is empty
+	Job* TryGetJob();
+	void Execute(Job* pJob);
+	void Finish(Job* pJob);
+	void Work(size_t queueIndex);
+
+	template <class TFunction>
+	void SplitRange(Job* pParent, size_t begin, size_t end, size_t grainSize, const TFunction& function);
+
+	// Queue 0 is shared by the threads that aren't workers, worker i owns queue i + 1
+	std::unique_ptr<Queue[]> m_Queues;
+	size_t m_QueueCount;
+
+	std::atomic<int> m_QueuedJobs{ 0 };
+	std::mutex m_SleepMutex;
+	std::condition_variable m_JobAvailable;
+	bool m_Stopping = false;
+
+	std::vector<std::thread> m_Workers;
+};
+
+template <class TFunction>
+JobSystem::Job* JobSystem::Create(TFunction&& function, Job* pParent)
+{
+	typedef std::decay_t<TFunction> Function;
+	static_assert(sizeof(Function) <= sizeof(Job::m_Data) && alignof(Function) <= 16u, "Job functions are stored inline, capture less or by reference");
+
+	Job* pJob = AllocateJob();
+	new (pJob->m_Data) Function(std::forward<TFunction>(function));
+	pJob->m_pFunction = [](Job& job)
+	{
+		Function& function = *std::launder(reinterpret_cast<Function*>(job.m_Data));
+		if constexpr (std::is_invocable_v<Function&, Job*>) function(&job);
+		else function();
+		function.~Function();
+	};
+	pJob->m_pParent = pParent;
+
+	if (pParent != nullptr) pParent->m_UnfinishedJobs.fetch_add(1, std::memory_order_relaxed);
+
+	return pJob;
+}
+
+template <class TFunction>
+void JobSystem::ParallelFor(size_t begin, size_t end, size_t grainSize, const TFunction& function)
+{
+	if (begin >= end) return;
+
+	// Not worth a job
+	if (end - begin <= grainSize)
+	{
+		function(begin, end);
+		return;
+	}
+
+	Job* pRoot = Create([this, begin, end, grainSize, &function](Job* pJob) { SplitRange(pJob, begin, end, grainSize, function); });
+	Run(pRoot);
+	Wait(pRoot);
+}
+
+template <class TFunction>
+void JobSystem::SplitRange(Job* pParent, size_t begin, size_t end, size_t grainSize, const TFunction& function)
+{
+	// The upper halves go to the queue, this thread carries on with the lower half
+	while (end - begin > grainSize)
+	{
+		const size_t middle = begin + (end - begin) / 2u;
+		Run(Create([this, middle, end, grainSize, &function](Job* pJob) { SplitRange(pJob, middle, end, grainSize, function); }, pParent));
+		end = middle;
+	}
+
+	function(begin, end);
+}
\ No newline at end of file
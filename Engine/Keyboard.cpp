@@ -19,6 +19,7 @@
  *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
  ******************************************************************************************/
 #include "Keyboard.h"
+#include "InputRecording.h"
 
 bool Keyboard::KeyIsPressed( unsigned char keycode ) const
 {
@@ -96,6 +97,10 @@ bool Keyboard::AutorepeatIsEnabled() const
 
 void Keyboard::OnKeyPressed( unsigned char keycode )
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::KeyPressed,keycode ) )
+	{
+		return;
+	}
 	keystates[ keycode ] = true;	
 	keybuffer.push( Keyboard::Event( Keyboard::Event::Type::Press,keycode ) );
 	TrimBuffer( keybuffer );
@@ -103,6 +108,10 @@ void Keyboard::OnKeyPressed( unsigned char keycode )
 
 void Keyboard::OnKeyReleased( unsigned char keycode )
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::KeyReleased,keycode ) )
+	{
+		return;
+	}
 	keystates[ keycode ] = false;
 	keybuffer.push( Keyboard::Event( Keyboard::Event::Type::Release,keycode ) );
 	TrimBuffer( keybuffer );
@@ -110,12 +119,20 @@ void Keyboard::OnKeyReleased( unsigned char keycode )
 
 void Keyboard::OnChar( char character )
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::Char,static_cast<unsigned char>( character ) ) )
+	{
+		return;
+	}
 	charbuffer.push( character );
 	TrimBuffer( charbuffer );
 }
 
 void Keyboard::ClearState()
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::KeyboardCleared ) )
+	{
+		return;
+	}
 	keystates.reset();
 }
 
@@ -25,6 +25,7 @@
 class Keyboard
 {
 	friend class MainWindow;
+	friend class InputRecording;
 public:
 	class Event
 	{
@@ -95,4 +96,6 @@ private:
 	std::bitset<nKeys> keystates;
 	std::queue<Event> keybuffer;
 	std::queue<char> charbuffer;
+	// records the input, or drops it while a recording plays back
+	class InputRecording* pRecording = nullptr;
 };
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <cmath>
+#include <type_traits>
 
+#include "Simd.h"
 #include "Vec4.h"
 
+// Row major, every row is 16 byte aligned so it can be loaded into a SIMD register directly
 template <typename T>
-class _Mat4
+class alignas(4 * sizeof(T)) _Mat4
 {
 public:
 	T matrix[4][4] = {};
@@ -50,7 +53,7 @@ public:
 		{
 			for (auto j = 0; j < 4; j++)
 			{
-				result[i][j] = lhs * rhs;
+				result[i][j] = lhs * rhs[i][j];
 			}
 		}
 
@@ -64,19 +67,31 @@ public:
 
 	friend _Mat4 operator*(const _Mat4& lhs, const _Mat4& rhs)
 	{
-		_Mat4 result;
-		for (auto i = 0; i < 4; i++)
+#if ENGINE_SIMD_SSE
+		if constexpr (std::is_same<T, float>::value)
 		{
-			for (auto j = 0; j < 4; j++)
+			// Every result row is a linear combination of the rows of rhs
+			const __m128 rhsRows[4] = { _mm_load_ps(rhs[0]), _mm_load_ps(rhs[1]), _mm_load_ps(rhs[2]), _mm_load_ps(rhs[3]) };
+
+			_Mat4 result;
+			for (auto i = 0; i < 4; i++)
 			{
-				result[i][j] = lhs[i][0] * rhs[0][j] + lhs[i][1] * rhs[1][j] + lhs[i][2] * rhs[2][j] + lhs[i][3] * rhs[3][j];
+				__m128 row = _mm_mul_ps(_mm_set1_ps(lhs[i][0]), rhsRows[0]);
+				row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs[i][1]), rhsRows[1]));
+				row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs[i][2]), rhsRows[2]));
+				row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs[i][3]), rhsRows[3]));
+				_mm_store_ps(result[i], row);
 			}
-		}
 
-		return result;
+			return result;
+		}
+#endif
+		return MultiplyScalar(lhs, rhs);
 	}
 	_Mat4& operator*=(const _Mat4& rhs) { return *this = *this * rhs; }
 
+	// Kept scalar, one vector at a time has nothing to gain from SIMD once the matrix has to be transposed.
+	// Whole vertex streams go through TransformKernels instead.
 	friend _Vec4<T> operator*(const _Mat4& lhs, const _Vec4<T>& rhs)
 	{
 		return
@@ -88,6 +103,21 @@ public:
 		};
 	}
 
+	// Plain C++ version of the product, the operator above is checked and benchmarked against it
+	static _Mat4 MultiplyScalar(const _Mat4& lhs, const _Mat4& rhs)
+	{
+		_Mat4 result;
+		for (auto i = 0; i < 4; i++)
+		{
+			for (auto j = 0; j < 4; j++)
+			{
+				result[i][j] = lhs[i][0] * rhs[0][j] + lhs[i][1] * rhs[1][j] + lhs[i][2] * rhs[2][j] + lhs[i][3] * rhs[3][j];
+			}
+		}
+
+		return result;
+	}
+
 	static constexpr _Mat4 Identity()
 	{
 		return
@@ -155,11 +185,11 @@ public:
 	{
 		return
 		{
-			x,      (T)0.0, (T)0.0, (T)0.0
-			(T)0.0, y,      (T)0.0, (T)0.0
-			(T)0.0, (T)0.0,  z,     (T)0.0
+			x,      (T)0.0, (T)0.0, (T)0.0,
+			(T)0.0, y,      (T)0.0, (T)0.0,
+			(T)0.0, (T)0.0,  z,     (T)0.0,
 			(T)0.0, (T)0.0, (T)0.0, (T)1.0
-		}
+		};
 	}
 	static _Mat4 Scale(const _Vec3<T>& s) { return Scale(s.x, s.y, s.z); }
 
@@ -180,6 +210,16 @@ public:
 			(T)0.0,              (T)0.0,              (T)0.0,                      (T)1.0
 		};
 	}
+	static _Mat4 OrthographicProjection(T left, T right, T bottom, T top, T nearPlane, T farPlane)
+	{
+		return
+		{
+			(T)2.0/(right-left), (T)0.0,              (T)0.0,                       -(right+left)/(right-left),
+			(T)0.0,              (T)2.0/(top-bottom), (T)0.0,                       -(top+bottom)/(top-bottom),
+			(T)0.0,              (T)0.0,              -(T)2.0/(farPlane-nearPlane), -(farPlane+nearPlane)/(farPlane-nearPlane),
+			(T)0.0,              (T)0.0,              (T)0.0,                       (T)1.0
+		};
+	}
 	template <typename TAngle> static _Mat4 PerspectiveProjection(T nearPlane, T farPlane, TAngle fov, T aspectRatio)
 	{
 		auto top    = std::tan(fov / (T)2.0) * nearPlane;
@@ -195,6 +235,21 @@ public:
 			(T)0.0,                        (T)0.0,                         -(T)1.0,                                    (T)0.0
 		};
 	}
+
+	static _Mat4 LookAt(const _Vec3<T>& eye, const _Vec3<T>& target, const _Vec3<T>& up)
+	{
+		const auto forward = _Vec3<T>::Normalize(target - eye);
+		const auto right   = _Vec3<T>::Normalize(_Vec3<T>::Cross(forward, up));
+		const auto newUp   = _Vec3<T>::Cross(right, forward);
+
+		return
+		{
+			right.x,    right.y,    right.z,    -_Vec3<T>::Dot(right, eye),
+			newUp.x,    newUp.y,    newUp.z,    -_Vec3<T>::Dot(newUp, eye),
+			-forward.x, -forward.y, -forward.z, _Vec3<T>::Dot(forward, eye),
+			(T)0.0,     (T)0.0,     (T)0.0,     (T)1.0
+		};
+	}
 };
 
 using Mat4 = _Mat4<float>;
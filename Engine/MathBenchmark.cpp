@@ -0,0 +1,121 @@
+#include <sstream>
+#include <vector>
+
+#include "MathBenchmark.h"
+#include "Benchmarking.h"
+#include "TransformKernels.h"
+
+namespace
+{
+	// Runs the function with every instruction set the CPU supports selected, then restores the previous one
+	template <typename TFunction>
+	void ForEachInstructionSet(TFunction function)
+	{
+		const auto previous = TransformKernels::GetInstructionSet();
+		for (int i = 0; i <= static_cast<int>(TransformKernels::GetSupportedInstructionSet()); i++)
+		{
+			function(TransformKernels::SetInstructionSet(static_cast<TransformKernels::InstructionSet>(i)));
+		}
+		TransformKernels::SetInstructionSet(previous);
+	}
+}
+
+std::string MathBenchmark::Run(int vertexCount, int repetitions)
+{
+	using namespace Benchmarking;
+
+	std::ostringstream report;
+	report << "Math benchmark, " << vertexCount << " elements, best of " << repetitions << " runs\n";
+
+	std::vector<Mat4> matrices;
+	std::vector<Vec4> vectors;
+	Vec3Stream positions;
+	Vec3Stream normals;
+	positions.Resize(vertexCount);
+	normals.Resize(vertexCount);
+	for (int i = 0; i < vertexCount; i++)
+	{
+		const float t = static_cast<float>(i) / vertexCount;
+		matrices.push_back(Mat4::RotateY(t) * Mat4::Translate(t, -t, 2.0f * t));
+		vectors.push_back(Vec4(t, 1.0f - t, 0.5f * t, 1.0f));
+		positions.Set(i, Vec3(t, 1.0f - t, 0.5f * t));
+		normals.Set(i, Vec3::Normalize(Vec3(1.0f - t, t, 0.5f)));
+	}
+
+	const Mat4 mv = Mat4::Translate(0.0f, 0.0f, -5.0f) * Mat4::RotateX(0.95f);
+	const Mat4 mvp = Mat4::PerspectiveProjection(0.1f, 100.0f, 1.57f, 4.0f / 3.0f) * mv;
+
+	// Mat4 * Mat4, chained so every product depends on the previous one
+	{
+		const double scalar = MeasureNanoseconds(repetitions, vertexCount, [&]()
+		{
+			Mat4 product = Mat4::Identity();
+			for (const auto& matrix : matrices) product = Mat4::MultiplyScalar(matrix, product);
+			s_Sink = product[0][0];
+		});
+		const double simd = MeasureNanoseconds(repetitions, vertexCount, [&]()
+		{
+			Mat4 product = Mat4::Identity();
+			for (const auto& matrix : matrices) product = matrix * product;
+			s_Sink = product[0][0];
+		});
+
+		ReportLine(report, "Mat4 * Mat4 scalar", scalar, scalar);
+		ReportLine(report, "Mat4 * Mat4 SSE", simd, scalar);
+	}
+
+	// Mat4 * Vec4, one at a time and as a batched point stream
+	{
+		std::vector<Vec4> results(vertexCount);
+		const double perVector = MeasureNanoseconds(repetitions, vertexCount, [&]()
+		{
+			for (int i = 0; i < vertexCount; i++) results[i] = mvp * vectors[i];
+			s_Sink = results[vertexCount - 1].x;
+		});
+		ReportLine(report, "Mat4 * Vec4 one by one", perVector, perVector);
+
+		ForEachInstructionSet([&](TransformKernels::InstructionSet instructionSet)
+		{
+			const double batched = MeasureNanoseconds(repetitions, vertexCount, [&]()
+			{
+				TransformKernels::TransformPoints(mvp, positions, results.data());
+				s_Sink = results[vertexCount - 1].x;
+			});
+			ReportLine(report, (std::string("Mat4 * Vec4 batched ") + TransformKernels::GetName(instructionSet)).c_str(), batched, perVector);
+		});
+	}
+
+	// Position by MVP and MV plus normal by MV, what the lit vertex shader does for every vertex
+	{
+		std::vector<Vec4> clipPositions(vertexCount);
+		std::vector<Vec4> viewPositions(vertexCount);
+		Vec3Stream viewNormals;
+
+		const double perVertex = MeasureNanoseconds(repetitions, vertexCount, [&]()
+		{
+			viewNormals.Resize(vertexCount);
+			for (int i = 0; i < vertexCount; i++)
+			{
+				const Vec4 position = positions.Get(i);
+				const Vec3 normal = normals.Get(i);
+				clipPositions[i] = mvp * position;
+				viewPositions[i] = mv * position;
+				viewNormals.Set(i, Vec3::Normalize(mv * Vec4(normal.x, normal.y, normal.z, 0.0f)));
+			}
+			s_Sink = clipPositions[vertexCount - 1].x;
+		});
+		ReportLine(report, "Vertex transform one by one", perVertex, perVertex);
+
+		ForEachInstructionSet([&](TransformKernels::InstructionSet instructionSet)
+		{
+			const double batched = MeasureNanoseconds(repetitions, vertexCount, [&]()
+			{
+				TransformKernels::TransformVertices(mvp, mv, positions, normals, clipPositions.data(), viewPositions.data(), viewNormals);
+				s_Sink = clipPositions[vertexCount - 1].x;
+			});
+			ReportLine(report, (std::string("Vertex transform batched ") + TransformKernels::GetName(instructionSet)).c_str(), batched, perVertex);
+		});
+	}
+
+	return report.str();
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+// Microbenchmarks for the SIMD math layer.
+// Times the SIMD Mat4 * Mat4 against the scalar one, and the batched point and vertex transforms
+// with every instruction set the CPU supports against transforming one vector at a time.
+class MathBenchmark
+{
+public:
+	// Returns a human readable report with the nanoseconds per operation of every case
+	static std::string Run(int vertexCount = 100000, int repetitions = 20);
+};
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "Mesh.h"
+#include "AllocationTracker.h"
+#include "OBJ_Loader.h"
+
+Mesh::Mesh(const std::vector<Vec3>& vertices, const std::vector<Vec3>& normals, const std::vector<size_t>& indices)
+{
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Meshes);
+	m_Indices = indices;
+	m_Vertices = vertices;
+	m_Normals = normals;
+}
+
+Mesh::Mesh(std::vector<Vec3> vertices, std::vector<Vec3> normals, std::vector<Vec2> uvCoordinates, std::vector<size_t> indices)
+	:
+	m_Indices(std::move(indices)),
+	m_Vertices(std::move(vertices)),
+	m_Normals(std::move(normals)),
+	m_UvCoordinates(std::move(uvCoordinates))
+{
+}
+
+bool Mesh::Load(const std::string& path)
+{
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Meshes);
+
+	m_Indices.clear();
+	m_Vertices.clear();
+	m_UvCoordinates.clear();
+	m_Normals.clear();
+
+	objl::Loader loader;
+	if (!loader.LoadFile(path)) return false;
+
+	m_Indices.assign(loader.LoadedIndices.begin(), loader.LoadedIndices.end());
+
+	m_Vertices.reserve(loader.LoadedVertices.size());
+	m_UvCoordinates.reserve(loader.LoadedVertices.size());
+	m_Normals.reserve(loader.LoadedVertices.size());
+	for (const auto& vertex : loader.LoadedVertices)
+	{
+		m_Vertices.push_back(Vec3(vertex.Position.X, vertex.Position.Y, vertex.Position.Z));
+		m_UvCoordinates.push_back(Vec2(vertex.TextureCoordinate.X, vertex.TextureCoordinate.Y));
+		m_Normals.push_back(Vec3(vertex.Normal.X, vertex.Normal.Y, vertex.Normal.Z));
+	}
+
+	return true;
+}
+
+size_t Mesh::GetMemoryBytes() const
+{
+	return
+		m_Indices.capacity() * sizeof(size_t) +
+		m_Vertices.capacity() * sizeof(Vec3) +
+		m_Normals.capacity() * sizeof(Vec3) +
+		m_UvCoordinates.capacity() * sizeof(Vec2);
+}
\ No newline at end of file
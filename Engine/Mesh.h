@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Vec2.h"
+#include "Vec3.h"
+
+// Indexed triangle list with one normal and texture coordinate per vertex.
+// Never changes once loaded, so entities can share one instance through a shared_ptr<const Mesh>.
+class Mesh
+{
+public:
+	Mesh() = default;
+	Mesh(const std::vector<Vec3>& vertices, const std::vector<Vec3>& normals, const std::vector<size_t>& indices);
+	Mesh(std::vector<Vec3> vertices, std::vector<Vec3> normals, std::vector<Vec2> uvCoordinates, std::vector<size_t> indices);
+
+	// Returns false and leaves the mesh empty when the file can't be read
+	bool Load(const std::string& path);
+
+	const std::vector<size_t>& GetIndices() const { return m_Indices; }
+	const std::vector<Vec3>& GetVertices() const { return m_Vertices; }
+	const std::vector<Vec3>& GetNormals() const { return m_Normals; }
+	const std::vector<Vec2>& GetUvCoordinates() const { return m_UvCoordinates; }
+
+	// Bytes of vertex and index storage
+	size_t GetMemoryBytes() const;
+
+private:
+	std::vector<size_t> m_Indices;
+	std::vector<Vec3> m_Vertices;
+	std::vector<Vec3> m_Normals;
+	std::vector<Vec2> m_UvCoordinates;
+};
\ No newline at end of file
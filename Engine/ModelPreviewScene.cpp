@@ -1,28 +1,104 @@
 #include "ModelPreviewScene.h"
+#include "FrameArena.h"
+#include "MathBenchmark.h"
+#include "TextureBenchmark.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
 
 #include <sstream>
 
-ModelPreviewScene::ModelPreviewScene(Graphics& graphics, MainWindow& window)
+ModelPreviewScene::ModelPreviewScene(Graphics& graphics, MainWindow& window, JobSystem& jobs)
 	:
+	Scene(jobs),
 	m_Pipeline(graphics),
+	m_UnshadowedPipeline(graphics),
+	m_Graphics(graphics),
 	m_Window(window),
-	m_Model("models/box.obj")
+	m_ModelRequest(m_Assets.LoadMeshAsync(ModelPath)),
+	m_Model(std::shared_ptr<const Mesh>()),
+	m_SunShadowMap(graphics, 1024, 3)
 {
-	graphics.SetBackgroundColor(200u);
+	graphics.SetBackgroundColor(BackgroundColor);
 
-	auto vertices = m_Model.GetVertices();
-	auto uvCoordinates = m_Model.GetUvCoordinates();
-	auto normals = m_Model.GetNormals();
+	m_Assets.SetTextureCacheDirectory(TextureCacheDirectory);
+	m_Assets.SetJobSystem(&m_Jobs);
+	m_Pipeline.SetJobSystem(&m_Jobs);
+	m_UnshadowedPipeline.SetJobSystem(&m_Jobs);
+	m_SunShadowMap.SetJobSystem(&m_Jobs);
 
-	for (int i = 0; i < vertices.size(); i++)
+	// Parsing and decoding run on the loading threads, frames are drawn with a placeholder texture
+	// and without the model until they are done
+	m_Pipeline.BindTexture(m_Assets.GetPlaceholderTexture());
+	m_UnshadowedPipeline.BindTexture(m_Assets.GetPlaceholderTexture());
+	LoadTextures(Texture::Format::RGB8);
+}
+
+void ModelPreviewScene::LoadTextures(Texture::Format format)
+{
+	// The texture that is bound stays until the new one is ready
+	m_RequestedTextureFormat = format;
+	m_TextureRequest = m_Assets.LoadTextureAsync(TexturePath, format);
+}
+
+void ModelPreviewScene::PollAssets()
+{
+	if (!m_ModelRequest.IsReady() && !m_TextureRequest.IsReady()) return;
+
+	// A failed load leaves the mesh, the triangles and the texture that were there before
+	if (m_ModelRequest.IsReady())
+	{
+		const auto pMesh = m_ModelRequest.Get();
+		m_ModelRequest = AssetFuture<Mesh>();
+
+		if (pMesh == nullptr)
+		{
+			OutputDebugStringA((std::string("ERROR: can't load the model ") + ModelPath + "\n").c_str());
+		}
+		else
+		{
+			m_Model.SetMesh(pMesh);
+
+			const auto& vertices = m_Model.GetVertices();
+			const auto& uvCoordinates = m_Model.GetUvCoordinates();
+			const auto& normals = m_Model.GetNormals();
+
+			AllocationTracker::TagScope tag(AllocationTracker::Tag::Meshes);
+			m_TriangleInput.clear();
+			for (size_t i = 0; i < vertices.size(); i++)
+			{
+				m_TriangleInput.push_back({ vertices[i], normals[i], uvCoordinates[i] });
+			}
+		}
+	}
+
+	if (m_TextureRequest.IsReady())
 	{
-		m_TriangleInput.push_back({ vertices[i], normals[i], uvCoordinates[i]});
+		const auto pTexture = m_TextureRequest.Get();
+		m_TextureRequest = AssetFuture<Texture>();
+
+		if (pTexture == nullptr)
+		{
+			OutputDebugStringA((std::string("ERROR: can't load the texture ") + TexturePath + "\n").c_str());
+		}
+		else
+		{
+			// Both pipelines draw from the same texture, the one of the previous format stays cached until the budget needs its memory
+			m_Pipeline.BindTexture(pTexture);
+			m_UnshadowedPipeline.BindTexture(pTexture);
+			m_TextureFormat = m_RequestedTextureFormat;
+		}
 	}
 
-	m_Pipeline.LoadTexture("models/boxTexture.png");
+	// Only the loads started with the scene, reloads later on would be measured from its creation as well
+	if (!m_StartupLoadsReported && !m_ModelRequest.IsValid() && !m_TextureRequest.IsValid())
+	{
+		m_StartupLoadsReported = true;
+		const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_CreationTime;
+		std::ostringstream report;
+		report << "Asset loads finished " << elapsed.count() << " ms after the scene was created\n";
+		OutputDebugStringA(report.str().c_str());
+	}
 }
 
 void ModelPreviewScene::Start()
@@ -30,10 +106,13 @@ void ModelPreviewScene::Start()
 	m_Model.SetPosition({ 0.0f, 0.0f, 1.65f });
 	m_Model.SetRotation({ 0.95f, 0.0f, 0.0f });
 	m_CameraPosition = { 0.0f, 0.0f, 5.0f };
+	m_SunDirection = Vec3::Normalize({ 0.4f, -0.8f, -0.6f });
 }
 
 void ModelPreviewScene::Update()
 {
+	PollAssets();
+
 	if (m_Window.kbd.KeyIsPressed('W')) m_Model.Translate(Vec3(0.0f, 0.0f, -0.05f));
 	if (m_Window.kbd.KeyIsPressed('S')) m_Model.Translate(Vec3(0.0f, 0.0f, 0.05f));
 	if (m_Window.kbd.KeyIsPressed('A')) m_Model.Translate(Vec3(-0.05f, 0.0f, 0.0f));
@@ -46,21 +125,302 @@ void ModelPreviewScene::Update()
 	if (m_Window.kbd.KeyIsPressed(VK_UP)) m_Model.Rotate(Vec3(-0.05f, 0.0f, 0.0f));
 	if (m_Window.kbd.KeyIsPressed(VK_DOWN)) m_Model.Rotate(Vec3(0.05f, 0.0f, 0.0f));
 
-	m_Model.UpdateModelTransform();
+	if (m_Window.kbd.KeyIsPressed('1')) SetAntiAliasing(false);
+	if (m_Window.kbd.KeyIsPressed('2')) SetAntiAliasing(true, MultisampleTarget::Mode::MSAA2x);
+	if (m_Window.kbd.KeyIsPressed('3')) SetAntiAliasing(true, MultisampleTarget::Mode::MSAA4x);
+	if (m_Window.kbd.KeyIsPressed('4')) SetAntiAliasing(true, MultisampleTarget::Mode::SSAA4x);
+
+	while (!m_Window.kbd.KeyIsEmpty())
+	{
+		const auto event = m_Window.kbd.ReadKey();
+		if (event.IsPress() && event.GetCode() == 'B' && m_DebugKeysEnabled)
+		{
+			OutputDebugStringA(MathBenchmark::Run().c_str());
+			OutputDebugStringA(TextureBenchmark::Run(TexturePath).c_str());
+			OutputDebugStringA(m_Assets.GetReport().c_str());
+		}
+		if (event.IsPress() && event.GetCode() == 'C' && m_DebugKeysEnabled)
+		{
+			ToggleCapture();
+		}
+		if (event.IsPress() && event.GetCode() == 'I' && m_DebugKeysEnabled)
+		{
+			ToggleProfiling();
+		}
+		if (event.IsPress() && event.GetCode() == 'O')
+		{
+			CycleHeatmapView();
+		}
+		if (event.IsPress() && event.GetCode() == 'M' && m_DebugKeysEnabled)
+		{
+			m_WriteHeatmap = m_pHeatmap != nullptr;
+		}
+		if (event.IsPress() && event.GetCode() == 'H')
+		{
+			m_ShadowsEnabled = !m_ShadowsEnabled;
+		}
+		if (event.IsPress() && event.GetCode() == 'T')
+		{
+			// RGB8, then tiled, then BC1
+			LoadTextures(m_RequestedTextureFormat == Texture::Format::RGB8 ? Texture::Format::RGBX8Tiled :
+				m_RequestedTextureFormat == Texture::Format::RGBX8Tiled ? Texture::Format::BC1 : Texture::Format::RGB8);
+		}
+		if (event.IsPress() && event.GetCode() == 'P')
+		{
+			const auto traversal = m_Pipeline.GetPixelTraversal() == PixelTraversal::Rows ? PixelTraversal::Blocks : PixelTraversal::Rows;
+			m_Pipeline.SetPixelTraversal(traversal);
+			m_UnshadowedPipeline.SetPixelTraversal(traversal);
+		}
+		if (event.IsPress() && event.GetCode() == 'R')
+		{
+			const auto mode = m_Pipeline.GetRasterizationMode() == RasterizationMode::Scanline ? RasterizationMode::Homogeneous : RasterizationMode::Scanline;
+			m_Pipeline.SetRasterizationMode(mode);
+			m_UnshadowedPipeline.SetRasterizationMode(mode);
+		}
+	}
+
+	UpdateModelTransforms(&m_Model, 1u);
 }
 
 void ModelPreviewScene::Draw()
 {
-	m_Pipeline.ClearZBuffer();
+	// Update and Draw of the previous frame, transient pipeline data comes from the frame arena and shouldn't show up here
+	const AllocationTracker::Counts allocations = AllocationTracker::GetThreadCounts();
+	const uint64_t frameAllocations = allocations.m_Allocations - m_FrameStartAllocations.m_Allocations;
+	const uint64_t frameAllocatedBytes = allocations.m_Bytes - m_FrameStartAllocations.m_Bytes;
+
+	if (m_FrameCount == 0)
+	{
+		const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_CreationTime;
+		std::ostringstream report;
+		report << "First frame " << elapsed.count() << " ms after the scene was created\n";
+		OutputDebugStringA(report.str().c_str());
+	}
+
+	// Report the previous frame, its lookups were made during the main pass
+	if (++m_FrameCount % 60 == 0)
+	{
+		OutputDebugStringA(m_SunShadowMap.GetCostReport("sun").c_str());
+
+		const auto frameStats = m_Graphics.GetFrameStats();
+		std::ostringstream report;
+		report
+			<< "Present: " << frameStats.framesInFlight << " frames in flight, "
+			<< "latency " << frameStats.lastLatencyMs << " ms (avg " << frameStats.averageLatencyMs << ", max " << frameStats.maxLatencyMs << "), "
+			<< "render thread stall " << frameStats.lastStallMs << " ms\n"
+			<< "Heap: " << frameAllocations << " allocations (" << frameAllocatedBytes << " bytes) last frame, "
+			<< "frame arena holds " << FrameArena::ForThisThread().GetCapacityBytes() << " bytes\n";
+		OutputDebugStringA(report.str().c_str());
+		OutputDebugStringA(AllocationTracker::GetTagReport(m_FrameStartTags).c_str());
+
+		if (m_pProfiler)
+		{
+			OutputDebugStringA(m_pProfiler->GetReport().c_str());
+			m_pProfiler->Reset();
+		}
+	}
+	m_FrameStartAllocations = AllocationTracker::GetThreadCounts();
+	m_FrameStartTags = AllocationTracker::GetTagSnapshot();
+
+	if (m_pMultisampleTarget)
+	{
+		m_pMultisampleTarget->Clear(Color(BackgroundColor, BackgroundColor, BackgroundColor));
+	}
+
+	if (m_TriangleInput.empty())
+	{
+		if (m_pMultisampleTarget) m_pMultisampleTarget->Resolve(m_Graphics);
+		return;
+	}
+
 	Mat4 model = m_Model.GetModelTransform();
-	Mat4 view = Mat4::Translate(-Vec3(0.0f, 0.0f, 5.0f));
+	Mat4 view = Mat4::Translate(-m_CameraPosition);
 	Mat4 projection = Mat4::PerspectiveProjection(0.1f, 100.0f, 90.0f * (static_cast<float>(M_PI) / 180.0f), Graphics::AspectRatio);
 
-	m_Pipeline.BindIndices(m_Model.GetIndices());
-	m_Pipeline.BindVertices(m_TriangleInput);
+	const Vec4 sunDirectionViewSpace = view * Vec4(-m_SunDirection.x, -m_SunDirection.y, -m_SunDirection.z, 0.0f);
+	const Mat4 viewToLightClip = m_SunShadowMap.GetViewProjection() * Mat4::Translate(m_CameraPosition);
+
+	auto drawModel = [&](auto& pipeline, auto& commands)
+	{
+		commands.Clear();
+		commands.BindIndices(m_Model.GetIndices());
+		commands.BindVertices(m_TriangleInput);
+		commands.SetConstants({ projection * view * model, view * model, projection });
+		commands.Draw();
+
+		pipeline.ClearZBuffer();
+		pipeline.Execute(commands);
+	};
+
+	// Same state and commands as the pipeline would draw with
+	auto drawModelThroughHeatmap = [&](auto& pipeline, auto& heatmapPipeline, auto& commands)
+	{
+		heatmapPipeline.GetPixelShader() = pipeline.GetPixelShader();
+		heatmapPipeline.BindTexture(pipeline.GetTexture());
+		heatmapPipeline.BindMultisampleTarget(m_pMultisampleTarget.get());
+		heatmapPipeline.SetRasterizationMode(pipeline.GetRasterizationMode());
+		heatmapPipeline.SetPixelTraversal(pipeline.GetPixelTraversal());
+		drawModel(heatmapPipeline, commands);
+	};
+	if (m_pHeatmap) m_pHeatmap->Clear();
+
+	if (m_ShadowsEnabled)
+	{
+		m_SunShadowMap.SetDirectionalLight(m_SunDirection, m_Model.GetPosition(), 3.0f, 20.0f);
+		m_SunShadowMap.BeginPass();
+		m_SunShadowMap.Draw(m_Model);
+		m_SunShadowMap.EndPass();
+
+		// Shadow lookups start from view space positions, so undo the view transform before going to light space
+		auto& pixelShader = m_Pipeline.GetPixelShader();
+		pixelShader.ClearLights();
+		pixelShader.AddLight(TexturedDirectionalLightningShaderProgram::Light::Directional
+		(
+			sunDirectionViewSpace,
+			&m_SunShadowMap,
+			viewToLightClip
+		));
+
+		if (m_pHeatmap) drawModelThroughHeatmap(m_Pipeline, *m_pHeatmapPipeline, m_Commands);
+		else drawModel(m_Pipeline, m_Commands);
+	}
+	else
+	{
+		auto& pixelShader = m_UnshadowedPipeline.GetPixelShader();
+		pixelShader.ClearLights();
+		pixelShader.AddLight(UnshadowedTexturedDirectionalLightningShaderProgram::Light::Directional(sunDirectionViewSpace));
+
+		if (m_pHeatmap) drawModelThroughHeatmap(m_UnshadowedPipeline, *m_pUnshadowedHeatmapPipeline, m_UnshadowedCommands);
+		else drawModel(m_UnshadowedPipeline, m_UnshadowedCommands);
+	}
+
+	if (m_pMultisampleTarget)
+	{
+		m_pMultisampleTarget->Resolve(m_Graphics);
+	}
+
+	if (m_pHeatmap)
+	{
+		if (m_WriteHeatmap)
+		{
+			const char* viewNames[] = { "overdraw", "pixelcost", "tilecost" };
+			const std::string path = std::string(HeatmapDirectory) + "/heatmap" + std::to_string(m_FrameCount);
+
+			// The frame first, resolving draws over it
+			std::ostringstream report;
+			if (Heatmap::WriteScreen(m_Graphics, path + "_frame.bmp") && m_pHeatmap->WriteImage(path + "_" + viewNames[static_cast<int>(m_HeatmapView)] + ".bmp", m_HeatmapView))
+			{
+				report << "Wrote " << path << "_*.bmp\n";
+			}
+			else
+			{
+				report << "Can't write the heatmap to " << path << "_*.bmp\n";
+			}
+			report << m_pHeatmap->GetReport();
+			OutputDebugStringA(report.str().c_str());
+			m_WriteHeatmap = false;
+		}
+
+		m_pHeatmap->Resolve(m_Graphics, m_HeatmapView);
+	}
+
+	if (m_pCapture && !m_ModelRequest.IsValid() && !m_TextureRequest.IsValid())
+	{
+		const uint32_t mesh = m_pCapture->AddMesh(ModelPath);
+
+		// The shadow map was set up above, its state is only read back
+		DrawCapture::Frame frame;
+		frame.m_RasterizationMode = m_Pipeline.GetRasterizationMode();
+		frame.m_PixelTraversal = m_Pipeline.GetPixelTraversal();
+		frame.m_AntiAliasing = m_pMultisampleTarget ? static_cast<int32_t>(m_pMultisampleTarget->GetMode()) : DrawCapture::NoAntiAliasing;
+		frame.m_BackgroundColor = BackgroundColor;
+		frame.m_SunDirection = sunDirectionViewSpace;
+		frame.m_Shadowed = m_ShadowsEnabled;
+		if (m_ShadowsEnabled)
+		{
+			frame.m_ShadowResolution = m_SunShadowMap.GetResolution();
+			frame.m_ShadowFilterSize = m_SunShadowMap.GetFilterSize();
+			frame.m_ShadowDepthBias = m_SunShadowMap.GetDepthBias();
+			frame.m_ShadowViewProjection = m_SunShadowMap.GetViewProjection();
+			frame.m_ViewToLightClip = viewToLightClip;
+			frame.m_ShadowDraws.push_back({ mesh, model });
+		}
+		frame.m_Draws.push_back({ mesh, m_pCapture->AddTexture(TexturePath, m_TextureFormat), projection * view * model, view * model, projection });
+
+		m_pCapture->AddFrame(std::move(frame));
+	}
+}
+
+void ModelPreviewScene::ToggleCapture()
+{
+	if (!m_pCapture)
+	{
+		m_pCapture = std::make_unique<DrawCapture>();
+		return;
+	}
+
+	std::ostringstream report;
+	if (m_pCapture->Write(CapturePath))
+	{
+		report << "Captured " << m_pCapture->GetFrames().size() << " frames to " << CapturePath << "\n";
+	}
+	else
+	{
+		report << "Can't write the capture to " << CapturePath << "\n";
+	}
+	OutputDebugStringA(report.str().c_str());
+
+	m_pCapture.reset();
+}
+
+void ModelPreviewScene::ToggleProfiling()
+{
+	if (m_pProfiler) m_pProfiler.reset();
+	else m_pProfiler = std::make_unique<PipelineProfiler>();
+
+	m_Pipeline.SetProfiler(m_pProfiler.get());
+	m_UnshadowedPipeline.SetProfiler(m_pProfiler.get());
+
+	if (m_pProfiler) OutputDebugStringA((std::string("Profiling, hardware counters: ") + m_pProfiler->GetCounterSource() + "\n").c_str());
+}
+
+void ModelPreviewScene::CycleHeatmapView()
+{
+	if (!m_pHeatmap)
+	{
+		m_pHeatmap = std::make_unique<Heatmap>(Graphics::ScreenWidth, Graphics::ScreenHeight);
+		m_pHeatmapPipeline = std::make_unique<GraphicsPipeline<HeatmapProgram<TexturedDirectionalLightningShaderProgram>>>(m_Graphics);
+		m_pUnshadowedHeatmapPipeline = std::make_unique<GraphicsPipeline<HeatmapProgram<UnshadowedTexturedDirectionalLightningShaderProgram>>>(m_Graphics);
+		m_pHeatmapPipeline->SetJobSystem(&m_Jobs);
+		m_pUnshadowedHeatmapPipeline->SetJobSystem(&m_Jobs);
+		m_pHeatmapPipeline->BindHeatmap(m_pHeatmap.get());
+		m_pUnshadowedHeatmapPipeline->BindHeatmap(m_pHeatmap.get());
+		m_HeatmapView = Heatmap::View::Overdraw;
+	}
+	else if (m_HeatmapView != Heatmap::View::TileCost)
+	{
+		m_HeatmapView = static_cast<Heatmap::View>(static_cast<int>(m_HeatmapView) + 1);
+	}
+	else
+	{
+		m_pHeatmapPipeline.reset();
+		m_pUnshadowedHeatmapPipeline.reset();
+		m_pHeatmap.reset();
+		m_WriteHeatmap = false;
+	}
+}
+
+void ModelPreviewScene::SetAntiAliasing(bool enabled, MultisampleTarget::Mode mode)
+{
+	if (!enabled)
+	{
+		m_pMultisampleTarget.reset();
+	}
+	else if (!m_pMultisampleTarget || m_pMultisampleTarget->GetMode() != mode)
+	{
+		m_pMultisampleTarget = std::make_unique<MultisampleTarget>(Graphics::ScreenWidth, Graphics::ScreenHeight, mode);
+	}
 
-	m_Pipeline.GetVertexShader().SetMVP(projection * view * model);
-	m_Pipeline.GetVertexShader().SetMV(view * model);
-	m_Pipeline.GetVertexShader().SetP(projection);
-	m_Pipeline.Draw();
+	m_Pipeline.BindMultisampleTarget(m_pMultisampleTarget.get());
+	m_UnshadowedPipeline.BindMultisampleTarget(m_pMultisampleTarget.get());
 }
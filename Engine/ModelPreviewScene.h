@@ -1,5 +1,12 @@
 #pragma once
 
+#include <chrono>
+#include <memory>
+
+#include "AllocationTracker.h"
+#include "AssetManager.h"
+#include "DrawCapture.h"
+#include "Heatmap.h"
 #include "MainWindow.h"
 #include "Scene.h"
 #include "TexturedDirectionalLightningShaderProgram.h"
@@ -7,16 +14,81 @@
 class ModelPreviewScene : public Scene<TexturedDirectionalLightningShaderProgram>
 {
 public:
-	ModelPreviewScene(Graphics& graphics, MainWindow& window);
+	ModelPreviewScene(Graphics& graphics, MainWindow& window, JobSystem& jobs);
 
 	void Start() override;
 	void Update() override;
 	void Draw() override;
 
+	// B, C, I and M, the keys that only report or write files, are ignored while disabled. Their reports take
+	// far longer than a frame and would end up in the frame times of a replay of recorded input.
+	void SetDebugKeysEnabled(bool enabled) { m_DebugKeysEnabled = enabled; }
+
 private:
+	void SetAntiAliasing(bool enabled, MultisampleTarget::Mode mode = MultisampleTarget::Mode::MSAA4x);
+	void LoadTextures(Texture::Format format);
+	// Hands assets that finished loading in the background to the model and the pipelines
+	void PollAssets();
+	// Starts recording the frames drawn from now on, or stops and writes them to CapturePath
+	void ToggleCapture();
+	// Starts adding the stage costs of the main pass up, reported with the frame stats, or stops
+	void ToggleProfiling();
+	// Off, then every view of the heatmap in turn, then off again
+	void CycleHeatmapView();
+
+	Graphics& m_Graphics;
 	MainWindow& m_Window;
 	GraphicsPipeline<TexturedDirectionalLightningShaderProgram> m_Pipeline;
+	// Same model without shadows, through the program variant that does not interpolate view positions
+	GraphicsPipeline<UnshadowedTexturedDirectionalLightningShaderProgram> m_UnshadowedPipeline;
+	bool m_ShadowsEnabled = true;
+	bool m_DebugKeysEnabled = true;
+	// Recorded anew every frame, clearing keeps their memory
+	CommandBuffer<TexturedDirectionalLightningShaderProgram> m_Commands;
+	CommandBuffer<UnshadowedTexturedDirectionalLightningShaderProgram> m_UnshadowedCommands;
+
+	// Declared before everything that is loaded through it
+	AssetManager m_Assets;
+	std::chrono::steady_clock::time_point m_CreationTime = std::chrono::steady_clock::now();
+	bool m_StartupLoadsReported = false;
+
+	// Requests are reset once they are done, whether their asset has been handed over or failed to load
+	AssetFuture<Mesh> m_ModelRequest;
+	AssetFuture<Texture> m_TextureRequest;
 
+	// Empty, and skipped when drawing, until its mesh is loaded
 	Entity m_Model;
 	std::vector<TexturedDirectionalLightningShaderProgram::VSIn> m_TriangleInput;
+	// Format of the bound texture, and of the one that is loading
+	Texture::Format m_TextureFormat = Texture::Format::RGB8;
+	Texture::Format m_RequestedTextureFormat = Texture::Format::RGB8;
+
+	ShadowMap m_SunShadowMap;
+	Vec3 m_SunDirection;
+	int m_FrameCount = 0;
+	// Main thread counts when the previous frame started, after its report was written
+	AllocationTracker::Counts m_FrameStartAllocations;
+	// Tag counts of all threads at the same time, so the memory report shows what was allocated in the last frame
+	AllocationTracker::TagSnapshot m_FrameStartTags{};
+
+	static constexpr unsigned char BackgroundColor = 200u;
+	static constexpr const char* TexturePath = "models/boxTexture.png";
+	static constexpr const char* TextureCacheDirectory = "cache/textures";
+	static constexpr const char* ModelPath = "models/box.obj";
+	static constexpr const char* CapturePath = "captures/preview.dcap";
+
+	std::unique_ptr<MultisampleTarget> m_pMultisampleTarget;
+	// Set while capturing, frames are only added once nothing is loading any more
+	std::unique_ptr<DrawCapture> m_pCapture;
+	// Set while profiling, reset after every report
+	std::unique_ptr<PipelineProfiler> m_pProfiler;
+
+	// Set while the heatmap is shown, the main pass is then drawn by the heatmap pipelines in the same state
+	std::unique_ptr<Heatmap> m_pHeatmap;
+	std::unique_ptr<GraphicsPipeline<HeatmapProgram<TexturedDirectionalLightningShaderProgram>>> m_pHeatmapPipeline;
+	std::unique_ptr<GraphicsPipeline<HeatmapProgram<UnshadowedTexturedDirectionalLightningShaderProgram>>> m_pUnshadowedHeatmapPipeline;
+	Heatmap::View m_HeatmapView = Heatmap::View::Overdraw;
+	// Writes the next heatmap and the frame under it to HeatmapDirectory
+	bool m_WriteHeatmap = false;
+	static constexpr const char* HeatmapDirectory = "captures";
 };
\ No newline at end of file
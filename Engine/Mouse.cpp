@@ -19,6 +19,7 @@
  *	along with The Chili DirectX Framework.  If not, see <http://www.gnu.org/licenses/>.  *
  ******************************************************************************************/
 #include "Mouse.h"
+#include "InputRecording.h"
 
 
 std::pair<int,int> Mouse::GetPos() const
@@ -72,16 +73,28 @@ void Mouse::Flush()
 
 void Mouse::OnMouseLeave()
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::MouseLeave ) )
+	{
+		return;
+	}
 	isInWindow = false;
 }
 
 void Mouse::OnMouseEnter()
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::MouseEnter ) )
+	{
+		return;
+	}
 	isInWindow = true;
 }
 
 void Mouse::OnMouseMove( int newx,int newy )
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::MouseMove,0,newx,newy ) )
+	{
+		return;
+	}
 	x = newx;
 	y = newy;
 
@@ -91,6 +104,10 @@ void Mouse::OnMouseMove( int newx,int newy )
 
 void Mouse::OnLeftPressed( int x,int y )
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::LeftPressed,0,x,y ) )
+	{
+		return;
+	}
 	leftIsPressed = true;
 
 	buffer.push( Mouse::Event( Mouse::Event::Type::LPress,*this ) );
@@ -99,6 +116,10 @@ void Mouse::OnLeftPressed( int x,int y )
 
 void Mouse::OnLeftReleased( int x,int y )
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::LeftReleased,0,x,y ) )
+	{
+		return;
+	}
 	leftIsPressed = false;
 
 	buffer.push( Mouse::Event( Mouse::Event::Type::LRelease,*this ) );
@@ -107,6 +128,10 @@ void Mouse::OnLeftReleased( int x,int y )
 
 void Mouse::OnRightPressed( int x,int y )
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::RightPressed,0,x,y ) )
+	{
+		return;
+	}
 	rightIsPressed = true;
 
 	buffer.push( Mouse::Event( Mouse::Event::Type::RPress,*this ) );
@@ -115,6 +140,10 @@ void Mouse::OnRightPressed( int x,int y )
 
 void Mouse::OnRightReleased( int x,int y )
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::RightReleased,0,x,y ) )
+	{
+		return;
+	}
 	rightIsPressed = false;
 
 	buffer.push( Mouse::Event( Mouse::Event::Type::RRelease,*this ) );
@@ -123,12 +152,20 @@ void Mouse::OnRightReleased( int x,int y )
 
 void Mouse::OnWheelUp( int x,int y )
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::WheelUp,0,x,y ) )
+	{
+		return;
+	}
 	buffer.push( Mouse::Event( Mouse::Event::Type::WheelUp,*this ) );
 	TrimBuffer();
 }
 
 void Mouse::OnWheelDown( int x,int y )
 {
+	if( pRecording && !pRecording->OnInput( InputRecording::EventType::WheelDown,0,x,y ) )
+	{
+		return;
+	}
 	buffer.push( Mouse::Event( Mouse::Event::Type::WheelDown,*this ) );
 	TrimBuffer();
 }
@@ -24,6 +24,7 @@
 class Mouse
 {
 	friend class MainWindow;
+	friend class InputRecording;
 public:
 	class Event
 	{
@@ -126,4 +127,6 @@ private:
 	bool rightIsPressed = false;
 	bool isInWindow = false;
 	std::queue<Event> buffer;
+	// records the input, or drops it while a recording plays back
+	class InputRecording* pRecording = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cassert>
+
+#include "MultisampleTarget.h"
+#include "DepthBuffer.h"
+#include "AllocationTracker.h"
+
+MultisampleTarget::MultisampleTarget(int width, int height, Mode mode)
+	:
+	m_Width(width),
+	m_Height(height),
+	m_Mode(mode)
+{
+	assert(width <= Graphics::ScreenWidth && height <= Graphics::ScreenHeight);
+
+	// Standard D3D sample patterns, given in 1/16 of a pixel
+	switch (mode)
+	{
+	case Mode::MSAA2x:
+		m_SampleOffsets = { { 4.0f / 16.0f, 4.0f / 16.0f }, { -4.0f / 16.0f, -4.0f / 16.0f } };
+		break;
+	case Mode::MSAA4x:
+	case Mode::SSAA4x:
+		m_SampleOffsets =
+		{
+			{ -2.0f / 16.0f, -6.0f / 16.0f },
+			{ 6.0f / 16.0f, -2.0f / 16.0f },
+			{ -6.0f / 16.0f, 2.0f / 16.0f },
+			{ 2.0f / 16.0f, 6.0f / 16.0f }
+		};
+		break;
+	}
+
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Pipeline);
+	m_Samples.resize(static_cast<size_t>(width) * height * m_SampleOffsets.size());
+}
+
+void MultisampleTarget::Clear(Color color)
+{
+	std::fill(m_Samples.begin(), m_Samples.end(), Sample{ DepthBuffer::ClearValue, color });
+}
+
+void MultisampleTarget::Resolve(Graphics& graphics) const
+{
+	const unsigned int sampleCount = static_cast<unsigned int>(m_SampleOffsets.size());
+	const Sample* pSample = m_Samples.data();
+
+	for (int y = 0; y < m_Height; y++)
+	{
+		for (int x = 0; x < m_Width; x++)
+		{
+			unsigned int r = 0, g = 0, b = 0;
+			for (unsigned int i = 0; i < sampleCount; i++, pSample++)
+			{
+				r += pSample->m_Color.GetR();
+				g += pSample->m_Color.GetG();
+				b += pSample->m_Color.GetB();
+			}
+
+			graphics.PutPixel(x, y, r / sampleCount, g / sampleCount, b / sampleCount);
+		}
+	}
+}
\ No newline at end of file
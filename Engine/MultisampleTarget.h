@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+
+#include "Vec2.h"
+#include "Colors.h"
+#include "Graphics.h"
+
+// Color and depth storage with several samples per pixel.
+// Samples of a pixel are stored next to each other, each one holding its depth and color,
+// so a covered pixel touches a single cache line no matter how many samples it writes.
+class MultisampleTarget
+{
+public:
+	enum class Mode
+	{
+		MSAA2x,
+		MSAA4x,
+		// Same sample pattern as MSAA4x, but the pixel shader runs for every sample (quality and cost baseline)
+		SSAA4x
+	};
+
+	struct Sample
+	{
+		float m_Depth;
+		Color m_Color;
+	};
+
+	MultisampleTarget(int width, int height, Mode mode);
+
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+
+	Mode GetMode() const { return m_Mode; }
+	int GetSampleCount() const { return static_cast<int>(m_SampleOffsets.size()); }
+	bool ShadesPerSample() const { return m_Mode == Mode::SSAA4x; }
+
+	// Offset of the sample from the pixel center, in pixels
+	const Vec2& GetSampleOffset(int sample) const { return m_SampleOffsets[sample]; }
+
+	Sample* GetPixelSamples(int x, int y) { return &m_Samples[(y * m_Width + x) * m_SampleOffsets.size()]; }
+
+	void Clear(Color color);
+
+	// Averages the samples of every pixel and writes the result to the screen
+	void Resolve(Graphics& graphics) const;
+
+private:
+	int m_Width;
+	int m_Height;
+	Mode m_Mode;
+
+	std::vector<Vec2> m_SampleOffsets;
+	std::vector<Sample> m_Samples;
+};
\ No newline at end of file
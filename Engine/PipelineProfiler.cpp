@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+#if defined(__linux__)
+	#include <linux/perf_event.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+#include "PipelineProfiler.h"
+
+namespace
+{
+	struct Reading
+	{
+		uint64_t m_Nanoseconds = 0;
+		std::array<uint64_t, PipelineProfiler::CounterCount> m_Counters{};
+	};
+
+	// Hardware counters of the calling thread, opened on first use and kept for the lifetime of the thread
+	class ThreadCounters
+	{
+	public:
+		~ThreadCounters()
+		{
+#if defined(__linux__)
+			for (int fd : m_Fds)
+			{
+				if (fd >= 0) close(fd);
+			}
+#endif
+		}
+
+		const std::array<bool, PipelineProfiler::CounterCount>& Open()
+		{
+			if (m_Opened) return m_Available;
+			m_Opened = true;
+
+#if defined(__linux__)
+			// One group, so all of them count over exactly the same intervals and are read with a single syscall
+			const std::pair<uint32_t, uint64_t> events[PipelineProfiler::CounterCount] =
+			{
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+				{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+				{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+			};
+
+			m_Fds.fill(-1);
+			int groupFd = -1;
+			for (size_t i = 0; i < PipelineProfiler::CounterCount; i++)
+			{
+				perf_event_attr attributes{};
+				attributes.size = sizeof(attributes);
+				attributes.type = events[i].first;
+				attributes.config = events[i].second;
+				attributes.disabled = groupFd < 0 ? 1 : 0;
+				attributes.exclude_kernel = 1;
+				attributes.exclude_hv = 1;
+				attributes.read_format = PERF_FORMAT_GROUP;
+
+				// This thread on whatever CPU it runs
+				const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, groupFd, 0));
+				if (fd < 0) continue;
+
+				m_Fds[i] = fd;
+				m_Available[i] = true;
+				if (groupFd < 0) groupFd = fd;
+			}
+
+			if (groupFd >= 0)
+			{
+				ioctl(groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+				ioctl(groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+				m_GroupFd = groupFd;
+			}
+#elif defined(_WIN32)
+			ULONG64 cycles;
+			m_Available[static_cast<size_t>(PipelineProfiler::Counter::Cycles)] = QueryThreadCycleTime(GetCurrentThread(), &cycles) != 0;
+#endif
+
+			return m_Available;
+		}
+
+		void Read(std::array<uint64_t, PipelineProfiler::CounterCount>& counters) const
+		{
+			if (!m_Opened) return;
+
+#if defined(__linux__)
+			if (m_GroupFd < 0) return;
+
+			// Values of the group in the order its members were opened
+			uint64_t values[1 + PipelineProfiler::CounterCount];
+			if (read(m_GroupFd, values, sizeof(values)) < static_cast<ssize_t>(sizeof(uint64_t))) return;
+
+			size_t value = 1u;
+			for (size_t i = 0; i < PipelineProfiler::CounterCount && value <= values[0]; i++)
+			{
+				if (m_Available[i]) counters[i] = values[value++];
+			}
+#elif defined(_WIN32)
+			ULONG64 cycles;
+			if (m_Available[static_cast<size_t>(PipelineProfiler::Counter::Cycles)] && QueryThreadCycleTime(GetCurrentThread(), &cycles))
+			{
+				counters[static_cast<size_t>(PipelineProfiler::Counter::Cycles)] = cycles;
+			}
+#endif
+		}
+
+	private:
+		bool m_Opened = false;
+		std::array<bool, PipelineProfiler::CounterCount> m_Available{};
+#if defined(__linux__)
+		std::array<int, PipelineProfiler::CounterCount> m_Fds;
+		int m_GroupFd = -1;
+#endif
+	};
+
+	thread_local ThreadCounters s_Counters;
+	// Innermost open scope of this thread, and when it last took a reading
+	thread_local PipelineProfiler::Scope* s_pCurrentScope = nullptr;
+	thread_local Reading s_LastReading;
+
+	Reading Read()
+	{
+		Reading reading;
+		reading.m_Nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+		s_Counters.Read(reading.m_Counters);
+		return reading;
+	}
+
+	const char* const StageNames[PipelineProfiler::StageCount] = { "vertex shading", "clipping", "rasterization" };
+	const char* const ItemNames[PipelineProfiler::StageCount] = { "vertex", "triangle", "pixel" };
+	const char* const ItemPluralNames[PipelineProfiler::StageCount] = { "vertices", "triangles", "pixels" };
+	const char* const CounterNames[PipelineProfiler::CounterCount] = { "cycles", "instructions", "L1D misses", "LLC misses", "branch misses" };
+}
+
+void PipelineProfiler::Cost::Add(const Cost& other)
+{
+	m_Nanoseconds += other.m_Nanoseconds;
+	for (size_t i = 0; i < CounterCount; i++) m_Counters[i] += other.m_Counters[i];
+	m_Items += other.m_Items;
+}
+
+void PipelineProfiler::Scope::Begin(Stage stage, int tile, const uint64_t* pItems)
+{
+	if (m_pProfiler->m_ReadCounters) s_Counters.Open();
+
+	m_Stage = stage;
+	m_Tile = tile;
+	m_pItems = pItems;
+	if (m_pItems != nullptr) m_ItemsAtBegin = *m_pItems;
+
+	// The enclosing scope keeps what happened up to here
+	m_pParent = s_pCurrentScope;
+	if (m_pParent != nullptr) m_pParent->Accumulate();
+	else s_LastReading = Read();
+	s_pCurrentScope = this;
+}
+
+void PipelineProfiler::Scope::End()
+{
+	Accumulate();
+	s_pCurrentScope = m_pParent;
+
+	if (m_pItems != nullptr) m_Cost.m_Items += *m_pItems - m_ItemsAtBegin;
+	m_pProfiler->Add(m_Stage, m_Tile, m_Cost);
+}
+
+void PipelineProfiler::Scope::Accumulate()
+{
+	const Reading now = Read();
+	m_Cost.m_Nanoseconds += now.m_Nanoseconds - s_LastReading.m_Nanoseconds;
+	// Another profiler on this thread may have opened counters in the meantime
+	if (m_pProfiler->m_ReadCounters)
+	{
+		for (size_t i = 0; i < CounterCount; i++) m_Cost.m_Counters[i] += now.m_Counters[i] - std::min(s_LastReading.m_Counters[i], now.m_Counters[i]);
+	}
+	s_LastReading = now;
+}
+
+PipelineProfiler::PipelineProfiler(bool readCounters, int viewportWidth, int viewportHeight)
+	:
+	m_ReadCounters(readCounters),
+	m_TileColumns((viewportWidth + TileSize - 1) / TileSize),
+	m_TileRows((viewportHeight + TileSize - 1) / TileSize),
+	m_Tiles(static_cast<size_t>(m_TileColumns) * m_TileRows)
+{
+	if (m_ReadCounters) m_Available = s_Counters.Open();
+}
+
+const char* PipelineProfiler::GetCounterSource() const
+{
+	if (std::none_of(m_Available.begin(), m_Available.end(), [](bool available) { return available; })) return "none";
+
+#if defined(__linux__)
+	return "perf_event";
+#else
+	return "QueryThreadCycleTime";
+#endif
+}
+
+int PipelineProfiler::GetTile(float screenX, float screenY) const
+{
+	const int column = std::min(std::max(static_cast<int>(screenX) / TileSize, 0), m_TileColumns - 1);
+	const int row = std::min(std::max(static_cast<int>(screenY) / TileSize, 0), m_TileRows - 1);
+	return row * m_TileColumns + column;
+}
+
+PipelineProfiler::Cost PipelineProfiler::GetStageCost(Stage stage) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Stages[static_cast<size_t>(stage)];
+}
+
+std::vector<PipelineProfiler::Cost> PipelineProfiler::GetTileCosts() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Tiles;
+}
+
+void PipelineProfiler::Reset()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Stages.fill(Cost());
+	std::fill(m_Tiles.begin(), m_Tiles.end(), Cost());
+}
+
+void PipelineProfiler::Add(Stage stage, int tile, const Cost& cost)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Stages[static_cast<size_t>(stage)].Add(cost);
+	if (tile >= 0 && tile < static_cast<int>(m_Tiles.size())) m_Tiles[tile].Add(cost);
+}
+
+std::string PipelineProfiler::GetReport(const std::string& title, size_t tileCount) const
+{
+	std::array<Cost, StageCount> stages;
+	std::vector<Cost> tiles;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		stages = m_Stages;
+		tiles = m_Tiles;
+	}
+
+	const bool hasCycles = IsAvailable(Counter::Cycles);
+	const bool hasInstructions = IsAvailable(Counter::Instructions);
+
+	// Counters per item, and instructions per cycle where both are known
+	auto reportCost = [&](std::ostringstream& report, const Cost& cost, size_t stage)
+	{
+		const char* itemName = ItemNames[stage];
+		report << std::fixed << std::setprecision(3) << cost.m_Nanoseconds / 1.0e6 << " ms, " << cost.m_Items << " " << ItemPluralNames[stage];
+		if (hasCycles && hasInstructions && cost.m_Counters[static_cast<size_t>(Counter::Cycles)] > 0u)
+		{
+			report << std::setprecision(2) << ", IPC " << static_cast<double>(cost.m_Counters[static_cast<size_t>(Counter::Instructions)]) / cost.m_Counters[static_cast<size_t>(Counter::Cycles)];
+		}
+		if (cost.m_Items == 0u) return;
+
+		for (size_t i = 0; i < CounterCount; i++)
+		{
+			if (!m_Available[i] || i == static_cast<size_t>(Counter::Instructions)) continue;
+
+			report << std::setprecision(i == static_cast<size_t>(Counter::Cycles) ? 1 : 3)
+				<< ", " << CounterNames[i] << "/" << itemName << " " << static_cast<double>(cost.m_Counters[i]) / cost.m_Items;
+		}
+	};
+
+	std::ostringstream report;
+	report << title << " profile, hardware counters: " << (m_ReadCounters ? GetCounterSource() : "off");
+	const char* separator = " (unavailable: ";
+	for (size_t i = 0; i < CounterCount; i++)
+	{
+		if (!m_ReadCounters || m_Available[i]) continue;
+
+		report << separator << CounterNames[i];
+		separator = ", ";
+	}
+	report << (separator[0] == ',' ? ")\n" : "\n");
+
+	for (size_t i = 0; i < StageCount; i++)
+	{
+		report << "  " << std::left << std::setw(16) << StageNames[i] << std::right;
+		reportCost(report, stages[i], i);
+		report << "\n";
+	}
+
+	// Cycles tell more than time where they are known, they don't count the time the thread wasn't running
+	const size_t sortCounter = static_cast<size_t>(Counter::Cycles);
+	auto costOf = [&](const Cost& cost) { return hasCycles ? cost.m_Counters[sortCounter] : cost.m_Nanoseconds; };
+
+	std::vector<size_t> order(tiles.size());
+	std::iota(order.begin(), order.end(), size_t(0));
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return costOf(tiles[a]) > costOf(tiles[b]); });
+
+	report << "  costliest " << TileSize << "x" << TileSize << " tiles by " << (hasCycles ? "cycles" : "time") << "\n";
+	for (size_t i = 0; i < std::min(tileCount, order.size()) && costOf(tiles[order[i]]) > 0u; i++)
+	{
+		const int column = static_cast<int>(order[i]) % m_TileColumns;
+		const int row = static_cast<int>(order[i]) / m_TileColumns;
+		report << "    (" << column * TileSize << ", " << row * TileSize << ") ";
+		reportCost(report, tiles[order[i]], static_cast<size_t>(Stage::Rasterization));
+		report << "\n";
+	}
+
+	return report.str();
+}
\ No newline at end of file
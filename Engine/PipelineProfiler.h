@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Graphics.h"
+
+// Costs of the pipeline stages of the draws it is set on (see GraphicsPipeline::SetProfiler): wall time, and hardware
+// counters of the threads doing the work where the platform lets us read them. On Linux those come from perf_event,
+// on Windows only cycles are known (QueryThreadCycleTime). Counters that can't be opened, because of the platform,
+// the kernel's perf_event_paranoid setting or a virtual machine without a PMU, are reported as unavailable and the
+// stages are still timed.
+class PipelineProfiler
+{
+public:
+	enum class Stage
+	{
+		VertexShading,
+		// Culling, clipping and screen mapping of whole triangles
+		Clipping,
+		Rasterization,
+		Count
+	};
+
+	enum class Counter
+	{
+		Cycles,
+		Instructions,
+		L1DataMisses,
+		LastLevelCacheMisses,
+		BranchMisses,
+		Count
+	};
+
+	static constexpr size_t StageCount = static_cast<size_t>(Stage::Count);
+	static constexpr size_t CounterCount = static_cast<size_t>(Counter::Count);
+
+	struct Cost
+	{
+		uint64_t m_Nanoseconds = 0;
+		std::array<uint64_t, CounterCount> m_Counters{};
+		// Vertices shaded, triangles assembled or pixels visited, depending on the stage
+		uint64_t m_Items = 0;
+
+		void Add(const Cost& other);
+	};
+
+	// Time and counters from construction to destruction go to the stage, except what scopes nested in it on the
+	// same thread took. With a tile, rasterization costs are also added up per screen tile. Does nothing without a profiler.
+	class Scope
+	{
+	public:
+		// Items counted meanwhile are read from pItems, when given
+		Scope(PipelineProfiler* pProfiler, Stage stage, int tile = -1, const uint64_t* pItems = nullptr)
+			:
+			m_pProfiler(pProfiler)
+		{
+			if (m_pProfiler != nullptr) Begin(stage, tile, pItems);
+		}
+		~Scope()
+		{
+			if (m_pProfiler != nullptr) End();
+		}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+		void AddItems(uint64_t count) { m_Cost.m_Items += count; }
+
+	private:
+		void Begin(Stage stage, int tile, const uint64_t* pItems);
+		void End();
+		// Adds what was read since the last reading on this thread
+		void Accumulate();
+
+		PipelineProfiler* m_pProfiler;
+		Stage m_Stage = Stage::Count;
+		int m_Tile = -1;
+		const uint64_t* m_pItems = nullptr;
+		uint64_t m_ItemsAtBegin = 0;
+		Cost m_Cost;
+		Scope* m_pParent = nullptr;
+	};
+
+	// Tiles cover the viewport of the pipelines the profiler is set on. Without readCounters only wall time is measured.
+	explicit PipelineProfiler(bool readCounters = true, int viewportWidth = Graphics::ScreenWidth, int viewportHeight = Graphics::ScreenHeight);
+
+	// As opened on the thread that created the profiler, other threads read the same ones where they can
+	bool IsAvailable(Counter counter) const { return m_Available[static_cast<size_t>(counter)]; }
+	const char* GetCounterSource() const;
+
+	// Tile whose rasterization costs a triangle with its bounding box centered on the screen position adds to
+	int GetTile(float screenX, float screenY) const;
+
+	Cost GetStageCost(Stage stage) const;
+	// Rasterization costs, tile rows from the top of the screen
+	std::vector<Cost> GetTileCosts() const;
+	void Reset();
+
+	// IPC and misses per vertex, triangle and pixel of every stage, then the tiles with the most cycles (or time)
+	std::string GetReport(const std::string& title = "Pipeline", size_t tileCount = 5) const;
+
+	static constexpr int TileSize = 64;
+
+private:
+	void Add(Stage stage, int tile, const Cost& cost);
+
+	bool m_ReadCounters;
+	std::array<bool, CounterCount> m_Available{};
+	int m_TileColumns;
+	int m_TileRows;
+
+	mutable std::mutex m_Mutex;
+	std::array<Cost, StageCount> m_Stages;
+	std::vector<Cost> m_Tiles;
+};
\ No newline at end of file
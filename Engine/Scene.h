@@ -4,16 +4,38 @@
 
 #include "GraphicsPipeline.h"
 #include "Entity.h"
+#include "JobSystem.h"
 
 template<class TShaderProgram>
 class Scene
 {
 public:
+	explicit Scene(JobSystem& jobs)
+		:
+		m_Jobs(jobs)
+	{
+	}
+	virtual ~Scene() = default;
+
 	virtual void Start() { }
 	virtual void Update() { }
 
 	virtual void Draw() = 0;
 
+protected:
+	// Entities don't depend on each other, their transforms are updated in parallel batches
+	void UpdateModelTransforms(Entity* pEntities, size_t count)
+	{
+		m_Jobs.ParallelFor(0u, count, EntitiesPerJob, [pEntities](size_t first, size_t last)
+		{
+			for (size_t i = first; i < last; i++) pEntities[i].UpdateModelTransform();
+		});
+	}
+
+	JobSystem& m_Jobs;
+
+	static constexpr size_t EntitiesPerJob = 64u;
+
 public:
 	Vec3 m_CameraPosition;
 	Vec3 m_CameraEulerAngles;
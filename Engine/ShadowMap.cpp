@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "ShadowMap.h"
+#include "Simd.h"
+
+namespace
+{
+#if ENGINE_SIMD_SSE
+	// Number of set bits in a 4-bit movemask
+	constexpr int s_LitTapCount[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+#endif
+
+	Vec3 ChooseUpVector(const Vec3& direction)
+	{
+		// Avoid a degenerate basis when looking straight up or down
+		return std::abs(Vec3::Dot(Vec3::Normalize(direction), Vec3::Up())) > 0.99f ? Vec3(0.0f, 0.0f, 1.0f) : Vec3::Up();
+	}
+}
+
+ShadowMap::ShadowMap(Graphics& graphics, int resolution, int filterSize)
+	:
+	m_Pipeline(graphics, resolution, resolution),
+	m_Resolution(resolution)
+{
+	SetFilterSize(filterSize);
+}
+
+void ShadowMap::SetDirectionalLight(const Vec3& direction, const Vec3& center, float extent, float depthRange)
+{
+	const Vec3 eye = center - Vec3::Normalize(direction) * (depthRange / 2.0f);
+
+	m_ViewProjection =
+		Mat4::OrthographicProjection(-extent, extent, -extent, extent, 0.0f, depthRange) *
+		Mat4::LookAt(eye, center, ChooseUpVector(direction));
+}
+
+void ShadowMap::SetSpotLight(const Vec3& position, const Vec3& direction, float fov, float nearPlane, float farPlane)
+{
+	m_ViewProjection =
+		Mat4::PerspectiveProjection(nearPlane, farPlane, fov, 1.0f) *
+		Mat4::LookAt(position, position + direction, ChooseUpVector(direction));
+}
+
+void ShadowMap::SetFilterSize(int filterSize)
+{
+	assert(filterSize > 0 && filterSize % 2 == 1);
+	// Stays odd, the largest odd size that fits when the resolution is smaller
+	m_FilterSize = std::min(filterSize, m_Resolution - (1 - m_Resolution % 2));
+}
+
+void ShadowMap::BeginPass()
+{
+	m_PassStart = std::chrono::steady_clock::now();
+	m_Cost = PassCost();
+
+	m_Pipeline.ClearZBuffer();
+}
+
+void ShadowMap::Draw(const Entity& entity)
+{
+	Draw(*entity.GetMesh(), entity.GetModelTransform());
+}
+
+void ShadowMap::Draw(const Mesh& mesh, const Mat4& modelTransform)
+{
+	m_Pipeline.BindIndices(mesh.GetIndices());
+	m_Pipeline.BindVertices(mesh.GetVertices());
+	m_Pipeline.GetVertexShader().SetMVP(m_ViewProjection * modelTransform);
+	m_Pipeline.Draw();
+
+	m_Cost.m_TrianglesSubmitted += mesh.GetIndices().size() / 3;
+}
+
+void ShadowMap::EndPass()
+{
+	m_Pipeline.ResolveZBuffer();
+
+	const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - m_PassStart;
+	m_Cost.m_RenderMilliseconds = elapsed.count();
+}
+
+float ShadowMap::SampleVisibility(const Vec4& lightClipPosition) const
+{
+	if (lightClipPosition.w <= 0.0f) return 1.0f;
+
+	m_Cost.m_Lookups++;
+
+	// Same mapping GraphicsPipeline uses to go from NDC to the depth target
+	const float wInverse = 1.0f / lightClipPosition.w;
+	const float texelX = m_Resolution / 2.0f * (1.0f + lightClipPosition.x * wInverse);
+	const float texelY = m_Resolution / 2.0f * (1.0f - lightClipPosition.y * wInverse);
+
+	const int centerX = static_cast<int>(std::floor(texelX));
+	const int centerY = static_cast<int>(std::floor(texelY));
+	if (centerX < 0 || centerX >= m_Resolution || centerY < 0 || centerY >= m_Resolution) return 1.0f;
+
+	// The depth pass stores interpolated NDC depth multiplied back by w, which is the clip space z
+	const float referenceDepth = lightClipPosition.z - m_DepthBias;
+
+	const DepthBuffer& depthBuffer = m_Pipeline.GetDepthBuffer();
+	const int radius = m_FilterSize / 2;
+	const int startX = centerX - radius;
+	const int startY = centerY - radius;
+
+	int litTaps = 0;
+#if ENGINE_SIMD_SSE
+	// Taps are compared four at a time, so the footprint is padded to a multiple of four
+	const int paddedSize = (m_FilterSize + 3) & ~3;
+
+	if (startX >= 0 && startX + paddedSize <= m_Resolution && startY >= 0 && startY + m_FilterSize <= m_Resolution)
+	{
+		const __m128 reference = _mm_set1_ps(referenceDepth);
+
+		for (int y = startY; y < startY + m_FilterSize; y++)
+		{
+			const float* pRow = depthBuffer.GetRow(y) + startX;
+
+			for (int x = 0; x < paddedSize; x += 4)
+			{
+				int litMask = _mm_movemask_ps(_mm_cmple_ps(reference, _mm_loadu_ps(pRow + x)));
+				if (x + 4 > m_FilterSize)
+				{
+					litMask &= (1 << (m_FilterSize - x)) - 1;
+				}
+
+				litTaps += s_LitTapCount[litMask];
+			}
+		}
+	}
+	else
+#endif
+	{
+		// Footprint touches the border, or no SSE, clamp every tap
+		for (int y = startY; y < startY + m_FilterSize; y++)
+		{
+			const int clampedY = std::min(std::max(y, 0), m_Resolution - 1);
+
+			for (int x = startX; x < startX + m_FilterSize; x++)
+			{
+				const int clampedX = std::min(std::max(x, 0), m_Resolution - 1);
+				litTaps += referenceDepth <= depthBuffer.At(clampedX, clampedY);
+			}
+		}
+	}
+
+	return static_cast<float>(litTaps) / static_cast<float>(m_FilterSize * m_FilterSize);
+}
+
+std::string ShadowMap::GetCostReport(const std::string& lightName) const
+{
+	std::ostringstream report;
+	report
+		<< "Shadow " << lightName << ": "
+		<< m_Resolution << "x" << m_Resolution << ", "
+		<< m_FilterSize << "x" << m_FilterSize << " PCF, "
+		<< "depth pass " << m_Cost.m_RenderMilliseconds << " ms, "
+		<< m_Cost.m_TrianglesSubmitted << " triangles, "
+		<< m_Cost.m_Lookups << " lookups ("
+		<< m_Cost.m_Lookups * m_FilterSize * m_FilterSize << " taps)\n";
+
+	return report.str();
+}
\ No newline at end of file
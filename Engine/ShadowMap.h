@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "GraphicsPipeline.h"
+#include "DepthOnlyShaderProgram.h"
+#include "Entity.h"
+
+// Depth target rendered from a light's point of view, sampled with percentage-closer filtering.
+class ShadowMap
+{
+public:
+	struct PassCost
+	{
+		float m_RenderMilliseconds = 0.0f;
+		size_t m_TrianglesSubmitted = 0;
+		size_t m_Lookups = 0;
+	};
+
+	ShadowMap(Graphics& graphics, int resolution = 1024, int filterSize = 3);
+
+	// direction points from the light towards the scene
+	void SetDirectionalLight(const Vec3& direction, const Vec3& center, float extent, float depthRange);
+	void SetSpotLight(const Vec3& position, const Vec3& direction, float fov, float nearPlane, float farPlane);
+	// Light view and projection given directly, as captured from another shadow map
+	void SetViewProjection(const Mat4& viewProjection) { m_ViewProjection = viewProjection; }
+
+	int GetResolution() const { return m_Resolution; }
+
+	// Vertices of the pass are shaded in parallel on it
+	void SetJobSystem(JobSystem* pJobs) { m_Pipeline.SetJobSystem(pJobs); }
+	// Costs of the pass go to it, see GraphicsPipeline::SetProfiler
+	void SetProfiler(PipelineProfiler* pProfiler) { m_Pipeline.SetProfiler(pProfiler); }
+
+	// Number of taps along each axis, must be odd
+	void SetFilterSize(int filterSize);
+	int GetFilterSize() const { return m_FilterSize; }
+
+	void SetDepthBias(float depthBias) { m_DepthBias = depthBias; }
+	float GetDepthBias() const { return m_DepthBias; }
+
+	const Mat4& GetViewProjection() const { return m_ViewProjection; }
+
+	void BeginPass();
+	void Draw(const Entity& entity);
+	void Draw(const Mesh& mesh, const Mat4& modelTransform);
+	void EndPass();
+
+	// Returns the lit fraction of the filter footprint around a position given in this light's clip space
+	float SampleVisibility(const Vec4& lightClipPosition) const;
+
+	const PassCost& GetLastPassCost() const { return m_Cost; }
+	std::string GetCostReport(const std::string& lightName) const;
+
+private:
+	GraphicsPipeline<DepthOnlyShaderProgram> m_Pipeline;
+
+	int m_Resolution;
+	int m_FilterSize;
+	float m_DepthBias = 0.005f;
+
+	Mat4 m_ViewProjection;
+
+	std::chrono::steady_clock::time_point m_PassStart;
+	mutable PassCost m_Cost;
+};
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+// SSE2 is part of every x64 target and the Win32 configurations build with /arch:SSE2,
+// so Vec4 loads/stores and the Mat4 product use it unconditionally. Define ENGINE_SIMD_SCALAR to fall back to plain C++.
+// Wider instruction sets are only used by TransformKernels, which checks the CPU at runtime.
+#if !defined(ENGINE_SIMD_SCALAR) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+	#define ENGINE_SIMD_SSE 1
+	#include <xmmintrin.h>
+#else
+	#define ENGINE_SIMD_SSE 0
+#endif
\ No newline at end of file
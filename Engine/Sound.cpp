@@ -31,6 +31,7 @@
 #include <Propvarutil.h>
 #include "XAudio\XAudio2.h"
 #include "DXErr.h"
+#include "AllocationTracker.h"
 
 #pragma comment( lib,"mfplat.lib" )
 #pragma comment( lib,"mfreadwrite.lib" )
@@ -375,6 +376,9 @@ Sound Sound::LoadNonWav( const std::wstring& fileName,LoopType loopType,
 {
 	namespace wrl = Microsoft::WRL;
 
+	// decoded samples are charged to sounds, whoever plays them
+	AllocationTracker::TagScope tag( AllocationTracker::Tag::Sounds );
+
 	// if manual float looping, second inputs cannot be null
 	assert( (loopType == LoopType::ManualFloat) !=
 		(loopStartSeconds == nullSeconds || loopEndSeconds == nullSeconds) &&
@@ -681,6 +685,8 @@ Sound::Sound( const std::wstring& fileName,LoopType loopType,
 	unsigned int loopStartSample,unsigned int loopEndSample,
 	float loopStartSeconds,float loopEndSeconds )
 {
+	AllocationTracker::TagScope tag( AllocationTracker::Tag::Sounds );
+
 	// if manual float looping, second inputs cannot be null
 	assert( (loopType == LoopType::ManualFloat) !=
 		(loopStartSeconds == nullSeconds || loopEndSeconds == nullSeconds) &&
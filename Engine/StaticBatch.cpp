@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <limits>
+
+#include "StaticBatch.h"
+#include "AllocationTracker.h"
+#include "TransformKernels.h"
+
+namespace
+{
+	// Every other bit of the 10 lowest ones moved two places up, for interleaving three of them
+	uint32_t SpreadBits(uint32_t value)
+	{
+		value &= 0x3FFu;
+		value = (value | (value << 16)) & 0x030000FFu;
+		value = (value | (value << 8)) & 0x0300F00Fu;
+		value = (value | (value << 4)) & 0x030C30C3u;
+		value = (value | (value << 2)) & 0x09249249u;
+		return value;
+	}
+
+	// Position on a Z-order curve through the box, close codes are close in space
+	uint32_t MortonCode(const Vec3& position, const Vec3& min, const Vec3& max)
+	{
+		auto quantize = [](float value, float low, float high)
+		{
+			const float t = high > low ? (value - low) / (high - low) : 0.0f;
+			return static_cast<uint32_t>(std::min(std::max(t, 0.0f), 1.0f) * 1023.0f);
+		};
+		return SpreadBits(quantize(position.x, min.x, max.x))
+			| (SpreadBits(quantize(position.y, min.y, max.y)) << 1)
+			| (SpreadBits(quantize(position.z, min.z, max.z)) << 2);
+	}
+
+	// Inverse transpose of the upper 3x3 of the transform times its determinant, built from the cofactors. Normals
+	// stay perpendicular to the surface under scaling of any kind, and the normalization after the transform takes
+	// the determinant out again, its sign is taken out here so that mirrored normals still point outwards.
+	Mat4 NormalTransform(const Mat4& transform)
+	{
+		Mat4 normalTransform;
+		for (int i = 0; i < 3; i++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				// Taking the other rows and columns in cyclic order gives the cofactor its sign
+				const int i1 = (i + 1) % 3;
+				const int i2 = (i + 2) % 3;
+				const int j1 = (j + 1) % 3;
+				const int j2 = (j + 2) % 3;
+				normalTransform[i][j] = transform[i1][j1] * transform[i2][j2] - transform[i1][j2] * transform[i2][j1];
+			}
+		}
+
+		const float determinant = transform[0][0] * normalTransform[0][0] + transform[0][1] * normalTransform[0][1] + transform[0][2] * normalTransform[0][2];
+		if (determinant < 0.0f) normalTransform = -1.0f * normalTransform;
+		normalTransform[3][3] = 1.0f;
+		return normalTransform;
+	}
+
+	Vec3 Min(const Vec3& lhs, const Vec3& rhs)
+	{
+		return { std::min(lhs.x, rhs.x), std::min(lhs.y, rhs.y), std::min(lhs.z, rhs.z) };
+	}
+
+	Vec3 Max(const Vec3& lhs, const Vec3& rhs)
+	{
+		return { std::max(lhs.x, rhs.x), std::max(lhs.y, rhs.y), std::max(lhs.z, rhs.z) };
+	}
+
+	constexpr float Infinity = std::numeric_limits<float>::infinity();
+}
+
+StaticBatch::StaticBatch(size_t maxChunkTriangles)
+	:
+	m_MaxChunkTriangles(std::max<size_t>(maxChunkTriangles, 1u))
+{
+}
+
+void StaticBatch::Add(const Entity& entity, Material pMaterial)
+{
+	const std::shared_ptr<const Mesh>& pMesh = entity.GetMesh();
+	if (!pMesh || pMesh->GetIndices().empty()) return;
+
+	Vec3 min(Infinity, Infinity, Infinity);
+	Vec3 max(-Infinity, -Infinity, -Infinity);
+	for (const Vec3& vertex : pMesh->GetVertices())
+	{
+		min = Min(min, vertex);
+		max = Max(max, vertex);
+	}
+
+	const auto material = std::find(m_Materials.begin(), m_Materials.end(), pMaterial);
+	const size_t materialIndex = static_cast<size_t>(material - m_Materials.begin());
+	if (material == m_Materials.end()) m_Materials.push_back(std::move(pMaterial));
+
+	const Mat4 modelTransform = entity.GetModelTransform();
+	m_Sources.push_back({ pMesh, modelTransform, materialIndex, modelTransform * Vec4((min + max) * 0.5f) });
+}
+
+void StaticBatch::Build()
+{
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Meshes);
+	m_Chunks.clear();
+
+	for (size_t material = 0; material < m_Materials.size(); material++)
+	{
+		std::vector<const Source*> sources;
+		Vec3 min(Infinity, Infinity, Infinity);
+		Vec3 max(-Infinity, -Infinity, -Infinity);
+		for (const Source& source : m_Sources)
+		{
+			if (source.m_Material != material) continue;
+			sources.push_back(&source);
+			min = Min(min, source.m_Center);
+			max = Max(max, source.m_Center);
+		}
+
+		// Along a Z-order curve neighbours end up in the same chunk, which keeps the chunks' boxes small
+		std::vector<std::pair<uint32_t, const Source*>> ordered;
+		ordered.reserve(sources.size());
+		for (const Source* pSource : sources) ordered.emplace_back(MortonCode(pSource->m_Center, min, max), pSource);
+		std::stable_sort(ordered.begin(), ordered.end(), [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+		std::vector<const Source*> chunk;
+		size_t chunkTriangles = 0u;
+		for (const auto& entry : ordered)
+		{
+			const size_t triangles = entry.second->m_pMesh->GetIndices().size() / 3u;
+			if (!chunk.empty() && chunkTriangles + triangles > m_MaxChunkTriangles)
+			{
+				BuildChunk(chunk);
+				chunk.clear();
+				chunkTriangles = 0u;
+			}
+			chunk.push_back(entry.second);
+			chunkTriangles += triangles;
+		}
+		if (!chunk.empty()) BuildChunk(chunk);
+	}
+}
+
+void StaticBatch::BuildChunk(const std::vector<const Source*>& sources)
+{
+	size_t vertexCount = 0u;
+	size_t indexCount = 0u;
+	for (const Source* pSource : sources)
+	{
+		vertexCount += pSource->m_pMesh->GetVertices().size();
+		indexCount += pSource->m_pMesh->GetIndices().size();
+	}
+
+	std::vector<Vec3> vertices;
+	std::vector<Vec3> normals;
+	std::vector<Vec2> uvCoordinates;
+	std::vector<size_t> indices;
+	vertices.reserve(vertexCount);
+	normals.reserve(vertexCount);
+	uvCoordinates.reserve(vertexCount);
+	indices.reserve(indexCount);
+
+	Chunk chunk;
+	chunk.m_pMaterial = m_Materials[sources.front()->m_Material];
+	chunk.m_Min = Vec3(Infinity, Infinity, Infinity);
+	chunk.m_Max = Vec3(-Infinity, -Infinity, -Infinity);
+	chunk.m_EntityCount = sources.size();
+
+	Vec3Stream localPositions;
+	Vec3Stream localNormals;
+	Vec3Stream worldNormals;
+	std::vector<Vec4> worldPositions;
+	for (const Source* pSource : sources)
+	{
+		const Mesh& mesh = *pSource->m_pMesh;
+		const size_t count = mesh.GetVertices().size();
+		const size_t firstVertex = vertices.size();
+
+		localPositions.Resize(count);
+		localNormals.Resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			localPositions.Set(i, mesh.GetVertices()[i]);
+			localNormals.Set(i, i < mesh.GetNormals().size() ? mesh.GetNormals()[i] : Vec3(0.0f, 0.0f, 1.0f));
+		}
+		worldPositions.resize(count);
+		TransformKernels::TransformPoints(pSource->m_ModelTransform, localPositions, worldPositions.data());
+		TransformKernels::TransformNormals(NormalTransform(pSource->m_ModelTransform), localNormals, worldNormals);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const Vec3 position(worldPositions[i].x, worldPositions[i].y, worldPositions[i].z);
+			vertices.push_back(position);
+			normals.push_back(worldNormals.Get(i));
+			uvCoordinates.push_back(i < mesh.GetUvCoordinates().size() ? mesh.GetUvCoordinates()[i] : Vec2(0.0f, 0.0f));
+			chunk.m_Min = Min(chunk.m_Min, position);
+			chunk.m_Max = Max(chunk.m_Max, position);
+		}
+		for (size_t index : mesh.GetIndices()) indices.push_back(firstVertex + index);
+	}
+
+	chunk.m_pMesh = std::make_shared<Mesh>(std::move(vertices), std::move(normals), std::move(uvCoordinates), std::move(indices));
+	m_Chunks.push_back(std::move(chunk));
+}
+
+void StaticBatch::Clear()
+{
+	m_Materials.clear();
+	m_Sources.clear();
+	m_Chunks.clear();
+}
+
+std::vector<size_t> StaticBatch::GetVisibleChunks(const Mat4& viewProjection, const Vec3& eyePosition) const
+{
+	std::vector<std::pair<float, size_t>> visible;
+	for (size_t i = 0; i < m_Chunks.size(); i++)
+	{
+		if (!IsVisible(m_Chunks[i], viewProjection)) continue;
+
+		// From the eye to the nearest point of the box
+		const Vec3 nearest = Min(Max(eyePosition, m_Chunks[i].m_Min), m_Chunks[i].m_Max);
+		const Vec3 offset = nearest - eyePosition;
+		visible.emplace_back(offset.x * offset.x + offset.y * offset.y + offset.z * offset.z, i);
+	}
+	std::sort(visible.begin(), visible.end());
+
+	std::vector<size_t> indices;
+	indices.reserve(visible.size());
+	for (const auto& entry : visible) indices.push_back(entry.second);
+	return indices;
+}
+
+bool StaticBatch::IsVisible(const Chunk& chunk, const Mat4& viewProjection)
+{
+	Vec4 corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		const Vec3 corner((i & 1) ? chunk.m_Max.x : chunk.m_Min.x, (i & 2) ? chunk.m_Max.y : chunk.m_Min.y, (i & 4) ? chunk.m_Max.z : chunk.m_Min.z);
+		corners[i] = viewProjection * Vec4(corner);
+	}
+
+	// Outside when every corner is beyond the same plane, as GraphicsPipeline culls triangles
+	auto allBeyond = [&corners](auto isBeyond)
+	{
+		return std::all_of(std::begin(corners), std::end(corners), isBeyond);
+	};
+	return !(allBeyond([](const Vec4& v) { return v.z <= -v.w; }) || allBeyond([](const Vec4& v) { return v.z >= v.w; })
+		|| allBeyond([](const Vec4& v) { return v.x <= -v.w; }) || allBeyond([](const Vec4& v) { return v.x >= v.w; })
+		|| allBeyond([](const Vec4& v) { return v.y <= -v.w; }) || allBeyond([](const Vec4& v) { return v.y >= v.w; }));
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Entity.h"
+#include "Mat4.h"
+#include "Mesh.h"
+#include "Texture.h"
+
+// Static entities merged into a few large meshes, built once with the scene. Every mesh is moved to world space by
+// its model transform, entities with the same material are merged, and the geometry of a material is cut into chunks
+// of entities close to each other. A chunk is one bind and one draw with the identity as model transform, and can
+// still be culled as a whole against the view volume. Entities that move after Build have to be batched again.
+// Mostly slower than drawing entity by entity in this pipeline, see the "batch" group of BenchmarkSuite.
+class StaticBatch
+{
+public:
+	// The texture entities are drawn with, as bound by GraphicsPipeline::BindTexture
+	typedef std::shared_ptr<const Texture> Material;
+
+	struct Chunk
+	{
+		Material m_pMaterial;
+		// In world space
+		std::shared_ptr<const Mesh> m_pMesh;
+		// World space box around every vertex of the mesh
+		Vec3 m_Min;
+		Vec3 m_Max;
+		size_t m_EntityCount = 0;
+	};
+
+	// Chunks stop growing at the triangle count, an entity with more triangles gets a chunk of its own
+	explicit StaticBatch(size_t maxChunkTriangles = DefaultMaxChunkTriangles);
+
+	// Batched with the model transform it has now, the mesh is shared until Build
+	void Add(const Entity& entity, Material pMaterial = nullptr);
+	// Merges everything added so far, chunks of the same material are next to each other
+	void Build();
+	void Clear();
+
+	size_t GetEntityCount() const { return m_Sources.size(); }
+	const std::vector<Chunk>& GetChunks() const { return m_Chunks; }
+
+	// False when the chunk's box is entirely outside of the view volume of the transform
+	static bool IsVisible(const Chunk& chunk, const Mat4& viewProjection);
+	// Indices of the chunks in view, nearest to the eye first so that the depth test rejects more of the pixels
+	// of the farther ones
+	std::vector<size_t> GetVisibleChunks(const Mat4& viewProjection, const Vec3& eyePosition) const;
+
+	static constexpr size_t DefaultMaxChunkTriangles = 1024u;
+
+private:
+	struct Source
+	{
+		std::shared_ptr<const Mesh> m_pMesh;
+		Mat4 m_ModelTransform;
+		size_t m_Material;
+		// Of the mesh's box, in world space
+		Vec3 m_Center;
+	};
+
+	void BuildChunk(const std::vector<const Source*>& sources);
+
+	size_t m_MaxChunkTriangles;
+	// In the order they were first added
+	std::vector<Material> m_Materials;
+	std::vector<Source> m_Sources;
+	std::vector<Chunk> m_Chunks;
+};
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <cmath>
+
+#include "StressScene.h"
+#include "Graphics.h"
+#include "StaticBatch.h"
+
+namespace
+{
+	// Sheets start this far from the camera, further ones a little behind each other
+	constexpr float SheetDepth = 2.0f;
+	constexpr float SheetSpacing = 0.01f;
+	// Around the near plane for the crossing triangles
+	constexpr float CrossingNearDepth = 0.095f;
+	constexpr float CrossingFarDepth = 0.105f;
+
+	// Size of a screen pixel at a distance from the camera
+	float WorldPerPixel(float depth)
+	{
+		return 2.0f * depth * std::tan(StressScene::VerticalFov / 2.0f) / Graphics::ScreenHeight;
+	}
+}
+
+StressScene::StressScene(const Settings& settings)
+	:
+	m_Settings(settings)
+{
+	m_Settings.m_TriangleCount = std::max(m_Settings.m_TriangleCount, 1);
+	m_Settings.m_TriangleSize = std::max(m_Settings.m_TriangleSize, 0.01f);
+	m_Settings.m_OverdrawDepth = std::max(m_Settings.m_OverdrawDepth, 1);
+	m_Settings.m_InstanceCount = std::max(m_Settings.m_InstanceCount, 1);
+	m_Settings.m_TextureResolution = std::max(m_Settings.m_TextureResolution, 1);
+	m_Settings.m_NearPlaneCrossingFraction = std::min(std::max(m_Settings.m_NearPlaneCrossingFraction, 0.0f), 1.0f);
+
+	CreateTexture();
+	CreateEntities();
+}
+
+Mat4 StressScene::GetProjection()
+{
+	return Mat4::PerspectiveProjection(NearPlane, FarPlane, VerticalFov, Graphics::AspectRatio);
+}
+
+std::shared_ptr<const Mesh> StressScene::CreateMesh(int triangleCount, float offsetX, float offsetY) const
+{
+	const int crossingCount = static_cast<int>(std::lround(triangleCount * m_Settings.m_NearPlaneCrossingFraction));
+	const int sheetCount = m_Settings.m_OverdrawDepth;
+	const int sheetTriangleCount = triangleCount - crossingCount;
+	const float size = m_Settings.m_TriangleSize;
+	const float tileWidth = m_Columns * size;
+	const float tileHeight = m_Rows * size;
+
+	std::vector<Vec3> vertices;
+	std::vector<Vec3> normals;
+	std::vector<Vec2> uvCoordinates;
+	std::vector<size_t> indices;
+	auto addVertex = [&](float x, float y, float depth)
+	{
+		// Given in pixels from the center of the tile, mapped over it in texture space
+		const float worldPerPixel = WorldPerPixel(depth);
+		vertices.emplace_back((x + offsetX) * worldPerPixel, (y + offsetY) * worldPerPixel, -depth);
+		normals.emplace_back(0.0f, 0.0f, 1.0f);
+		uvCoordinates.emplace_back(x / tileWidth + 0.5f, y / tileHeight + 0.5f);
+		return vertices.size() - 1u;
+	};
+	auto cellCorner = [&](int cell)
+	{
+		return Vec2((cell % m_Columns) * size - tileWidth / 2.0f, tileHeight / 2.0f - (cell / m_Columns) * size);
+	};
+
+	// Back to front, every sheet passes the depth test
+	for (int sheet = sheetCount - 1; sheet >= 0; sheet--)
+	{
+		const float depth = SheetDepth + sheet * SheetSpacing;
+		int remaining = sheetTriangleCount / sheetCount + (sheet < sheetTriangleCount % sheetCount ? 1 : 0);
+		for (int cell = 0; remaining > 0; cell++)
+		{
+			const Vec2 corner = cellCorner(cell);
+			const size_t topLeft = addVertex(corner.x, corner.y, depth);
+			const size_t topRight = addVertex(corner.x + size, corner.y, depth);
+			const size_t bottomLeft = addVertex(corner.x, corner.y - size, depth);
+			indices.insert(indices.end(), { topLeft, topRight, bottomLeft });
+			if (--remaining == 0) break;
+
+			const size_t bottomRight = addVertex(corner.x + size, corner.y - size, depth);
+			indices.insert(indices.end(), { topRight, bottomRight, bottomLeft });
+			remaining--;
+		}
+	}
+
+	// Spread over the cells of the tile, the corner towards the camera is clipped away
+	const int cellCount = m_Columns * m_Rows;
+	for (int i = 0; i < crossingCount; i++)
+	{
+		const Vec2 corner = cellCorner(static_cast<int>(static_cast<long long>(i) * cellCount / crossingCount));
+		const size_t nearCorner = addVertex(corner.x, corner.y, CrossingNearDepth);
+		const size_t right = addVertex(corner.x + size, corner.y, CrossingFarDepth);
+		const size_t below = addVertex(corner.x, corner.y - size, CrossingFarDepth);
+		indices.insert(indices.end(), { nearCorner, right, below });
+	}
+
+	return std::make_shared<const Mesh>(std::move(vertices), std::move(normals), std::move(uvCoordinates), std::move(indices));
+}
+
+void StressScene::CreateTexture()
+{
+	// Checkers of 8 texels over a gradient, so neighbouring samples differ
+	const int resolution = m_Settings.m_TextureResolution;
+	std::vector<unsigned char> data(static_cast<size_t>(resolution) * resolution * 3u);
+	for (int y = 0; y < resolution; y++)
+	{
+		for (int x = 0; x < resolution; x++)
+		{
+			unsigned char* pTexel = &data[(static_cast<size_t>(y) * resolution + x) * 3u];
+			const bool dark = ((x / 8) + (y / 8)) % 2 == 1;
+			pTexel[0] = static_cast<unsigned char>(255 * x / resolution);
+			pTexel[1] = static_cast<unsigned char>(255 * y / resolution);
+			pTexel[2] = dark ? 64u : 224u;
+		}
+	}
+
+	auto pTexture = std::make_shared<Texture>();
+	pTexture->Create(data.data(), resolution, resolution);
+	m_pTexture = std::move(pTexture);
+}
+
+void StressScene::CreateEntities()
+{
+	// Triangles split as evenly as the count allows
+	const int instanceCount = m_Settings.m_InstanceCount;
+	const int maxTriangleCount = std::max((m_Settings.m_TriangleCount + instanceCount - 1) / instanceCount, 1);
+	auto triangleCount = [&](int instance)
+	{
+		return std::max(m_Settings.m_TriangleCount / instanceCount + (instance < m_Settings.m_TriangleCount % instanceCount ? 1 : 0), 1);
+	};
+
+	// Squares of two triangles on a grid about as wide as high, the same for every sheet and every tile
+	const int sheetTriangleCount = maxTriangleCount - static_cast<int>(std::lround(maxTriangleCount * m_Settings.m_NearPlaneCrossingFraction));
+	const int squareCount = std::max((sheetTriangleCount / m_Settings.m_OverdrawDepth + 1) / 2, 1);
+	m_Columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(squareCount))));
+	m_Rows = (squareCount + m_Columns - 1) / m_Columns;
+
+	// Tiles side by side around the center of the screen
+	const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(instanceCount))));
+	const int rows = (instanceCount + columns - 1) / columns;
+	const float tileWidth = m_Columns * m_Settings.m_TriangleSize;
+	const float tileHeight = m_Rows * m_Settings.m_TriangleSize;
+	m_Entities.reserve(instanceCount);
+	for (int i = 0; i < instanceCount; i++)
+	{
+		const float x = ((i % columns) - (columns - 1) / 2.0f) * tileWidth;
+		const float y = ((rows - 1) / 2.0f - (i / columns)) * tileHeight;
+		m_Entities.emplace_back(CreateMesh(triangleCount(i), x, y), Vec3::Zero(), Vec3::Zero());
+	}
+
+	if (m_Settings.m_StaticBatching)
+	{
+		// The chunks are in world space, which is view space here as well
+		StaticBatch batch;
+		for (const Entity& entity : m_Entities) batch.Add(entity, m_pTexture);
+		batch.Build();
+
+		m_Entities.clear();
+		for (const StaticBatch::Chunk& chunk : batch.GetChunks()) m_Entities.emplace_back(chunk.m_pMesh, Vec3::Zero(), Vec3::Zero());
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Entity.h"
+#include "Mat4.h"
+#include "Texture.h"
+
+// Synthetic scene for scaling studies, built in memory with every cost of a frame under its own knob. Every entity
+// is a tile of flat sheets facing a camera at the origin that looks down -z, with a mesh of its own already placed
+// in view space. Sized for that camera, see GetProjection, so triangle sizes hold in pixels.
+class StressScene
+{
+public:
+	struct Settings
+	{
+		// Over all entities
+		int m_TriangleCount = 100000;
+		// Legs of the right triangles in pixels, two of them make a square
+		float m_TriangleSize = 16.0f;
+		// Sheets behind each other covering the same pixels, drawn back to front so every one of them is shaded
+		int m_OverdrawDepth = 1;
+		// Entities the triangles are split into, a draw each, laid out side by side. What doesn't fit on the screen is culled.
+		int m_InstanceCount = 1;
+		// Of the square texture mapped over every entity
+		int m_TextureResolution = 256;
+		// Triangles of the size above reaching from in front of the near plane to behind it, in front of the sheets
+		float m_NearPlaneCrossingFraction = 0.0f;
+		// Entities merged by a StaticBatch, a draw per chunk instead of per entity. Off by default, it's mostly slower.
+		bool m_StaticBatching = false;
+	};
+
+	explicit StressScene(const Settings& settings);
+
+	const Settings& GetSettings() const { return m_Settings; }
+	const std::vector<Entity>& GetEntities() const { return m_Entities; }
+	const std::shared_ptr<const Texture>& GetTexture() const { return m_pTexture; }
+
+	// The camera sits at the origin, the view and the model transforms are the identity
+	static Mat4 GetProjection();
+
+	static constexpr float NearPlane = 0.1f;
+	static constexpr float FarPlane = 100.0f;
+	static constexpr float VerticalFov = 1.5707963f;
+
+private:
+	// Tile centered on a pixel offset from the center of the screen
+	std::shared_ptr<const Mesh> CreateMesh(int triangleCount, float offsetX, float offsetY) const;
+	void CreateTexture();
+	void CreateEntities();
+
+	Settings m_Settings;
+	// Cells of the sheets of every tile, the grid of the entity with the most triangles
+	int m_Columns = 1;
+	int m_Rows = 1;
+
+	std::shared_ptr<const Texture> m_pTexture;
+	std::vector<Entity> m_Entities;
+};
\ No newline at end of file
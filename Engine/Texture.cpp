@@ -0,0 +1,364 @@
+#include <atomic>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+#include "stb_image.h"
+
+#include "Texture.h"
+#include "JobSystem.h"
+#include "AllocationTracker.h"
+
+namespace
+{
+	std::atomic<uint32_t> s_NextId(1u);
+
+	// "TEX" and a version, bumped whenever the layout of any format changes
+	constexpr uint32_t DecodedMagic = 0x01584554u;
+
+	struct DecodedHeader
+	{
+		uint32_t m_Magic;
+		uint32_t m_Format;
+		int32_t m_Width;
+		int32_t m_Height;
+		int32_t m_BlocksPerRow;
+		float m_Psnr;
+		uint64_t m_TexelBytes;
+		uint64_t m_TileCount;
+		uint64_t m_BlockCount;
+	};
+
+	template <class T>
+	bool WriteArray(std::ostream& stream, const std::vector<T>& values)
+	{
+		return static_cast<bool>(stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T)));
+	}
+
+	template <class T>
+	bool ReadArray(std::istream& stream, std::vector<T>& values, uint64_t count)
+	{
+		values.resize(static_cast<size_t>(count));
+		return static_cast<bool>(stream.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(T)));
+	}
+
+	uint16_t QuantizeTo565(const Vec3& color)
+	{
+		auto quantize = [](float value, int maximum)
+		{
+			return static_cast<uint16_t>(std::min(std::max(static_cast<int>(value / 255.0f * maximum + 0.5f), 0), maximum));
+		};
+
+		return static_cast<uint16_t>((quantize(color.x, 31) << 11) | (quantize(color.y, 63) << 5) | quantize(color.z, 31));
+	}
+
+	// Same expansion the sampler does, in 0..255
+	Vec3 ExpandFrom565(uint16_t color)
+	{
+		const int r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+		return Vec3(
+			static_cast<float>((r << 3) | (r >> 2)),
+			static_cast<float>((g << 2) | (g >> 4)),
+			static_cast<float>((b << 3) | (b >> 2)));
+	}
+
+	float SquaredDistance(const Vec3& a, const Vec3& b)
+	{
+		const Vec3 delta = a - b;
+		return Vec3::Dot(delta, delta);
+	}
+
+	// Picks the closest palette entry for every texel, returns the summed squared error
+	float AssignIndices(uint16_t color0, uint16_t color1, const Vec3 (&texels)[16], uint32_t& indices)
+	{
+		const Vec3 endpoint0 = ExpandFrom565(color0);
+		const Vec3 endpoint1 = ExpandFrom565(color1);
+		const Vec3 palette[4] =
+		{
+			endpoint0,
+			endpoint1,
+			(endpoint0 + endpoint0 + endpoint1) * (1.0f / 3.0f),
+			(endpoint1 + endpoint1 + endpoint0) * (1.0f / 3.0f)
+		};
+
+		float error = 0.0f;
+		indices = 0u;
+		for (int i = 0; i < 16; i++)
+		{
+			uint32_t best = 0u;
+			float bestDistance = SquaredDistance(texels[i], palette[0]);
+			for (uint32_t candidate = 1u; candidate < 4u; candidate++)
+			{
+				const float distance = SquaredDistance(texels[i], palette[candidate]);
+				if (distance < bestDistance)
+				{
+					best = candidate;
+					bestDistance = distance;
+				}
+			}
+
+			indices |= best << (2 * i);
+			error += bestDistance;
+		}
+
+		return error;
+	}
+}
+
+void Texture::Load(const std::string& path, Format format, JobSystem* pJobs)
+{
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Textures);
+	Unload();
+
+	int width, height, discard;
+	unsigned char* pData = stbi_load(path.c_str(), &width, &height, &discard, 3);
+	if (pData == nullptr) return;
+
+	Create(pData, width, height, format, pJobs);
+	stbi_image_free(pData);
+}
+
+void Texture::Create(const unsigned char* pData, int width, int height, Format format, JobSystem* pJobs)
+{
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Textures);
+	Unload();
+
+	m_Width = width;
+	m_Height = height;
+	m_Format = format;
+	m_Id = s_NextId++;
+
+	if (format == Format::RGB8)
+	{
+		m_Texels.assign(pData, pData + width * height * 3);
+		m_Psnr = std::numeric_limits<float>::infinity();
+		return;
+	}
+
+	m_BlocksPerRow = (width + 3) / 4;
+	const int blockRows = (height + 3) / 4;
+
+	if (format == Format::RGBX8Tiled)
+	{
+		m_Tiles.resize(static_cast<size_t>(m_BlocksPerRow) * blockRows);
+		for (int y = 0; y < blockRows * 4; y++)
+		{
+			for (int x = 0; x < m_BlocksPerRow * 4; x++)
+			{
+				const unsigned char* pTexel = &pData[(std::min(y, height - 1) * width + std::min(x, width - 1)) * 3];
+				m_Tiles[(y >> 2) * m_BlocksPerRow + (x >> 2)].m_Texels[(y & 3) * 4 + (x & 3)] = pTexel[0] | (pTexel[1] << 8) | (pTexel[2] << 16);
+			}
+		}
+
+		m_Psnr = std::numeric_limits<float>::infinity();
+		return;
+	}
+
+	m_Blocks.resize(static_cast<size_t>(m_BlocksPerRow) * blockRows);
+
+	// Summed per block row, so the result doesn't depend on how the rows were split
+	std::vector<double> rowSquaredErrors(blockRows, 0.0);
+	auto encodeRows = [&](size_t firstRow, size_t lastRow)
+	{
+		for (int blockY = static_cast<int>(firstRow); blockY < static_cast<int>(lastRow); blockY++)
+		{
+			double& squaredError = rowSquaredErrors[blockY];
+			for (int blockX = 0; blockX < m_BlocksPerRow; blockX++)
+			{
+				Vec3 texels[16];
+				for (int i = 0; i < 16; i++)
+				{
+					const int x = std::min(blockX * 4 + i % 4, width - 1);
+					const int y = std::min(blockY * 4 + i / 4, height - 1);
+					const unsigned char* pTexel = &pData[(y * width + x) * 3];
+					texels[i] = Vec3(pTexel[0], pTexel[1], pTexel[2]);
+				}
+
+				const Block block = EncodeBlock(texels);
+				m_Blocks[blockY * m_BlocksPerRow + blockX] = block;
+
+				for (int i = 0; i < 16; i++)
+				{
+					if (blockX * 4 + i % 4 >= width || blockY * 4 + i / 4 >= height) continue;
+					squaredError += SquaredDistance(texels[i], Fetch(blockX * 4 + i % 4, blockY * 4 + i / 4) * 255.0f);
+				}
+			}
+		}
+	};
+
+	if (pJobs != nullptr) pJobs->ParallelFor(0u, static_cast<size_t>(blockRows), BlockRowsPerJob, encodeRows);
+	else encodeRows(0u, static_cast<size_t>(blockRows));
+
+	double squaredError = 0.0;
+	for (const double rowSquaredError : rowSquaredErrors) squaredError += rowSquaredError;
+
+	const double meanSquaredError = squaredError / (3.0 * width * height);
+	m_Psnr = meanSquaredError > 0.0 ?
+		static_cast<float>(10.0 * std::log10(255.0 * 255.0 / meanSquaredError)) :
+		std::numeric_limits<float>::infinity();
+}
+
+bool Texture::WriteDecoded(std::ostream& stream) const
+{
+	const DecodedHeader header =
+	{
+		DecodedMagic,
+		static_cast<uint32_t>(m_Format),
+		m_Width,
+		m_Height,
+		m_BlocksPerRow,
+		m_Psnr,
+		m_Texels.size(),
+		m_Tiles.size(),
+		m_Blocks.size()
+	};
+
+	return
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header)) &&
+		WriteArray(stream, m_Texels) &&
+		WriteArray(stream, m_Tiles) &&
+		WriteArray(stream, m_Blocks);
+}
+
+bool Texture::ReadDecoded(std::istream& stream)
+{
+	AllocationTracker::TagScope tag(AllocationTracker::Tag::Textures);
+	Unload();
+
+	DecodedHeader header;
+	if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.m_Magic != DecodedMagic || header.m_Width <= 0 || header.m_Height <= 0 || header.m_BlocksPerRow < 0)
+		return false;
+
+	// Sizes have to match the dimensions, a damaged file must not make us allocate whatever it says
+	const uint64_t width = static_cast<uint64_t>(header.m_Width);
+	const uint64_t height = static_cast<uint64_t>(header.m_Height);
+	const uint64_t headerBlocksPerRow = static_cast<uint64_t>(header.m_BlocksPerRow);
+	const uint64_t blocksPerRow = (width + 3u) / 4u;
+	const uint64_t blockCount = blocksPerRow * ((height + 3u) / 4u);
+	const Format format = static_cast<Format>(header.m_Format);
+	const bool consistent =
+		(format == Format::RGB8 && header.m_TexelBytes == width * height * 3u && header.m_TileCount == 0u && header.m_BlockCount == 0u) ||
+		(format == Format::RGBX8Tiled && header.m_TexelBytes == 0u && header.m_TileCount == blockCount && header.m_BlockCount == 0u && headerBlocksPerRow == blocksPerRow) ||
+		(format == Format::BC1 && header.m_TexelBytes == 0u && header.m_TileCount == 0u && header.m_BlockCount == blockCount && headerBlocksPerRow == blocksPerRow);
+	if (!consistent) return false;
+
+	if (!ReadArray(stream, m_Texels, header.m_TexelBytes) || !ReadArray(stream, m_Tiles, header.m_TileCount) || !ReadArray(stream, m_Blocks, header.m_BlockCount))
+	{
+		Unload();
+		return false;
+	}
+
+	m_Width = header.m_Width;
+	m_Height = header.m_Height;
+	m_Format = format;
+	m_Id = s_NextId++;
+	m_BlocksPerRow = header.m_BlocksPerRow;
+	m_Psnr = header.m_Psnr;
+	return true;
+}
+
+void Texture::Unload()
+{
+	m_Width = 0;
+	m_Height = 0;
+	m_Texels.clear();
+	m_Texels.shrink_to_fit();
+	m_Tiles.clear();
+	m_Tiles.shrink_to_fit();
+	m_Blocks.clear();
+	m_Blocks.shrink_to_fit();
+	m_BlocksPerRow = 0;
+	m_Psnr = 0.0f;
+}
+
+Texture::Block Texture::EncodeBlock(const Vec3 (&texels)[16])
+{
+	// Endpoints at the extremes of the block's colors along their principal axis
+	Vec3 mean = Vec3::Zero();
+	for (const Vec3& texel : texels) mean += texel;
+	mean /= 16.0f;
+
+	float covariance[6] = {};
+	for (const Vec3& texel : texels)
+	{
+		const Vec3 delta = texel - mean;
+		covariance[0] += delta.x * delta.x;
+		covariance[1] += delta.x * delta.y;
+		covariance[2] += delta.x * delta.z;
+		covariance[3] += delta.y * delta.y;
+		covariance[4] += delta.y * delta.z;
+		covariance[5] += delta.z * delta.z;
+	}
+
+	// Power iteration, a handful of steps is plenty for a 3x3 matrix
+	Vec3 axis(1.0f, 1.0f, 1.0f);
+	for (int i = 0; i < 8; i++)
+	{
+		axis = Vec3(
+			covariance[0] * axis.x + covariance[1] * axis.y + covariance[2] * axis.z,
+			covariance[1] * axis.x + covariance[3] * axis.y + covariance[4] * axis.z,
+			covariance[2] * axis.x + covariance[4] * axis.y + covariance[5] * axis.z);
+
+		const float length = std::sqrt(Vec3::Dot(axis, axis));
+		if (length < 1e-6f) break;
+		axis /= length;
+	}
+
+	float minProjection = 0.0f;
+	float maxProjection = 0.0f;
+	for (const Vec3& texel : texels)
+	{
+		const float projection = Vec3::Dot(texel - mean, axis);
+		minProjection = std::min(minProjection, projection);
+		maxProjection = std::max(maxProjection, projection);
+	}
+
+	Block block;
+	block.m_Color0 = QuantizeTo565(mean + axis * maxProjection);
+	block.m_Color1 = QuantizeTo565(mean + axis * minProjection);
+
+	// The four color mode needs color0 > color1, equal endpoints mean a single color block
+	if (block.m_Color0 < block.m_Color1) std::swap(block.m_Color0, block.m_Color1);
+	if (block.m_Color0 == block.m_Color1)
+	{
+		block.m_Indices = 0u;
+		return block;
+	}
+
+	float error = AssignIndices(block.m_Color0, block.m_Color1, texels, block.m_Indices);
+
+	// One least squares refit of the endpoints to the chosen indices, kept only if it lowers the error
+	static constexpr float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	Vec3 ax = Vec3::Zero();
+	Vec3 bx = Vec3::Zero();
+	for (int i = 0; i < 16; i++)
+	{
+		const float a = weights[(block.m_Indices >> (2 * i)) & 3u];
+		const float b = 1.0f - a;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		ax += texels[i] * a;
+		bx += texels[i] * b;
+	}
+
+	const float determinant = aa * bb - ab * ab;
+	if (std::abs(determinant) > 1e-6f)
+	{
+		Block refined;
+		refined.m_Color0 = QuantizeTo565((ax * bb - bx * ab) / determinant);
+		refined.m_Color1 = QuantizeTo565((bx * aa - ax * ab) / determinant);
+		if (refined.m_Color0 < refined.m_Color1) std::swap(refined.m_Color0, refined.m_Color1);
+
+		if (refined.m_Color0 != refined.m_Color1)
+		{
+			const float refinedError = AssignIndices(refined.m_Color0, refined.m_Color1, texels, refined.m_Indices);
+			if (refinedError < error) block = refined;
+		}
+	}
+
+	return block;
+}
\ No newline at end of file
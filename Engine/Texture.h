@@ -0,0 +1,249 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "Simd.h"
+#include "Vec2.h"
+#include "Vec3.h"
+
+#if ENGINE_SIMD_SSE
+	#include <emmintrin.h>
+#endif
+
+class JobSystem;
+
+// RGB texture sampled with nearest filtering, either as loaded, rearranged into tiles or compressed at load time.
+// Compressed textures are decoded texel by texel while sampling, the full image is never expanded in memory.
+class Texture
+{
+public:
+	enum class Format
+	{
+		// 3 bytes per texel in rows, as loaded
+		RGB8,
+		// 4 bytes per texel in 4x4 tiles, a tile is exactly one cache line, so every texel near a fetched one
+		// (in any direction, not just along the row) is likely already in the cache
+		RGBX8Tiled,
+		// BC1 layout: 4x4 blocks of two RGB565 endpoints and 2 bit palette indices, 8 bytes per block (half a byte per texel)
+		BC1
+	};
+
+	// Leaves the texture unloaded when the file can't be read.
+	// With a job system, block compression is split into rows of blocks that run in parallel.
+	void Load(const std::string& path, Format format = Format::RGB8, JobSystem* pJobs = nullptr);
+	// From width * height RGB texels in rows, top row first
+	void Create(const unsigned char* pData, int width, int height, Format format = Format::RGB8, JobSystem* pJobs = nullptr);
+	void Unload();
+
+	// Storage exactly as sampled (tiled or compressed), so reading it back skips decoding and compression.
+	// Read leaves the texture unloaded when the stream doesn't hold a texture written by this version.
+	bool WriteDecoded(std::ostream& stream) const;
+	bool ReadDecoded(std::istream& stream);
+
+	bool IsLoaded() const { return m_Width > 0; }
+	int GetWidth() const { return m_Width; }
+	int GetHeight() const { return m_Height; }
+	Format GetFormat() const { return m_Format; }
+
+	// Bytes of texel storage
+	size_t GetMemoryBytes() const { return m_Texels.size() + m_Tiles.size() * sizeof(Tile) + m_Blocks.size() * sizeof(Block); }
+	// Quality of the compressed texels against the loaded ones, infinite for RGB8
+	float GetPsnr() const { return m_Psnr; }
+
+	// Compressed textures can keep the last few decoded blocks of every thread around, neighbouring pixels mostly hit the same block.
+	// Off by default, expanding one palette entry costs about as much as a cache hit.
+	void SetBlockCacheEnabled(bool enabled) { m_BlockCacheEnabled = enabled; }
+	bool IsBlockCacheEnabled() const { return m_BlockCacheEnabled; }
+
+	// v points up, coordinates outside [0, 1] are clamped to the edge texels
+	Vec3 Sample(const Vec2& uvCoordinates) const
+	{
+		const int x = std::min(std::max(static_cast<int>(uvCoordinates.x * m_Width), 0), m_Width - 1);
+		const int y = std::min(std::max(static_cast<int>((1.0f - uvCoordinates.y) * m_Height), 0), m_Height - 1);
+
+		if (m_Format == Format::RGBX8Tiled)
+		{
+			const uint32_t texel = m_Tiles[(y >> 2) * m_BlocksPerRow + (x >> 2)].m_Texels[(y & 3) * 4 + (x & 3)];
+			return Vec3((texel & 0xFFu) / 255.0f, ((texel >> 8) & 0xFFu) / 255.0f, ((texel >> 16) & 0xFFu) / 255.0f);
+		}
+		if (m_Format == Format::BC1)
+		{
+			return m_BlockCacheEnabled ? FetchCached(x, y) : Fetch(x, y);
+		}
+
+		const unsigned char* pTexel = &m_Texels[(y * m_Width + x) * 3];
+		return Vec3(pTexel[0] / 255.0f, pTexel[1] / 255.0f, pTexel[2] / 255.0f);
+	}
+
+private:
+	// Texels of the tile in rows, red in the lowest byte
+	struct alignas(64) Tile
+	{
+		uint32_t m_Texels[16];
+	};
+
+	struct Block
+	{
+		uint16_t m_Color0;
+		uint16_t m_Color1;
+		// Texel (x, y) of the block uses bits 2 * (y * 4 + x)
+		uint32_t m_Indices;
+	};
+
+	// The four colors a block can pick from, as floats in [0, 1] (the fourth lane is unused)
+	struct Palette
+	{
+		alignas(16) float m_Colors[4][4];
+	};
+
+	// Zero initialized, which is never a valid key since ids start at 1
+	struct CachedBlock
+	{
+		uint64_t m_Key;
+		uint32_t m_Indices;
+		Palette m_Palette;
+	};
+
+	static constexpr int BlockCacheSize = 16;
+
+	// Weights of color0 and color1 for every palette index, with the 8 bit to [0, 1] scale folded in
+	static constexpr float PaletteWeights[4][2] =
+	{
+		{ 1.0f / 255.0f, 0.0f },
+		{ 0.0f, 1.0f / 255.0f },
+		{ 2.0f / 3.0f / 255.0f, 1.0f / 3.0f / 255.0f },
+		{ 1.0f / 3.0f / 255.0f, 2.0f / 3.0f / 255.0f }
+	};
+
+	static int GetPaletteIndex(uint32_t indices, int x, int y) { return (indices >> (2 * ((y & 3) * 4 + (x & 3)))) & 3u; }
+
+#if ENGINE_SIMD_SSE
+	// Both endpoints in 8 bits per channel, as the 32 bit float lanes r g b 0
+	static void ExpandEndpoints(const Block& block, __m128& color0, __m128& color1)
+	{
+		// Lanes c0 c0 c0 c0 c1 c1 c1 c1, every channel masked out and moved to the top bits, then the usual bit
+		// replication (c << 3 | c >> 2 for 5 bits, c << 2 | c >> 4 for 6 bits) as one multiply keeping the high half
+		const __m128i colors = _mm_cvtsi32_si128(block.m_Color0 | (block.m_Color1 << 16));
+		const __m128i pairs = _mm_unpacklo_epi16(colors, colors);
+		const __m128i lanes = _mm_unpacklo_epi32(pairs, pairs);
+
+		const __m128i masks = _mm_setr_epi16(static_cast<short>(0xF800), 0x07E0, 0x001F, 0, static_cast<short>(0xF800), 0x07E0, 0x001F, 0);
+		const __m128i channels = _mm_mullo_epi16(_mm_and_si128(lanes, masks), _mm_setr_epi16(1, 1, 2048, 0, 1, 1, 2048, 0));
+		const __m128i expanded = _mm_mulhi_epu16(channels, _mm_setr_epi16(264, 8320, 264, 0, 264, 8320, 264, 0));
+
+		color0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(expanded, _mm_setzero_si128()));
+		color1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(expanded, _mm_setzero_si128()));
+	}
+
+	static __m128 Blend(__m128 color0, __m128 color1, int index)
+	{
+		return _mm_add_ps(_mm_mul_ps(color0, _mm_set1_ps(PaletteWeights[index][0])), _mm_mul_ps(color1, _mm_set1_ps(PaletteWeights[index][1])));
+	}
+#else
+	static void ExpandEndpoints(const Block& block, Vec3& color0, Vec3& color1)
+	{
+		auto expand = [](uint16_t color)
+		{
+			const int r = color >> 11, g = (color >> 5) & 63, b = color & 31;
+			return Vec3(
+				static_cast<float>((r << 3) | (r >> 2)),
+				static_cast<float>((g << 2) | (g >> 4)),
+				static_cast<float>((b << 3) | (b >> 2)));
+		};
+		color0 = expand(block.m_Color0);
+		color1 = expand(block.m_Color1);
+	}
+
+	static Vec3 Blend(const Vec3& color0, const Vec3& color1, int index)
+	{
+		return color0 * PaletteWeights[index][0] + color1 * PaletteWeights[index][1];
+	}
+#endif
+
+	static Palette DecodePalette(const Block& block)
+	{
+		Palette palette;
+#if ENGINE_SIMD_SSE
+		__m128 color0, color1;
+		ExpandEndpoints(block, color0, color1);
+		for (int i = 0; i < 4; i++) _mm_store_ps(palette.m_Colors[i], Blend(color0, color1, i));
+#else
+		Vec3 color0, color1;
+		ExpandEndpoints(block, color0, color1);
+		for (int i = 0; i < 4; i++)
+		{
+			const Vec3 color = Blend(color0, color1, i);
+			palette.m_Colors[i][0] = color.x;
+			palette.m_Colors[i][1] = color.y;
+			palette.m_Colors[i][2] = color.z;
+		}
+#endif
+		return palette;
+	}
+
+	const Block& GetBlock(int x, int y) const { return m_Blocks[(y >> 2) * m_BlocksPerRow + (x >> 2)]; }
+
+	// Expands only the palette entry the texel uses
+	Vec3 Fetch(int x, int y) const
+	{
+		const Block& block = GetBlock(x, y);
+		const int index = GetPaletteIndex(block.m_Indices, x, y);
+#if ENGINE_SIMD_SSE
+		__m128 color0, color1;
+		ExpandEndpoints(block, color0, color1);
+
+		alignas(16) float color[4];
+		_mm_store_ps(color, Blend(color0, color1, index));
+		return Vec3(color[0], color[1], color[2]);
+#else
+		Vec3 color0, color1;
+		ExpandEndpoints(block, color0, color1);
+		return Blend(color0, color1, index);
+#endif
+	}
+
+	Vec3 FetchCached(int x, int y) const
+	{
+		// Direct mapped on the low bits of the block coordinates, so any 4x4 neighbourhood of blocks fits at once
+		thread_local CachedBlock s_Cache[BlockCacheSize];
+
+		const uint32_t blockX = static_cast<uint32_t>(x) >> 2;
+		const uint32_t blockY = static_cast<uint32_t>(y) >> 2;
+		const uint64_t key = (static_cast<uint64_t>(m_Id) << 32) | (blockY * m_BlocksPerRow + blockX);
+		CachedBlock& entry = s_Cache[(blockX & 3u) | ((blockY & 3u) << 2)];
+
+		if (entry.m_Key != key)
+		{
+			const Block& block = m_Blocks[blockY * m_BlocksPerRow + blockX];
+			entry.m_Key = key;
+			entry.m_Indices = block.m_Indices;
+			entry.m_Palette = DecodePalette(block);
+		}
+
+		const float* pColor = entry.m_Palette.m_Colors[GetPaletteIndex(entry.m_Indices, x, y)];
+		return Vec3(pColor[0], pColor[1], pColor[2]);
+	}
+
+	static Block EncodeBlock(const Vec3 (&texels)[16]);
+
+	static constexpr size_t BlockRowsPerJob = 4u;
+
+	int m_Width = 0;
+	int m_Height = 0;
+	Format m_Format = Format::RGB8;
+	// Unique for every load, keys the decoded block cache
+	uint32_t m_Id = 0;
+
+	std::vector<unsigned char> m_Texels;
+	std::vector<Tile> m_Tiles;
+	std::vector<Block> m_Blocks;
+	// Tiles and blocks are both 4x4 texels, the ones hanging over the right or bottom edge repeat the edge texels
+	int m_BlocksPerRow = 0;
+
+	float m_Psnr = 0.0f;
+	bool m_BlockCacheEnabled = false;
+};
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "TextureBenchmark.h"
+#include "Benchmarking.h"
+#include "Texture.h"
+
+std::string TextureBenchmark::Run(const std::string& path, int samplesPerSide, int repetitions)
+{
+	using namespace Benchmarking;
+
+	std::ostringstream report;
+
+	Texture uncompressed;
+	Texture tiled;
+	Texture compressed;
+	uncompressed.Load(path, Texture::Format::RGB8);
+	tiled.Load(path, Texture::Format::RGBX8Tiled);
+	compressed.Load(path, Texture::Format::BC1);
+	if (!uncompressed.IsLoaded())
+	{
+		report << "Texture benchmark: can't load " << path << "\n";
+		return report.str();
+	}
+
+	report << "Texture benchmark, " << path << " " << uncompressed.GetWidth() << "x" << uncompressed.GetHeight()
+		<< ", " << samplesPerSide << "x" << samplesPerSide << " samples, best of " << repetitions << " runs\n"
+		<< "  RGB8 " << uncompressed.GetMemoryBytes() / 1024 << " KiB, RGBX8 tiled " << tiled.GetMemoryBytes() / 1024 << " KiB, BC1 " << compressed.GetMemoryBytes() / 1024 << " KiB"
+		<< " (x" << static_cast<double>(uncompressed.GetMemoryBytes()) / compressed.GetMemoryBytes() << " smaller), "
+		<< "BC1 PSNR " << compressed.GetPsnr() << " dB\n";
+
+	// Texture coordinates in the order a rasterizer would fetch them, one texel per pixel,
+	// pixels either row by row or in 4x4 blocks like PixelTraversal::Blocks (samplesPerSide is a multiple of 4)
+	const int sampleCount = samplesPerSide * samplesPerSide;
+	auto makeGrid = [&](float angle, int blockSize)
+	{
+		std::vector<Vec2> coordinates;
+		coordinates.reserve(sampleCount);
+		const float cosAngle = std::cos(angle) / uncompressed.GetWidth();
+		const float sinAngle = std::sin(angle) / uncompressed.GetHeight();
+		for (int bandY = 0; bandY < samplesPerSide; bandY += blockSize)
+		{
+			for (int blockX = 0; blockX < samplesPerSide; blockX += (blockSize == 1 ? samplesPerSide : blockSize))
+			{
+				for (int y = bandY; y < bandY + blockSize; y++)
+				{
+					for (int x = blockX; x < (blockSize == 1 ? samplesPerSide : blockX + blockSize); x++)
+					{
+						const float u = 0.5f + (x - samplesPerSide / 2) * cosAngle - (y - samplesPerSide / 2) * sinAngle;
+						const float v = 0.5f + (x - samplesPerSide / 2) * sinAngle + (y - samplesPerSide / 2) * cosAngle;
+						coordinates.emplace_back(u - std::floor(u), v - std::floor(v));
+					}
+				}
+			}
+		}
+		return coordinates;
+	};
+
+	std::vector<Vec2> randomCoordinates;
+	std::mt19937 random(1234u);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	for (int i = 0; i < sampleCount; i++) randomCoordinates.emplace_back(distribution(random), distribution(random));
+
+	const struct
+	{
+		const char* m_Name;
+		std::vector<Vec2> m_Coordinates;
+	} patterns[] =
+	{
+		{ "aligned", makeGrid(0.0f, 1) },
+		{ "rotated 30 deg", makeGrid(0.5236f, 1) },
+		{ "rotated 4x4", makeGrid(0.5236f, 4) },
+		{ "random", randomCoordinates }
+	};
+
+	for (const auto& pattern : patterns)
+	{
+		auto measure = [&](const Texture& texture)
+		{
+			return MeasureNanoseconds(repetitions, sampleCount, [&]()
+			{
+				Vec3 sum = Vec3::Zero();
+				for (const Vec2& coordinates : pattern.m_Coordinates) sum += texture.Sample(coordinates);
+				s_Sink = sum.x;
+			});
+		};
+
+		const double rgb = measure(uncompressed);
+		const double rgbxTiled = measure(tiled);
+		compressed.SetBlockCacheEnabled(false);
+		const double direct = measure(compressed);
+		compressed.SetBlockCacheEnabled(true);
+		const double cached = measure(compressed);
+
+		ReportLine(report, (std::string(pattern.m_Name) + " RGB8").c_str(), rgb, rgb);
+		ReportLine(report, (std::string(pattern.m_Name) + " RGBX8 tiled").c_str(), rgbxTiled, rgb);
+		ReportLine(report, (std::string(pattern.m_Name) + " BC1").c_str(), direct, rgb);
+		ReportLine(report, (std::string(pattern.m_Name) + " BC1 block cache").c_str(), cached, rgb);
+	}
+
+	return report.str();
+}
\ No newline at end of file
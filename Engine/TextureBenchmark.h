@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+// Compares row major, tiled and block compressed storage of a texture.
+// Reports memory and PSNR of every format, then the nanoseconds per sample for screen aligned,
+// rotated (in row and in 4x4 block order) and random access, the compressed format with and without the decoded block cache.
+class TextureBenchmark
+{
+public:
+	static std::string Run(const std::string& path, int samplesPerSide = 512, int repetitions = 10);
+};
\ No newline at end of file
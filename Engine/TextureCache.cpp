@@ -0,0 +1,82 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "TextureCache.h"
+
+namespace
+{
+	// FNV-1a, 64 bit
+	uint64_t HashBytes(const std::vector<char>& bytes, uint64_t hash = 14695981039346656037ull)
+	{
+		for (const char byte : bytes)
+		{
+			hash = (hash ^ static_cast<unsigned char>(byte)) * 1099511628211ull;
+		}
+
+		return hash;
+	}
+}
+
+TextureCache::TextureCache(std::string directory)
+	:
+	m_Directory(std::move(directory))
+{
+}
+
+bool TextureCache::Load(const std::string& path, Texture::Format format, Texture& texture, JobSystem* pJobs)
+{
+	const std::string entryPath = GetEntryPath(path, format);
+	if (entryPath.empty())
+	{
+		texture.Unload();
+		return false;
+	}
+
+	std::ifstream entry(entryPath, std::ios::binary);
+	if (entry && texture.ReadDecoded(entry))
+	{
+		m_Hits++;
+		return true;
+	}
+
+	m_Misses++;
+	texture.Load(path, format, pJobs);
+	if (texture.IsLoaded()) Store(entryPath, texture);
+
+	return false;
+}
+
+std::string TextureCache::GetEntryPath(const std::string& path, Texture::Format format) const
+{
+	std::ifstream source(path, std::ios::binary | std::ios::ate);
+	if (!source) return std::string();
+
+	std::vector<char> bytes(static_cast<size_t>(source.tellg()));
+	if (!source.seekg(0).read(bytes.data(), bytes.size())) return std::string();
+	const uint64_t hash = HashBytes(bytes);
+
+	std::ostringstream entryPath;
+	entryPath << m_Directory << "/" << std::hex << std::setfill('0') << std::setw(16) << hash << "_" << static_cast<int>(format) << ".tex";
+	return entryPath.str();
+}
+
+void TextureCache::Store(const std::string& entryPath, const Texture& texture) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(m_Directory, error);
+
+	// Written under a name of its own and renamed when complete, so no thread or later run ever reads a partial entry
+	std::ostringstream temporaryPath;
+	temporaryPath << entryPath << "." << std::this_thread::get_id() << ".tmp";
+	std::ofstream entry(temporaryPath.str(), std::ios::binary | std::ios::trunc);
+	const bool written = entry && texture.WriteDecoded(entry);
+	entry.close();
+
+	if (written) std::filesystem::rename(temporaryPath.str(), entryPath, error);
+	if (!written || error) std::filesystem::remove(temporaryPath.str(), error);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "Texture.h"
+
+// Decoded textures kept on disk between runs, one file per source and format.
+// Entries are named after a hash of the source file's bytes, so an edited source never hits a stale entry,
+// and hold the texture's storage exactly as sampled: loading one is a single read, without image decoding
+// or block compression. Safe to use from several loading threads at once.
+class TextureCache
+{
+public:
+	struct Stats
+	{
+		size_t m_Hits = 0;
+		size_t m_Misses = 0;
+	};
+
+	// The directory is created with the first entry
+	explicit TextureCache(std::string directory);
+
+	// Fills the texture from its entry, or decodes the source and stores an entry for next time.
+	// Returns whether the entry was used, the texture is left unloaded when the source can't be read.
+	bool Load(const std::string& path, Texture::Format format, Texture& texture, JobSystem* pJobs = nullptr);
+
+	const std::string& GetDirectory() const { return m_Directory; }
+	Stats GetStats() const { return { m_Hits.load(), m_Misses.load() }; }
+
+private:
+	// Empty when the source can't be read
+	std::string GetEntryPath(const std::string& path, Texture::Format format) const;
+	void Store(const std::string& entryPath, const Texture& texture) const;
+
+	std::string m_Directory;
+
+	std::atomic<size_t> m_Hits{ 0u };
+	std::atomic<size_t> m_Misses{ 0u };
+};
\ No newline at end of file
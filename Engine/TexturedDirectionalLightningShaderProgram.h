@@ -1,12 +1,19 @@
 #pragma once
 
+#include <cassert>
+#include <type_traits>
+#include <vector>
+
 #include "Vec3.h"
 #include "Mat4.h"
 #include "Colors.h"
+#include "ShadowMap.h"
+#include "TransformKernels.h"
+#include "Varyings.h"
 
-class TexturedDirectionalLightningShaderProgram
+// Types shared by every variant of the textured lightning program
+struct TexturedLightningShaderProgramTypes
 {
-public:
 	struct VSIn
 	{
 		Vec3 m_Position;
@@ -22,72 +29,67 @@ public:
 		}
 	};
 
-	struct VSOut
+	// The pipeline only ever reads the color back
+	struct PSOut
 	{
-		Vec4 m_Position;
-		Vec3 m_WorldPosition;
-		Vec3 m_Normal;
-		Vec2 m_UvCoordinates;
-		Vec3 m_Color;
+		Color m_Color;
+	};
 
-		VSOut(Vec4 position, Vec3 worldPosition, Vec3 normal, Vec2 uvCoordinates)
-			:
-			m_Position(position),
-			m_WorldPosition(worldPosition),
-			m_Normal(normal),
-			m_UvCoordinates(uvCoordinates)
+	// All vectors are in view space, the same space the vertex shader outputs normals and positions in
+	struct Light
+	{
+		enum class Type
 		{
-		}
+			Directional,
+			Spot
+		};
 
-		friend VSOut operator+(const VSOut& lhs, const VSOut& rhs)
-		{
-			return
-			{
-				lhs.m_Position + rhs.m_Position,
-				lhs.m_WorldPosition + rhs.m_WorldPosition,
-				lhs.m_Normal + rhs.m_Normal,
-				lhs.m_UvCoordinates + rhs.m_UvCoordinates
-			};
-		}
-		VSOut& operator+=(const VSOut& rhs) { return *this = *this + rhs; }
+		Type m_Type;
+		Vec3 m_Position;
+		Vec3 m_Direction;
+		float m_CosCutoff;
+
+		const ShadowMap* m_pShadowMap;
+		Mat4 m_ViewToLightClip;
 
-		friend VSOut operator-(const VSOut& lhs, const VSOut& rhs)
+		// direction points from the surface towards the light
+		static Light Directional(const Vec3& direction, const ShadowMap* pShadowMap = nullptr, const Mat4& viewToLightClip = Mat4::Identity())
 		{
-			return
-			{
-				lhs.m_Position - rhs.m_Position,
-				lhs.m_WorldPosition + rhs.m_WorldPosition,
-				lhs.m_Normal - rhs.m_Normal,
-				lhs.m_UvCoordinates - rhs.m_UvCoordinates
-			};
+			return { Type::Directional, Vec3::Zero(), Vec3::Normalize(direction), -1.0f, pShadowMap, viewToLightClip };
 		}
-		VSOut& operator-=(const VSOut& rhs) { return *this = *this - rhs; }
 
-		template <typename T> friend VSOut operator*(const VSOut& lhs, T rhs)
+		// direction is the cone axis, pointing away from the light
+		static Light Spot(const Vec3& position, const Vec3& direction, float coneAngle, const ShadowMap* pShadowMap = nullptr, const Mat4& viewToLightClip = Mat4::Identity())
 		{
-			return
-			{
-				lhs.m_Position * rhs,
-				lhs.m_WorldPosition + rhs,
-				lhs.m_Normal * rhs,
-				lhs.m_UvCoordinates * rhs
-			};
+			return { Type::Spot, position, Vec3::Normalize(direction), std::cos(coneAngle / 2.0f), pShadowMap, viewToLightClip };
 		}
-		template <typename T> friend VSOut operator*(T lhs, const VSOut& rhs) { return rhs * lhs; }
-		template <typename T> VSOut& operator*=(T rhs) { return *this = *this * rhs; }
-
-		template <typename T> friend VSOut operator/(const VSOut& lhs, T rhs) { return lhs * (1.0f / rhs); }
-		template <typename T> VSOut& operator/=(T rhs) { return *this = *this / rhs; }
 
-		template <typename T> static VSOut Lerp(VSOut v1, VSOut v2, T t) { return v1 + (v2 - v1) * t; }
+		// Spot cones and shadow lookups start from the position of the fragment
+		bool NeedsFragmentPosition() const { return m_Type == Type::Spot || m_pShadowMap != nullptr; }
 	};
+};
+
+// Textured program lit by directional and spot lights.
+// Only with TPositionalLighting does the pixel shader read the view space position of a fragment (spot lights
+// and shadow lookups), without it that varying is left out of VSOut and never interpolated.
+template <bool TPositionalLighting>
+class BasicTexturedDirectionalLightningShaderProgram : public TexturedLightningShaderProgramTypes
+{
+public:
+	static constexpr bool WritesColor = true;
+	static constexpr bool BatchesVertices = true;
+	static constexpr bool RecordsHeatmap = false;
+
+	typedef std::conditional_t<TPositionalLighting,
+		VaryingVertex<Varying::ViewPosition, Varying::Normal, Varying::UvCoordinates>,
+		VaryingVertex<Varying::Normal, Varying::UvCoordinates>> VSOut;
 
 	class VertexShader
 	{
 	public:
 		VSOut Main(const VSIn& vIn)
 		{
-			return VSOut
+			return MakeOutput
 			(
 				m_MVP * vIn.m_Position,
 				m_MV * vIn.m_Position,
@@ -96,6 +98,47 @@ public:
 			);
 		}
 
+		// Same as Main for count vertices, with all the matrix work done by one batched kernel call.
+		// Several threads may shade different ranges at once.
+		void MainBatch(const VSIn* pVertices, size_t count, VSOut* pOutputs)
+		{
+			BatchScratch& scratch = GetBatchScratch();
+
+			scratch.m_Positions.Resize(count);
+			scratch.m_Normals.Resize(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				scratch.m_Positions.Set(i, pVertices[i].m_Position);
+				scratch.m_Normals.Set(i, pVertices[i].m_Normal);
+			}
+
+			scratch.m_ClipPositions.resize(count);
+			scratch.m_ViewPositions.resize(TPositionalLighting ? count : 0u);
+			TransformKernels::TransformVertices(m_MVP, m_MV, scratch.m_Positions, scratch.m_Normals,
+				scratch.m_ClipPositions.data(), TPositionalLighting ? scratch.m_ViewPositions.data() : nullptr, scratch.m_ViewNormals);
+
+			for (size_t i = 0; i < count; i++)
+			{
+				pOutputs[i] = MakeOutput(scratch.m_ClipPositions[i], TPositionalLighting ? scratch.m_ViewPositions[i] : Vec4(), scratch.m_ViewNormals.Get(i), pVertices[i].m_UvCoordinates);
+			}
+		}
+
+		// Everything a draw sets, recorded by value in command buffers
+		struct Constants
+		{
+			Mat4 m_MVP;
+			Mat4 m_MV;
+			Mat4 m_P;
+		};
+
+		void SetConstants(const Constants& constants)
+		{
+			m_MVP = constants.m_MVP;
+			m_MV = constants.m_MV;
+			m_P = constants.m_P;
+		}
+		Constants GetConstants() const { return { m_MVP, m_MV, m_P }; }
+
 		void SetMVP(const Mat4& value) { m_MVP = value; }
 		void SetMV(const Mat4& value) { m_MV = value; }
 		void SetP(const Mat4& value) { m_P = value; }
@@ -103,39 +146,63 @@ public:
 		Mat4 GetP() { return m_P; }
 
 	private:
+		static VSOut MakeOutput(const Vec4& position, const Vec3& viewPosition, const Vec3& normal, const Vec2& uvCoordinates)
+		{
+			VSOut output(position);
+			SetVarying<Varying::ViewPosition>(output, viewPosition);
+			SetVarying<Varying::Normal>(output, normal);
+			SetVarying<Varying::UvCoordinates>(output, uvCoordinates);
+
+			return output;
+		}
+
+		// Streams MainBatch fills and transforms
+		struct BatchScratch
+		{
+			Vec3Stream m_Positions;
+			Vec3Stream m_Normals;
+			Vec3Stream m_ViewNormals;
+			std::vector<Vec4> m_ClipPositions;
+			std::vector<Vec4> m_ViewPositions;
+		};
+
+		// One per thread, kept around so the memory is reused between draws
+		static BatchScratch& GetBatchScratch()
+		{
+			thread_local BatchScratch s_Scratch;
+			return s_Scratch;
+		}
+
 		Mat4 m_MVP;
 		Mat4 m_MV;
 		Mat4 m_P;
 	};
 
-	struct PSOut
-	{
-		Vei2 m_Position;
-		Vec2 m_UvCoordinates;
-		float z;
-
-		Color m_Color;
-	};
-
 	class PixelShader
 	{
 	public:
-		PSOut Main(const VSOut& fragment)
+		void AddLight(const Light& light)
+		{
+			assert((TPositionalLighting || !light.NeedsFragmentPosition()) && "Spot lights and shadows need the positional lighting program");
+			m_Lights.push_back(light);
+		}
+		void ClearLights() { m_Lights.clear(); }
+
+		PSOut Main(const VSOut& fragment, const Vec3& textureColor)
 		{
-			Vec3 lightDirection = Vec3(0.0f, 0.0f, 1.0f);
 			float ambientLightning = 0.15f;
 
-			auto lightFactor = std::max(Vec3::Dot(lightDirection, fragment.m_Normal), ambientLightning);
-			Vec3 resultColor = lightFactor * fragment.m_Color;
+			float diffuseLightning = 0.0f;
+			for (const auto& light : m_Lights)
+			{
+				diffuseLightning += Diffuse(light, fragment);
+			}
+
+			auto lightFactor = std::min(std::max(diffuseLightning, ambientLightning), 1.0f);
+			Vec3 resultColor = lightFactor * textureColor;
 
 			return
 			{
-				{
-					static_cast<int>(fragment.m_Position.x),
-					static_cast<int>(fragment.m_Position.y)
-				},
-				fragment.m_UvCoordinates,
-				fragment.m_Position.z,
 				Color
 				(
 					static_cast<unsigned char>(resultColor.x * 255),
@@ -144,5 +211,43 @@ public:
 				)
 			};
 		}
+
+	private:
+		float Diffuse(const Light& light, const VSOut& fragment) const
+		{
+			const Vec3& normal = GetVarying<Varying::Normal>(fragment);
+
+			if constexpr (TPositionalLighting)
+			{
+				const Vec3& viewPosition = GetVarying<Varying::ViewPosition>(fragment);
+
+				Vec3 toLight = light.m_Direction;
+				if (light.m_Type == Light::Type::Spot)
+				{
+					toLight = Vec3::Normalize(light.m_Position - viewPosition);
+					if (Vec3::Dot(-toLight, light.m_Direction) < light.m_CosCutoff) return 0.0f;
+				}
+
+				auto diffuse = Vec3::Dot(toLight, normal);
+
+				// Faces turned away from the light are dark anyway, so only lit ones pay for the shadow lookup
+				if (diffuse > 0.0f && light.m_pShadowMap != nullptr)
+				{
+					diffuse *= light.m_pShadowMap->SampleVisibility(light.m_ViewToLightClip * Vec4(viewPosition));
+				}
+
+				return std::max(diffuse, 0.0f);
+			}
+			else
+			{
+				return std::max(Vec3::Dot(light.m_Direction, normal), 0.0f);
+			}
+		}
+
+		std::vector<Light> m_Lights = { Light::Directional(Vec3(0.0f, 0.0f, 1.0f)) };
 	};
-};
\ No newline at end of file
+};
+
+typedef BasicTexturedDirectionalLightningShaderProgram<true> TexturedDirectionalLightningShaderProgram;
+// Directional lights without shadows only, one varying less to interpolate per pixel
+typedef BasicTexturedDirectionalLightningShaderProgram<false> UnshadowedTexturedDirectionalLightningShaderProgram;
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threadCount)
+{
+	for (int i = 0; i < std::max(threadCount, 1); i++)
+	{
+		m_Threads.emplace_back(&ThreadPool::Work, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_TaskAvailable.notify_all();
+
+	for (std::thread& thread : m_Threads) thread.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Tasks.push_back(std::move(task));
+	}
+	m_TaskAvailable.notify_one();
+}
+
+int ThreadPool::DefaultThreadCount()
+{
+	return std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+}
+
+void ThreadPool::Work()
+{
+	while (true)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_TaskAvailable.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+
+			// Stopping only ends the loop once the queue is drained
+			if (m_Tasks.empty()) return;
+
+			task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+		}
+
+		task();
+	}
+}
\ No newline at end of file
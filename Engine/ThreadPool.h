@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running submitted tasks in submission order.
+// The destructor runs whatever is still queued before joining, so tasks may rely on their owner outliving them.
+class ThreadPool
+{
+public:
+	// One thread per core besides the calling one, at least one
+	explicit ThreadPool(int threadCount = DefaultThreadCount());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void Submit(std::function<void()> task);
+
+	int GetThreadCount() const { return static_cast<int>(m_Threads.size()); }
+
+	static int DefaultThreadCount();
+
+private:
+	void Work();
+
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_TaskAvailable;
+	std::deque<std::function<void()>> m_Tasks;
+	bool m_Stopping = false;
+};
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include <cassert>
+#include <cmath>
+
+#include "TransformKernels.h"
+
+#if ENGINE_SIMD_SSE
+	#include <immintrin.h>
+	#if defined(_MSC_VER) && !defined(__clang__)
+		#include <intrin.h>
+		// MSVC emits AVX instructions for the intrinsics regardless of /arch
+		#define ENGINE_TARGET_AVX2
+	#else
+		#define ENGINE_TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#endif
+
+namespace
+{
+	// Everything one pass over the vertices can produce, unused outputs are null
+	struct VertexBatch
+	{
+		const Mat4* m_pMVP;
+		const Mat4* m_pMV;
+		const Vec3Stream* m_pPositions;
+		const Vec3Stream* m_pNormals;
+		Vec4* m_pClipPositions;
+		Vec4* m_pViewPositions;
+		Vec3Stream* m_pViewNormals;
+		size_t m_Count;
+	};
+
+	bool CpuSupportsAVX2()
+	{
+#if !ENGINE_SIMD_SSE
+		return false;
+#elif defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+
+		// The OS has to save the YMM registers on context switches too
+		__cpuid(info, 1);
+		const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		const bool hasAVX = (info[2] & (1 << 28)) != 0;
+		if (!osSavesYmm || !hasAVX) return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	void ProcessScalar(const VertexBatch& batch, size_t begin)
+	{
+		for (size_t i = begin; i < batch.m_Count; i++)
+		{
+			if (batch.m_pPositions)
+			{
+				const Vec4 position = batch.m_pPositions->Get(i);
+				if (batch.m_pClipPositions) batch.m_pClipPositions[i] = *batch.m_pMVP * position;
+				if (batch.m_pViewPositions) batch.m_pViewPositions[i] = *batch.m_pMV * position;
+			}
+			if (batch.m_pNormals)
+			{
+				const Vec3 normal = batch.m_pNormals->Get(i);
+				const Vec3 viewNormal = *batch.m_pMV * Vec4(normal.x, normal.y, normal.z, 0.0f);
+				batch.m_pViewNormals->Set(i, Vec3::Normalize(viewNormal));
+			}
+		}
+	}
+
+#if ENGINE_SIMD_SSE
+	// Row of a matrix with every element broadcast to all lanes
+	struct BroadcastRowSSE
+	{
+		__m128 m[4];
+
+		explicit BroadcastRowSSE(const float* pRow)
+		{
+			for (int i = 0; i < 4; i++) m[i] = _mm_set1_ps(pRow[i]);
+		}
+
+		// Same summation order as Mat4 * Vec4, so results agree with the scalar path
+		__m128 Direction(__m128 x, __m128 y, __m128 z) const
+		{
+			__m128 sum = _mm_mul_ps(m[0], x);
+			sum = _mm_add_ps(sum, _mm_mul_ps(m[1], y));
+			return _mm_add_ps(sum, _mm_mul_ps(m[2], z));
+		}
+		__m128 Point(__m128 x, __m128 y, __m128 z) const { return _mm_add_ps(Direction(x, y, z), m[3]); }
+	};
+
+	void StorePointsSSE(const BroadcastRowSSE* rows, __m128 x, __m128 y, __m128 z, Vec4* pOut)
+	{
+		__m128 outX = rows[0].Point(x, y, z);
+		__m128 outY = rows[1].Point(x, y, z);
+		__m128 outZ = rows[2].Point(x, y, z);
+		__m128 outW = rows[3].Point(x, y, z);
+
+		// Back to one vector per register
+		_MM_TRANSPOSE4_PS(outX, outY, outZ, outW);
+		pOut[0].Store(outX);
+		pOut[1].Store(outY);
+		pOut[2].Store(outZ);
+		pOut[3].Store(outW);
+	}
+
+	size_t ProcessSSE(const VertexBatch& batch, size_t begin)
+	{
+		const Mat4& mvpMatrix = batch.m_pMVP ? *batch.m_pMVP : Mat4::Identity();
+		const Mat4& mvMatrix = batch.m_pMV ? *batch.m_pMV : Mat4::Identity();
+		const BroadcastRowSSE mvp[4] = { BroadcastRowSSE(mvpMatrix[0]), BroadcastRowSSE(mvpMatrix[1]), BroadcastRowSSE(mvpMatrix[2]), BroadcastRowSSE(mvpMatrix[3]) };
+		const BroadcastRowSSE mv[4] = { BroadcastRowSSE(mvMatrix[0]), BroadcastRowSSE(mvMatrix[1]), BroadcastRowSSE(mvMatrix[2]), BroadcastRowSSE(mvMatrix[3]) };
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		size_t i = begin;
+		for (; i + 4 <= batch.m_Count; i += 4)
+		{
+			if (batch.m_pPositions)
+			{
+				const __m128 x = _mm_loadu_ps(batch.m_pPositions->GetX() + i);
+				const __m128 y = _mm_loadu_ps(batch.m_pPositions->GetY() + i);
+				const __m128 z = _mm_loadu_ps(batch.m_pPositions->GetZ() + i);
+
+				if (batch.m_pClipPositions) StorePointsSSE(mvp, x, y, z, batch.m_pClipPositions + i);
+				if (batch.m_pViewPositions) StorePointsSSE(mv, x, y, z, batch.m_pViewPositions + i);
+			}
+			if (batch.m_pNormals)
+			{
+				const __m128 x = _mm_loadu_ps(batch.m_pNormals->GetX() + i);
+				const __m128 y = _mm_loadu_ps(batch.m_pNormals->GetY() + i);
+				const __m128 z = _mm_loadu_ps(batch.m_pNormals->GetZ() + i);
+
+				const __m128 viewX = mv[0].Direction(x, y, z);
+				const __m128 viewY = mv[1].Direction(x, y, z);
+				const __m128 viewZ = mv[2].Direction(x, y, z);
+
+				// Divide instead of the approximate reciprocal, to match Vec3::Normalize
+				const __m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(viewX, viewX), _mm_mul_ps(viewY, viewY)), _mm_mul_ps(viewZ, viewZ));
+				const __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+
+				_mm_storeu_ps(batch.m_pViewNormals->GetX() + i, _mm_mul_ps(viewX, inverseLength));
+				_mm_storeu_ps(batch.m_pViewNormals->GetY() + i, _mm_mul_ps(viewY, inverseLength));
+				_mm_storeu_ps(batch.m_pViewNormals->GetZ() + i, _mm_mul_ps(viewZ, inverseLength));
+			}
+		}
+
+		return i;
+	}
+
+	struct BroadcastRowAVX2
+	{
+		__m256 m[4];
+
+		ENGINE_TARGET_AVX2 explicit BroadcastRowAVX2(const float* pRow)
+		{
+			for (int i = 0; i < 4; i++) m[i] = _mm256_set1_ps(pRow[i]);
+		}
+
+		ENGINE_TARGET_AVX2 __m256 Direction(__m256 x, __m256 y, __m256 z) const
+		{
+			__m256 sum = _mm256_mul_ps(m[0], x);
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(m[1], y));
+			return _mm256_add_ps(sum, _mm256_mul_ps(m[2], z));
+		}
+		ENGINE_TARGET_AVX2 __m256 Point(__m256 x, __m256 y, __m256 z) const { return _mm256_add_ps(Direction(x, y, z), m[3]); }
+	};
+
+	ENGINE_TARGET_AVX2 void StorePointsAVX2(const BroadcastRowAVX2* rows, __m256 x, __m256 y, __m256 z, Vec4* pOut)
+	{
+		const __m256 outX = rows[0].Point(x, y, z);
+		const __m256 outY = rows[1].Point(x, y, z);
+		const __m256 outZ = rows[2].Point(x, y, z);
+		const __m256 outW = rows[3].Point(x, y, z);
+
+		// 4x8 transpose, each 128 bit half ends up holding one vector
+		const __m256 xy0 = _mm256_unpacklo_ps(outX, outY);
+		const __m256 xy1 = _mm256_unpackhi_ps(outX, outY);
+		const __m256 zw0 = _mm256_unpacklo_ps(outZ, outW);
+		const __m256 zw1 = _mm256_unpackhi_ps(outZ, outW);
+		const __m256 v04 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 v15 = _mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2));
+		const __m256 v26 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 v37 = _mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2));
+
+		float* pDestination = &pOut[0].x;
+		_mm256_storeu_ps(pDestination + 0, _mm256_permute2f128_ps(v04, v15, 0x20));
+		_mm256_storeu_ps(pDestination + 8, _mm256_permute2f128_ps(v26, v37, 0x20));
+		_mm256_storeu_ps(pDestination + 16, _mm256_permute2f128_ps(v04, v15, 0x31));
+		_mm256_storeu_ps(pDestination + 24, _mm256_permute2f128_ps(v26, v37, 0x31));
+	}
+
+	ENGINE_TARGET_AVX2 size_t ProcessAVX2(const VertexBatch& batch, size_t begin)
+	{
+		const Mat4& mvpMatrix = batch.m_pMVP ? *batch.m_pMVP : Mat4::Identity();
+		const Mat4& mvMatrix = batch.m_pMV ? *batch.m_pMV : Mat4::Identity();
+		const BroadcastRowAVX2 mvp[4] = { BroadcastRowAVX2(mvpMatrix[0]), BroadcastRowAVX2(mvpMatrix[1]), BroadcastRowAVX2(mvpMatrix[2]), BroadcastRowAVX2(mvpMatrix[3]) };
+		const BroadcastRowAVX2 mv[4] = { BroadcastRowAVX2(mvMatrix[0]), BroadcastRowAVX2(mvMatrix[1]), BroadcastRowAVX2(mvMatrix[2]), BroadcastRowAVX2(mvMatrix[3]) };
+		const __m256 one = _mm256_set1_ps(1.0f);
+
+		size_t i = begin;
+		for (; i + 8 <= batch.m_Count; i += 8)
+		{
+			if (batch.m_pPositions)
+			{
+				const __m256 x = _mm256_loadu_ps(batch.m_pPositions->GetX() + i);
+				const __m256 y = _mm256_loadu_ps(batch.m_pPositions->GetY() + i);
+				const __m256 z = _mm256_loadu_ps(batch.m_pPositions->GetZ() + i);
+
+				if (batch.m_pClipPositions) StorePointsAVX2(mvp, x, y, z, batch.m_pClipPositions + i);
+				if (batch.m_pViewPositions) StorePointsAVX2(mv, x, y, z, batch.m_pViewPositions + i);
+			}
+			if (batch.m_pNormals)
+			{
+				const __m256 x = _mm256_loadu_ps(batch.m_pNormals->GetX() + i);
+				const __m256 y = _mm256_loadu_ps(batch.m_pNormals->GetY() + i);
+				const __m256 z = _mm256_loadu_ps(batch.m_pNormals->GetZ() + i);
+
+				const __m256 viewX = mv[0].Direction(x, y, z);
+				const __m256 viewY = mv[1].Direction(x, y, z);
+				const __m256 viewZ = mv[2].Direction(x, y, z);
+
+				const __m256 lengthSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(viewX, viewX), _mm256_mul_ps(viewY, viewY)), _mm256_mul_ps(viewZ, viewZ));
+				const __m256 inverseLength = _mm256_div_ps(one, _mm256_sqrt_ps(lengthSquared));
+
+				_mm256_storeu_ps(batch.m_pViewNormals->GetX() + i, _mm256_mul_ps(viewX, inverseLength));
+				_mm256_storeu_ps(batch.m_pViewNormals->GetY() + i, _mm256_mul_ps(viewY, inverseLength));
+				_mm256_storeu_ps(batch.m_pViewNormals->GetZ() + i, _mm256_mul_ps(viewZ, inverseLength));
+			}
+		}
+
+		// Leave the upper halves of the YMM registers clean for SSE code that follows
+		_mm256_zeroupper();
+		return i;
+	}
+#endif
+
+	// Runs the widest enabled kernel, the remainder goes to the narrower ones
+	void Process(const VertexBatch& batch, TransformKernels::InstructionSet instructionSet)
+	{
+		size_t done = 0u;
+#if ENGINE_SIMD_SSE
+		if (instructionSet == TransformKernels::InstructionSet::AVX2) done = ProcessAVX2(batch, done);
+		if (instructionSet != TransformKernels::InstructionSet::Scalar) done = ProcessSSE(batch, done);
+#endif
+		ProcessScalar(batch, done);
+	}
+}
+
+TransformKernels::InstructionSet TransformKernels::s_InstructionSet = TransformKernels::GetSupportedInstructionSet();
+
+TransformKernels::InstructionSet TransformKernels::GetSupportedInstructionSet()
+{
+	static const InstructionSet supported =
+		CpuSupportsAVX2() ? InstructionSet::AVX2 :
+		ENGINE_SIMD_SSE ? InstructionSet::SSE :
+		InstructionSet::Scalar;
+
+	return supported;
+}
+
+TransformKernels::InstructionSet TransformKernels::SetInstructionSet(InstructionSet instructionSet)
+{
+	s_InstructionSet = instructionSet <= GetSupportedInstructionSet() ? instructionSet : GetSupportedInstructionSet();
+	return s_InstructionSet;
+}
+
+const char* TransformKernels::GetName(InstructionSet instructionSet)
+{
+	switch (instructionSet)
+	{
+	case InstructionSet::SSE: return "SSE";
+	case InstructionSet::AVX2: return "AVX2";
+	default: return "Scalar";
+	}
+}
+
+void TransformKernels::TransformPoints(const Mat4& transform, const Vec3Stream& points, Vec4* pOut)
+{
+	Process({ &transform, nullptr, &points, nullptr, pOut, nullptr, nullptr, points.GetSize() }, s_InstructionSet);
+}
+
+void TransformKernels::TransformNormals(const Mat4& transform, const Vec3Stream& normals, Vec3Stream& out)
+{
+	out.Resize(normals.GetSize());
+	Process({ nullptr, &transform, nullptr, &normals, nullptr, nullptr, &out, normals.GetSize() }, s_InstructionSet);
+}
+
+void TransformKernels::TransformVertices(
+	const Mat4& mvp, const Mat4& mv,
+	const Vec3Stream& positions, const Vec3Stream& normals,
+	Vec4* pClipPositions, Vec4* pViewPositions, Vec3Stream& viewNormals)
+{
+	assert(positions.GetSize() == normals.GetSize());
+
+	viewNormals.Resize(normals.GetSize());
+	Process({ &mvp, &mv, &positions, &normals, pClipPositions, pViewPositions, &viewNormals, positions.GetSize() }, s_InstructionSet);
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+
+#include "Vec3.h"
+#include "Vec4.h"
+#include "Mat4.h"
+
+// Structure of arrays stream of 3 component vectors, every component is stored contiguously
+// so the kernels can load the same component of several vectors at once.
+class Vec3Stream
+{
+public:
+	size_t GetSize() const { return m_X.size(); }
+
+	void Resize(size_t size)
+	{
+		m_X.resize(size);
+		m_Y.resize(size);
+		m_Z.resize(size);
+	}
+
+	void Set(size_t i, const Vec3& value)
+	{
+		m_X[i] = value.x;
+		m_Y[i] = value.y;
+		m_Z[i] = value.z;
+	}
+	Vec3 Get(size_t i) const { return { m_X[i], m_Y[i], m_Z[i] }; }
+
+	const float* GetX() const { return m_X.data(); }
+	const float* GetY() const { return m_Y.data(); }
+	const float* GetZ() const { return m_Z.data(); }
+
+	float* GetX() { return m_X.data(); }
+	float* GetY() { return m_Y.data(); }
+	float* GetZ() { return m_Z.data(); }
+
+private:
+	std::vector<float> m_X;
+	std::vector<float> m_Y;
+	std::vector<float> m_Z;
+};
+
+// Batched transforms over vertex streams.
+// Every kernel has a scalar, an SSE (4 vertices per step) and an AVX2 (8 vertices per step) variant,
+// the widest one the CPU supports is picked on first use. Results match Mat4 * Vec4 up to rounding.
+class TransformKernels
+{
+public:
+	enum class InstructionSet
+	{
+		Scalar,
+		SSE,
+		AVX2
+	};
+
+	static InstructionSet GetSupportedInstructionSet();
+	static InstructionSet GetInstructionSet() { return s_InstructionSet; }
+	// Clamped to what the CPU supports, returns the instruction set that is used from now on
+	static InstructionSet SetInstructionSet(InstructionSet instructionSet);
+	static const char* GetName(InstructionSet instructionSet);
+
+	// Points get w = 1
+	static void TransformPoints(const Mat4& transform, const Vec3Stream& points, Vec4* pOut);
+	// Directions get w = 0 and are normalized after the transform
+	static void TransformNormals(const Mat4& transform, const Vec3Stream& normals, Vec3Stream& out);
+
+	// Positions by MVP and MV plus normals by MV in a single pass, the usual vertex shader workload
+	static void TransformVertices(
+		const Mat4& mvp, const Mat4& mv,
+		const Vec3Stream& positions, const Vec3Stream& normals,
+		Vec4* pClipPositions, Vec4* pViewPositions, Vec3Stream& viewNormals);
+
+private:
+	static InstructionSet s_InstructionSet;
+};
\ No newline at end of file
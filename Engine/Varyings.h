@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
+#include "Vec2.h"
+#include "Vec3.h"
+#include "Vec4.h"
+
+// Values a vertex shader can hand over to the pixel shader, interpolated across the triangle
+enum class Varying
+{
+	ViewPosition,
+	Normal,
+	UvCoordinates
+};
+
+template <Varying TVarying> struct VaryingType;
+template <> struct VaryingType<Varying::ViewPosition> { typedef Vec3 Type; };
+template <> struct VaryingType<Varying::Normal> { typedef Vec3 Type; };
+template <> struct VaryingType<Varying::UvCoordinates> { typedef Vec2 Type; };
+
+// Flattening of the vector types into consecutive floats
+inline float* WriteComponents(const Vec2& value, float* pOut) { pOut[0] = value.x; pOut[1] = value.y; return pOut + 2; }
+inline float* WriteComponents(const Vec3& value, float* pOut) { pOut[0] = value.x; pOut[1] = value.y; pOut[2] = value.z; return pOut + 3; }
+inline float* WriteComponents(const Vec4& value, float* pOut) { pOut[0] = value.x; pOut[1] = value.y; pOut[2] = value.z; pOut[3] = value.w; return pOut + 4; }
+inline const float* ReadComponents(Vec2& value, const float* pIn) { value = Vec2(pIn[0], pIn[1]); return pIn + 2; }
+inline const float* ReadComponents(Vec3& value, const float* pIn) { value = Vec3(pIn[0], pIn[1], pIn[2]); return pIn + 3; }
+inline const float* ReadComponents(Vec4& value, const float* pIn) { value = Vec4(pIn[0], pIn[1], pIn[2], pIn[3]); return pIn + 4; }
+
+// Vertex shader output made of the clip space position and exactly the varyings listed.
+// Shader programs use it as their VSOut and list only what their pixel shader reads, so edge and span
+// interpolation, clipping lerps and the perspective divide in GraphicsPipeline never touch anything else.
+template <Varying... TVaryings>
+struct VaryingVertex
+{
+	Vec4 m_Position;
+	std::tuple<typename VaryingType<TVaryings>::Type...> m_Values;
+
+	VaryingVertex() = default;
+	VaryingVertex(const Vec4& position)
+		:
+		m_Position(position)
+	{
+	}
+
+	static constexpr bool Contains(Varying varying) { return ((varying == TVaryings) || ...); }
+
+	// Position followed by the varyings as one flat list of floats, the form triangle setup builds plane equations for
+	static constexpr size_t ComponentCount = (sizeof(Vec4) + ... + sizeof(typename VaryingType<TVaryings>::Type)) / sizeof(float);
+	static constexpr size_t PositionZ = 2u;
+	static constexpr size_t PositionW = 3u;
+
+	void ToComponents(float* pComponents) const
+	{
+		pComponents = WriteComponents(m_Position, pComponents);
+		std::apply([&pComponents](const auto&... values) { ((pComponents = WriteComponents(values, pComponents)), ...); }, m_Values);
+	}
+	void FromComponents(const float* pComponents)
+	{
+		pComponents = ReadComponents(m_Position, pComponents);
+		std::apply([&pComponents](auto&... values) { ((pComponents = ReadComponents(values, pComponents)), ...); }, m_Values);
+	}
+
+	template <Varying TVarying> static constexpr size_t IndexOf()
+	{
+		constexpr Varying varyings[] = { TVaryings..., TVarying };
+		size_t index = 0u;
+		while (varyings[index] != TVarying) index++;
+		return index;
+	}
+
+	friend VaryingVertex operator+(const VaryingVertex& lhs, const VaryingVertex& rhs)
+	{
+		return Combine(lhs, rhs, [](const auto& a, const auto& b) { return a + b; }, Indices());
+	}
+	VaryingVertex& operator+=(const VaryingVertex& rhs) { return *this = *this + rhs; }
+
+	friend VaryingVertex operator-(const VaryingVertex& lhs, const VaryingVertex& rhs)
+	{
+		return Combine(lhs, rhs, [](const auto& a, const auto& b) { return a - b; }, Indices());
+	}
+	VaryingVertex& operator-=(const VaryingVertex& rhs) { return *this = *this - rhs; }
+
+	template <typename T> friend VaryingVertex operator*(const VaryingVertex& lhs, T rhs)
+	{
+		return Combine(lhs, lhs, [rhs](const auto& a, const auto&) { return a * rhs; }, Indices());
+	}
+	template <typename T> friend VaryingVertex operator*(T lhs, const VaryingVertex& rhs) { return rhs * lhs; }
+	template <typename T> VaryingVertex& operator*=(T rhs) { return *this = *this * rhs; }
+
+	template <typename T> friend VaryingVertex operator/(const VaryingVertex& lhs, T rhs) { return lhs * (1.0f / rhs); }
+	template <typename T> VaryingVertex& operator/=(T rhs) { return *this = *this / rhs; }
+
+	template <typename T> static VaryingVertex Lerp(VaryingVertex v1, VaryingVertex v2, T t) { return v1 + (v2 - v1) * t; }
+
+private:
+	typedef std::index_sequence_for<typename VaryingType<TVaryings>::Type...> Indices;
+
+	// Applies the operation to the position and every listed varying, the fold unrolls at compile time
+	template <typename TOperation, size_t... TIndices>
+	static VaryingVertex Combine(const VaryingVertex& lhs, const VaryingVertex& rhs, TOperation operation, std::index_sequence<TIndices...>)
+	{
+		VaryingVertex result;
+		result.m_Position = operation(lhs.m_Position, rhs.m_Position);
+		((std::get<TIndices>(result.m_Values) = operation(std::get<TIndices>(lhs.m_Values), std::get<TIndices>(rhs.m_Values))), ...);
+
+		return result;
+	}
+};
+
+template <Varying TVarying, Varying... TVaryings>
+typename VaryingType<TVarying>::Type& GetVarying(VaryingVertex<TVaryings...>& vertex)
+{
+	return std::get<VaryingVertex<TVaryings...>::template IndexOf<TVarying>()>(vertex.m_Values);
+}
+
+template <Varying TVarying, Varying... TVaryings>
+const typename VaryingType<TVarying>::Type& GetVarying(const VaryingVertex<TVaryings...>& vertex)
+{
+	return std::get<VaryingVertex<TVaryings...>::template IndexOf<TVarying>()>(vertex.m_Values);
+}
+
+// Writes the varying if the vertex carries it, so vertex shaders can fill every output unconditionally
+template <Varying TVarying, Varying... TVaryings>
+void SetVarying(VaryingVertex<TVaryings...>& vertex, const typename VaryingType<TVarying>::Type& value)
+{
+	if constexpr (VaryingVertex<TVaryings...>::Contains(TVarying))
+	{
+		GetVarying<TVarying>(vertex) = value;
+	}
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cmath>
+
 template <typename T>
 class _Vec2
 {
@@ -34,7 +36,7 @@ public:
 	}
 	_Vec2& operator-=(const _Vec2& rhs) { return *this = *this - rhs; }
 
-	_Vec2 operator-() { return { -x, -y }; }
+	_Vec2 operator-() const { return { -x, -y }; }
 
 	friend _Vec2 operator*(T lhs, const _Vec2& rhs) { return _Vec2(lhs * rhs.x, lhs * rhs.y); }
 	friend _Vec2 operator*(const _Vec2& lhs, T rhs) { return rhs * lhs; }
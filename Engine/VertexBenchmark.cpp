@@ -0,0 +1,91 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "VertexBenchmark.h"
+#include "Benchmarking.h"
+#include "DepthOnlyShaderProgram.h"
+#include "GraphicsPipeline.h"
+#include "JobSystem.h"
+
+std::string VertexBenchmark::Run(Graphics& graphics, int rings, int segments, int repetitions)
+{
+	using namespace Benchmarking;
+
+	// Unit sphere, a vertex per ring and segment crossing and two triangles per quad between them
+	std::vector<Vec3> vertices;
+	std::vector<size_t> indices;
+	for (int ring = 0; ring <= rings; ring++)
+	{
+		const float theta = static_cast<float>(M_PI) * ring / rings;
+		for (int segment = 0; segment <= segments; segment++)
+		{
+			const float phi = 2.0f * static_cast<float>(M_PI) * segment / segments;
+			vertices.emplace_back(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+		}
+	}
+	for (int ring = 0; ring < rings; ring++)
+	{
+		for (int segment = 0; segment < segments; segment++)
+		{
+			const size_t first = static_cast<size_t>(ring) * (segments + 1) + segment;
+			const size_t below = first + segments + 1;
+			indices.insert(indices.end(), { first, below, first + 1, first + 1, below, below + 1 });
+		}
+	}
+
+	const int coreCount = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	std::ostringstream report;
+	report << "Vertex benchmark, " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles, "
+		<< coreCount << " cores, best of " << repetitions << " runs\n";
+
+	GraphicsPipeline<DepthOnlyShaderProgram> pipeline(graphics, 512, 512);
+	pipeline.BindVertices(vertices);
+	pipeline.BindIndices(indices);
+
+	const Mat4 projection = Mat4::PerspectiveProjection(0.1f, 100.0f, 1.57f, 1.0f);
+	const struct
+	{
+		const char* m_Name;
+		Mat4 m_View;
+	} cases[] =
+	{
+		{ "in view", Mat4::Translate(0.0f, 0.0f, -3.0f) },
+		{ "culled", Mat4::Translate(0.0f, 0.0f, 3.0f) }
+	};
+
+	for (const auto& drawCase : cases)
+	{
+		pipeline.GetVertexShader().SetMVP(projection * drawCase.m_View);
+
+		auto measure = [&](JobSystem* pJobs)
+		{
+			pipeline.SetJobSystem(pJobs);
+			return MeasureNanoseconds(repetitions, 1, [&]()
+			{
+				pipeline.ClearZBuffer();
+				pipeline.Draw();
+			}) / 1.0e6;
+		};
+
+		const double serial = measure(nullptr);
+		report << "  " << drawCase.m_Name << "\n";
+		report << "    no job system   " << std::fixed << std::setprecision(2) << std::setw(8) << serial << " ms\n";
+		AddResult(std::string(drawCase.m_Name) + " ms, no job system", serial, "ms");
+
+		for (int workerCount = 0; workerCount < coreCount; workerCount++)
+		{
+			JobSystem jobs(workerCount);
+			const double parallel = measure(&jobs);
+			report << "    " << std::setw(2) << workerCount + 1 << " threads      " << std::setw(8) << parallel << " ms  x" << serial / parallel << "\n";
+			AddResult(std::string(drawCase.m_Name) + " ms, threads " + std::to_string(workerCount + 1), parallel, "ms");
+		}
+		pipeline.SetJobSystem(nullptr);
+	}
+
+	return report.str();
+}
\ No newline at end of file
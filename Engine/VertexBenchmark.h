@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+
+class Graphics;
+
+// Scaling of the vertex stage over the job system. Draws a synthetic sphere of about 2 * rings * segments triangles
+// through the depth only pipeline, once in view and once behind the camera (every triangle culled, so only
+// vertex shading and triangle assembly are left), without a job system and then with every worker count up to the cores.
+// Part of BenchmarkSuite, where every time is also a result.
+class VertexBenchmark
+{
+public:
+	static std::string Run(Graphics& graphics, int rings = 512, int segments = 1024, int repetitions = 5);
+};
\ No newline at end of file
@@ -1,2 +1,9 @@
+#include "AllocationTracker.h"
+
+// Decoded images are counted like everything else, and charged to the tag of whoever loads them
+#define STBI_MALLOC(bytes) AllocationTracker::Allocate(bytes)
+#define STBI_REALLOC(pMemory, bytes) AllocationTracker::Reallocate(pMemory, bytes)
+#define STBI_FREE(pMemory) AllocationTracker::Free(pMemory)
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
\ No newline at end of file
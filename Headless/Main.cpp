@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "BenchmarkSuite.h"
+#include "DrawReplay.h"
+#include "Graphics.h"
+#include "JobSystem.h"
+
+namespace
+{
+	constexpr const char* Usage =
+		"Usage: EngineHeadless -replay <capture> [repetitions] [-threads <workers>]\n"
+		"       EngineHeadless -benchmark <results.json> [-baseline <results.json>] [-threads <workers>]\n";
+}
+
+// The runs the windowed build starts from its command line, without a window or Windows:
+//   -replay <capture> [repetitions] draws the capture, see DrawReplay
+//   -benchmark <results.json> [-baseline <results.json>] runs the benchmark suite, see BenchmarkSuite
+// Relative paths, the assets among them, are taken from the working directory, so run it from Engine/ like the windowed build.
+int main(int argc, char* argv[])
+{
+	std::string replayPath;
+	int replayRepetitions = 10;
+	std::string benchmarkPath;
+	std::string benchmarkBaselinePath;
+	int workerCount = ThreadPool::DefaultThreadCount();
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+		if (arg == "-replay" && i + 1 < argc)
+		{
+			replayPath = argv[++i];
+			if (i + 1 < argc && std::atoi(argv[i + 1]) > 0) replayRepetitions = std::atoi(argv[++i]);
+		}
+		else if (arg == "-benchmark" && i + 1 < argc)
+		{
+			benchmarkPath = argv[++i];
+		}
+		else if (arg == "-baseline" && i + 1 < argc)
+		{
+			benchmarkBaselinePath = argv[++i];
+		}
+		else if (arg == "-threads" && i + 1 < argc)
+		{
+			workerCount = std::max(std::atoi(argv[++i]), 0);
+		}
+		else
+		{
+			std::cerr << "Unknown argument " << arg << "\n" << Usage;
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (replayPath.empty() == benchmarkPath.empty())
+	{
+		std::cerr << Usage;
+		return EXIT_FAILURE;
+	}
+
+	Graphics graphics;
+	JobSystem jobs(workerCount);
+
+	if (!benchmarkPath.empty())
+	{
+		// Pipelines draw into the frame like the scene does
+		graphics.BeginFrame();
+		const std::vector<Benchmarking::Result> results = BenchmarkSuite::Run(graphics, jobs);
+		graphics.EndFrame();
+
+		std::cout << BenchmarkSuite::Save(results, benchmarkPath, benchmarkBaselinePath);
+		return EXIT_SUCCESS;
+	}
+
+	const std::string report = DrawReplay::Run(graphics, jobs, replayPath, replayRepetitions);
+	std::cout << report;
+	std::ofstream(replayPath + ".txt") << report;
+
+	return EXIT_SUCCESS;
+}
\ No newline at end of file